@@ -0,0 +1,309 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "../src/positioning.h"
+#include "../src/beacon_config.h"
+
+// Monte-Carlo accuracy of positioning_from_angles over the table
+//
+// every cell of a GRID_STEP grid over the 3 x 2 [m] table gets 'samples'
+// fixes from its center, the bearing of every beacon seen from there with a
+// gaussian noise of standard deviation 'noise' [rad]. the angles come from
+// the noisy bearings, like the firmware gets them from the edge times, so
+// they still sum to 2 Pi. the error of a fix is its distance to the center
+// of the cell, fixes positioning_from_angles doesn't trust aren't counted.
+//
+// the rows of the grid are spread over 'threads' threads, every cell has
+// its own random stream so the statistics don't depend on the number of
+// threads. ns/call is the CPU time of the calling thread per call, so it
+// doesn't count the time a thread waits for a core when there are more
+// threads than cores (which only slows the sweep down, -j warns about it).
+//
+// usage: accuracy_benchmark [-n noise [rad]] [-s samples per cell]
+//                           [-j threads] [-o error map] [-g max error [m]]
+// -o writes "x y rms_err mean_err max_err valid" per cell, rows separated by
+//    an empty line (gnuplot pm3d), the data of a map like
+//    doc/error_color_map_log.png
+// -g exits with 1 if the median of the rms error of the cells is above,
+//    to catch a regression of src/positioning.c
+
+#define GRID_STEP       (0.01)      // [m]
+#define GRID_SIZE_X     (300)       // 3 [m]
+#define GRID_SIZE_Y     (200)       // 2 [m]
+#define DEFAULT_NOISE   (0.001)     // [rad]
+#define DEFAULT_SAMPLES (100)       // per cell
+#define BATCH_SIZE      (256)       // fixes timed at once
+
+typedef struct {
+    float rms_err;                  // [m]
+    float mean_err;                 // [m]
+    float max_err;                  // [m]
+    float valid;                    // fraction of trusted fixes
+} cell_stats_t;
+
+typedef struct {
+    int index;
+    int nb_threads;
+    double ns;                      // CPU time in positioning_from_angles
+    uint64_t nb_calls;
+} worker_t;
+
+typedef struct {
+    float alpha;
+    float beta;
+    float gamma;
+} sample_t;
+
+static const position_t beacons[3] = {BEACON_POS_A, BEACON_POS_B, BEACON_POS_C};
+static reference_triangle_t table = {NULL, NULL, NULL, 0, 0, 0};
+
+static double noise = DEFAULT_NOISE;
+static int nb_samples = DEFAULT_SAMPLES;
+static cell_stats_t cells[GRID_SIZE_Y][GRID_SIZE_X];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// CPU time of the calling thread [ns]
+static double thread_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// deterministic xorshift, seeded per cell
+static double uniform(uint32_t * state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state >> 8) * (1.0 / 16777216.0);
+}
+
+static double gaussian(uint32_t * state)
+{
+    double u = uniform(state);
+    if(u < 1e-7) {
+        u = 1e-7;
+    }
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * uniform(state));
+}
+
+// directed angle between two bearings, in [0, 2 Pi)
+static double directed_angle(double from, double to)
+{
+    double angle = fmod(to - from, 2 * M_PI);
+
+    return angle < 0 ? angle + 2 * M_PI : angle;
+}
+
+static void cell_run(int i, int j, worker_t * worker)
+{
+    sample_t samples[BATCH_SIZE];
+    double x = (i + 0.5) * GRID_STEP;
+    double y = (j + 0.5) * GRID_STEP;
+    double bearing[3];
+    double sum_sq = 0.0, sum = 0.0, max = 0.0;
+    uint32_t rng_state = 2463534242u ^ (uint32_t)(j * GRID_SIZE_X + i + 1)
+        * 2654435761u;
+    int nb_valid = 0;
+    int done, k, n;
+
+    for(k = 0; k < 3; k++) {
+        bearing[k] = atan2(beacons[k].y - y, beacons[k].x - x);
+    }
+
+    for(done = 0; done < nb_samples; done += n) {
+        n = nb_samples - done < BATCH_SIZE ? nb_samples - done : BATCH_SIZE;
+
+        for(k = 0; k < n; k++) {
+            double a = bearing[0] + noise * gaussian(&rng_state);
+            double b = bearing[1] + noise * gaussian(&rng_state);
+            double c = bearing[2] + noise * gaussian(&rng_state);
+            samples[k].alpha = directed_angle(b, c);
+            samples[k].beta = directed_angle(c, a);
+            samples[k].gamma = directed_angle(a, b);
+        }
+
+        position_t out[BATCH_SIZE];
+        uint8_t valid[BATCH_SIZE];
+        double start = thread_ns();
+        for(k = 0; k < n; k++) {
+            valid[k] = positioning_from_angles(samples[k].alpha,
+                    samples[k].beta, samples[k].gamma, &table, &out[k]);
+        }
+        worker->ns += thread_ns() - start;
+        worker->nb_calls += n;
+
+        for(k = 0; k < n; k++) {
+            if(!valid[k]) {
+                continue;
+            }
+            double err = hypot(out[k].x - x, out[k].y - y);
+            nb_valid++;
+            sum += err;
+            sum_sq += err * err;
+            max = err > max ? err : max;
+        }
+    }
+
+    cell_stats_t * s = &cells[j][i];
+    s->valid = (float)nb_valid / nb_samples;
+    s->rms_err = nb_valid > 0 ? sqrt(sum_sq / nb_valid) : NAN;
+    s->mean_err = nb_valid > 0 ? sum / nb_valid : NAN;
+    s->max_err = nb_valid > 0 ? max : NAN;
+}
+
+static void * worker_main(void * context)
+{
+    worker_t * worker = (worker_t *)context;
+    int i, j;
+
+    for(j = worker->index; j < GRID_SIZE_Y; j += worker->nb_threads) {
+        for(i = 0; i < GRID_SIZE_X; i++) {
+            cell_run(i, j, worker);
+        }
+    }
+
+    return NULL;
+}
+
+static int compare_float(const void * a, const void * b)
+{
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+
+    return (fa > fb) - (fa < fb);
+}
+
+static int write_map(const char * path)
+{
+    FILE * f = fopen(path, "w");
+    int i, j;
+
+    if(f == NULL) {
+        perror(path);
+        return 0;
+    }
+
+    fprintf(f, "# x [m] y [m] rms_err mean_err max_err [m] valid\n");
+    for(j = 0; j < GRID_SIZE_Y; j++) {
+        for(i = 0; i < GRID_SIZE_X; i++) {
+            const cell_stats_t * s = &cells[j][i];
+            fprintf(f, "%.3f %.3f %.6g %.6g %.6g %.4f\n",
+                    (i + 0.5) * GRID_STEP, (j + 0.5) * GRID_STEP,
+                    s->rms_err, s->mean_err, s->max_err, s->valid);
+        }
+        fprintf(f, "\n");
+    }
+
+    return fclose(f) == 0;
+}
+
+int main(int argc, char ** argv)
+{
+    static float rms[GRID_SIZE_X * GRID_SIZE_Y];
+    const char * map_path = NULL;
+    double gate = 0.0;
+    int nb_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int nb_threads = nb_cores > 0 ? nb_cores : 1;
+    int nb_cells = 0;
+    double nb_valid = 0.0;
+    int opt, i, j;
+
+    while((opt = getopt(argc, argv, "n:s:j:o:g:")) != -1) {
+        switch(opt) {
+            case 'n': noise = atof(optarg); break;
+            case 's': nb_samples = atoi(optarg); break;
+            case 'j': nb_threads = atoi(optarg); break;
+            case 'o': map_path = optarg; break;
+            case 'g': gate = atof(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n noise [rad]] [-s samples per "
+                        "cell] [-j threads] [-o error map] [-g max error [m]]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if(noise < 0 || nb_samples < 1 || nb_threads < 1) {
+        fprintf(stderr, "noise >= 0, at least 1 sample and 1 thread\n");
+        return 2;
+    }
+    if(nb_cores > 0 && nb_threads > nb_cores) {
+        fprintf(stderr, "warning: %d threads on %d cores, the threads take "
+                "turns\n", nb_threads, nb_cores);
+    }
+
+    positioning_reference_triangle_from_points(
+            &beacons[0], &beacons[1], &beacons[2], &table);
+
+    worker_t * workers = calloc(nb_threads, sizeof(worker_t));
+    pthread_t * threads = calloc(nb_threads, sizeof(pthread_t));
+    if(workers == NULL || threads == NULL) {
+        return 2;
+    }
+
+    double start = now_ns();
+    for(i = 0; i < nb_threads; i++) {
+        workers[i].index = i;
+        workers[i].nb_threads = nb_threads;
+        pthread_create(&threads[i], NULL, worker_main, &workers[i]);
+    }
+    double ns = 0.0;
+    uint64_t nb_calls = 0;
+    for(i = 0; i < nb_threads; i++) {
+        pthread_join(threads[i], NULL);
+        ns += workers[i].ns;
+        nb_calls += workers[i].nb_calls;
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    for(j = 0; j < GRID_SIZE_Y; j++) {
+        for(i = 0; i < GRID_SIZE_X; i++) {
+            nb_valid += cells[j][i].valid;
+            if(!isnan(cells[j][i].rms_err)) {
+                rms[nb_cells++] = cells[j][i].rms_err;
+            }
+        }
+    }
+    qsort(rms, nb_cells, sizeof(rms[0]), compare_float);
+    float median = nb_cells > 0 ? rms[nb_cells / 2] : NAN;
+
+    printf("positioning_from_angles, %d x %d cells of %g [m], %d samples "
+            "per cell, noise %g [rad]\n", GRID_SIZE_X, GRID_SIZE_Y, GRID_STEP,
+            nb_samples, noise);
+    printf("%.3g samples in %.2f [s] on %d threads, %.1f [ns/call], "
+            "%.3g calls/s\n", (double)nb_calls, elapsed, nb_threads,
+            ns / nb_calls, nb_calls / elapsed);
+    printf("trusted fixes %.2f %%, %d cells without any\n",
+            100.0 * nb_valid / (GRID_SIZE_X * GRID_SIZE_Y),
+            GRID_SIZE_X * GRID_SIZE_Y - nb_cells);
+    printf("%-10s %12s %12s %12s %12s\n",
+            "rms err", "median", "p90", "p99", "max");
+    printf("%-10s %12.4g %12.4g %12.4g %12.4g\n", "[m]", median,
+            nb_cells > 0 ? rms[nb_cells * 9 / 10] : NAN,
+            nb_cells > 0 ? rms[nb_cells * 99 / 100] : NAN,
+            nb_cells > 0 ? rms[nb_cells - 1] : NAN);
+
+    if(map_path != NULL && !write_map(map_path)) {
+        return 2;
+    }
+
+    if(gate > 0.0 && !(median <= gate)) {
+        printf("median rms error above %g [m]\n", gate);
+        return 1;
+    }
+
+    return 0;
+}
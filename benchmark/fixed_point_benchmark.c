@@ -0,0 +1,311 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "../src/positioning.h"
+#include "../src/positioning_q.h"
+#include "../src/kalman.h"
+#include "../src/kalman_q.h"
+#include "../src/beacon_config.h"
+
+// compares the fixed-point build (BEACON_FIXED_POINT) with the float one
+//
+// positioning: every point of a GRID_STEP grid over the table, error of
+//              positioning_from_angles and positioning_q_from_angles
+//              against the true position
+// kalman:      kalman_update and kalman_q_update on the same NB_STEPS
+//              synthetic steps, distance between both estimates
+//
+// timing: average ns (and TSC cycles on x86) per call, host figures only
+// give the ratio between both builds, not the cost on the target
+
+#define GRID_STEP       (0.01)      // [m]
+#define GRID_SIZE_X     (300)       // 3 [m]
+#define GRID_SIZE_Y     (200)       // 2 [m]
+#define NB_STEPS        (1000000)
+#define MIN_DELTA_T     (0.002f)    // [s]
+#define MAX_DELTA_T     (0.1f)      // [s]
+#define MISSING_MEAS    (0.1f)      // fraction of missing measurements
+
+typedef struct {
+    float x;
+    float y;
+    float delta_t;
+    uint8_t valid;
+} step_t;
+
+typedef struct {
+    double x;
+    double y;
+    float alpha;
+    float beta;
+    float gamma;
+} sample_t;
+
+static const position_t p_a = {3.0f, 1.0f};
+static const position_t p_b = {0.0f, 2.0f};
+static const position_t p_c = {0.0f, 0.0f};
+
+static step_t steps[NB_STEPS];
+static sample_t samples[GRID_SIZE_X * GRID_SIZE_Y];
+
+// deterministic xorshift
+static uint32_t rng_state = 2463534242u;
+
+static float uniform(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (rng_state >> 8) * (1.0f / 16777216.0f);
+}
+
+static float gaussian(void)
+{
+    float u = uniform();
+    if(u < 1e-7f) {
+        u = 1e-7f;
+    }
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * (float)M_PI * uniform());
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// directed angle at (x, y) from first to second, in [0, 2 Pi)
+static double directed_angle(
+        double x,
+        double y,
+        const position_t * first,
+        const position_t * second)
+{
+    double angle = atan2(second->y - y, second->x - x)
+        - atan2(first->y - y, first->x - x);
+
+    return angle < 0 ? angle + 2 * M_PI : angle;
+}
+
+static position_q_t to_q(const position_t * p)
+{
+    position_q_t q = {Q8_24_FROM_FLOAT(p->x), Q8_24_FROM_FLOAT(p->y)};
+    return q;
+}
+
+static int generate_samples(void)
+{
+    int nb_samples = 0;
+    int i, j;
+
+    for(i = 1; i < GRID_SIZE_X; i++) {
+        for(j = 1; j < GRID_SIZE_Y; j++) {
+            sample_t * s = &samples[nb_samples++];
+            s->x = i * GRID_STEP;
+            s->y = j * GRID_STEP;
+            s->alpha = directed_angle(s->x, s->y, &p_b, &p_c);
+            s->beta = directed_angle(s->x, s->y, &p_c, &p_a);
+            s->gamma = directed_angle(s->x, s->y, &p_a, &p_b);
+        }
+    }
+
+    return nb_samples;
+}
+
+static void positioning_benchmark(void)
+{
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    reference_triangle_q_t t_q;
+    position_q_t a_q = to_q(&p_a);
+    position_q_t b_q = to_q(&p_b);
+    position_q_t c_q = to_q(&p_c);
+    static angle_q_t angles_q[GRID_SIZE_X * GRID_SIZE_Y][3];
+    int nb_samples = generate_samples();
+    int nb_valid = 0;
+    double max_err = 0.0, max_err_q = 0.0;
+    double sum_err = 0.0, sum_err_q = 0.0;
+    double checksum = 0.0;
+    int i;
+
+    positioning_reference_triangle_from_points(&p_a, &p_b, &p_c, &t);
+    positioning_q_reference_triangle_from_points(&a_q, &b_q, &c_q, &t_q);
+
+    for(i = 0; i < nb_samples; i++) {
+        angles_q[i][0] = ANGLE_Q_FROM_RAD(samples[i].alpha);
+        angles_q[i][1] = ANGLE_Q_FROM_RAD(samples[i].beta);
+        angles_q[i][2] = ANGLE_Q_FROM_RAD(samples[i].gamma);
+    }
+
+    // accuracy, only on the points the float version trusts
+    for(i = 0; i < nb_samples; i++) {
+        const sample_t * s = &samples[i];
+        position_t out = {0, 0};
+        position_q_t out_q;
+
+        if(!positioning_from_angles(s->alpha, s->beta, s->gamma, &t, &out)) {
+            continue;
+        }
+        positioning_q_from_angles(
+                angles_q[i][0], angles_q[i][1], angles_q[i][2], &t_q, &out_q);
+
+        double err = hypot(out.x - s->x, out.y - s->y);
+        double err_q = hypot(
+                Q8_24_TO_FLOAT(out_q.x) - s->x, Q8_24_TO_FLOAT(out_q.y) - s->y);
+
+        nb_valid++;
+        sum_err += err;
+        sum_err_q += err_q;
+        max_err = err > max_err ? err : max_err;
+        max_err_q = err_q > max_err_q ? err_q : max_err_q;
+    }
+
+    // timing
+    double start = now_ns();
+    uint64_t start_cycles = now_cycles();
+    for(i = 0; i < nb_samples; i++) {
+        const sample_t * s = &samples[i];
+        position_t out = {0, 0};
+        positioning_from_angles(s->alpha, s->beta, s->gamma, &t, &out);
+        checksum += out.x;
+    }
+    double cycles = (double)(now_cycles() - start_cycles) / nb_samples;
+    double ns = (now_ns() - start) / nb_samples;
+
+    start = now_ns();
+    start_cycles = now_cycles();
+    for(i = 0; i < nb_samples; i++) {
+        position_q_t out_q;
+        positioning_q_from_angles(
+                angles_q[i][0], angles_q[i][1], angles_q[i][2], &t_q, &out_q);
+        checksum += out_q.x;
+    }
+    double cycles_q = (double)(now_cycles() - start_cycles) / nb_samples;
+    double ns_q = (now_ns() - start) / nb_samples;
+
+    printf("\npositioning, %d grid points (%d valid), error against true position\n",
+            nb_samples, nb_valid);
+    printf("%-10s %10s %10s %14s %14s\n",
+            "build", "ns/call", "cyc/call", "mean err [m]", "max err [m]");
+    printf("%-10s %10.1f %10.0f %14.3g %14.3g\n",
+            "float", ns, cycles, sum_err / nb_valid, max_err);
+    printf("%-10s %10.1f %10.0f %14.3g %14.3g\n",
+            "fixed", ns_q, cycles_q, sum_err_q / nb_valid, max_err_q);
+
+    // keeps the timing loops from being optimized away
+    if(checksum == 0.0) {
+        printf("\n");
+    }
+}
+
+static void kalman_benchmark(void)
+{
+    robot_pos_t init_pos = {1.5f, 1.0f, 1.0f, 1.0f, 0.0f};
+    robot_pos_q_t init_pos_q = {
+        Q8_24_FROM_FLOAT(1.5f), Q8_24_FROM_FLOAT(1.0f),
+        Q8_24_ONE, Q8_24_ONE, 0};
+    kalman_robot_handle_t handle;
+    kalman_q_robot_handle_t handle_q;
+    robot_pos_t dest;
+    robot_pos_q_t dest_q;
+    double max_dist = 0.0, sum_dist = 0.0;
+    float t = 0.0f;
+    int i;
+
+    rng_state = 2463534242u;
+    for(i = 0; i < NB_STEPS; i++) {
+        steps[i].delta_t = MIN_DELTA_T + (MAX_DELTA_T - MIN_DELTA_T) * uniform();
+        t += steps[i].delta_t;
+        steps[i].x = 1.5f + cosf(t) + sqrtf(MEAS_VAR_X) * gaussian();
+        steps[i].y = 1.0f + sinf(t) + sqrtf(MEAS_VAR_Y) * gaussian();
+        steps[i].valid = uniform() >= MISSING_MEAS;
+    }
+
+    // timing
+    kalman_init(&handle, &init_pos);
+    double start = now_ns();
+    uint64_t start_cycles = now_cycles();
+    for(i = 0; i < NB_STEPS; i++) {
+        position_t meas = {steps[i].x, steps[i].y};
+        kalman_update(
+                &handle,
+                steps[i].valid ? &meas : NULL,
+                steps[i].delta_t,
+                &dest);
+    }
+    double cycles = (double)(now_cycles() - start_cycles) / NB_STEPS;
+    double ns = (now_ns() - start) / NB_STEPS;
+
+    kalman_q_init(&handle_q, &init_pos_q);
+    start = now_ns();
+    start_cycles = now_cycles();
+    for(i = 0; i < NB_STEPS; i++) {
+        position_q_t meas = {
+            Q8_24_FROM_FLOAT(steps[i].x), Q8_24_FROM_FLOAT(steps[i].y)};
+        kalman_q_update(
+                &handle_q,
+                steps[i].valid ? &meas : NULL,
+                Q8_24_FROM_FLOAT(steps[i].delta_t),
+                &dest_q);
+    }
+    double cycles_q = (double)(now_cycles() - start_cycles) / NB_STEPS;
+    double ns_q = (now_ns() - start) / NB_STEPS;
+
+    // distance between both estimates
+    kalman_init(&handle, &init_pos);
+    kalman_q_init(&handle_q, &init_pos_q);
+    for(i = 0; i < NB_STEPS; i++) {
+        position_t meas = {steps[i].x, steps[i].y};
+        position_q_t meas_q = {
+            Q8_24_FROM_FLOAT(steps[i].x), Q8_24_FROM_FLOAT(steps[i].y)};
+        kalman_update(
+                &handle,
+                steps[i].valid ? &meas : NULL,
+                steps[i].delta_t,
+                &dest);
+        kalman_q_update(
+                &handle_q,
+                steps[i].valid ? &meas_q : NULL,
+                Q8_24_FROM_FLOAT(steps[i].delta_t),
+                &dest_q);
+
+        double dist = hypot(
+                Q8_24_TO_FLOAT(dest_q.x) - dest.x,
+                Q8_24_TO_FLOAT(dest_q.y) - dest.y);
+        sum_dist += dist;
+        max_dist = dist > max_dist ? dist : max_dist;
+    }
+
+    printf("\nkalman, %d steps, delta_t in [%g, %g] s, fixed against float\n",
+            NB_STEPS, MIN_DELTA_T, MAX_DELTA_T);
+    printf("%-10s %10s %10s %14s %14s\n",
+            "build", "ns/step", "cyc/step", "mean dist [m]", "max dist [m]");
+    printf("%-10s %10.1f %10.0f\n", "float", ns, cycles);
+    printf("%-10s %10.1f %10.0f %14.3g %14.3g\n",
+            "fixed", ns_q, cycles_q, sum_dist / NB_STEPS, max_dist);
+}
+
+int main(void)
+{
+    positioning_benchmark();
+    kalman_benchmark();
+
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "../src/kalman.h"
+#include "../src/beacon_config.h"
+
+// compares the covariance update forms of the kalman filter over NB_STEPS
+// synthetic steps of a robot driving in circles with a jittering delta_t
+//
+// timing: average ns (and TSC cycles on x86) per kalman_update
+// drift: the float filter against a double precision filter running on the
+//        same sequence, and the number of steps after which the state
+//        covariance wasn't positive definite
+
+#define NB_STEPS        (1000000)
+#define MIN_DELTA_T     (0.002f)    // [s]
+#define MAX_DELTA_T     (0.1f)      // [s]
+#define MISSING_MEAS    (0.1f)      // fraction of missing measurements
+
+typedef struct {
+    float x;
+    float y;
+    float delta_t;
+    uint8_t valid;
+} step_t;
+
+typedef struct {
+    const char * name;
+    kalman_update_mode_t mode;
+    kalman_covariance_update_t form;
+} engine_t;
+
+static const engine_t engines[] = {
+    {"joint standard", KALMAN_UPDATE_JOINT, KALMAN_COVARIANCE_STANDARD},
+    {"joint joseph", KALMAN_UPDATE_JOINT, KALMAN_COVARIANCE_JOSEPH},
+    {"sequential standard", KALMAN_UPDATE_SEQUENTIAL, KALMAN_COVARIANCE_STANDARD},
+    {"sequential joseph", KALMAN_UPDATE_SEQUENTIAL, KALMAN_COVARIANCE_JOSEPH},
+};
+
+// measurement variances [m^2] the engines are compared at
+static const float meas_vars[] = {MEAS_VAR_X, 1e-8f};
+
+static step_t steps[NB_STEPS];
+
+// deterministic xorshift so every engine sees the same sequence
+static uint32_t rng_state = 2463534242u;
+
+static float uniform(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (rng_state >> 8) * (1.0f / 16777216.0f);
+}
+
+static float gaussian(void)
+{
+    float u = uniform();
+    if(u < 1e-7f) {
+        u = 1e-7f;
+    }
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * (float)M_PI * uniform());
+}
+
+static void generate_steps(float meas_var)
+{
+    float t = 0.0f;
+    int i;
+
+    rng_state = 2463534242u;
+    for(i = 0; i < NB_STEPS; i++) {
+        steps[i].delta_t = MIN_DELTA_T + (MAX_DELTA_T - MIN_DELTA_T) * uniform();
+        t += steps[i].delta_t;
+        steps[i].x = 1.5f + cosf(t) + sqrtf(meas_var) * gaussian();
+        steps[i].y = 1.0f + sinf(t) + sqrtf(meas_var) * gaussian();
+        steps[i].valid = uniform() >= MISSING_MEAS;
+    }
+}
+
+static void init_handle(
+        kalman_robot_handle_t * handle,
+        const engine_t * engine,
+        float meas_var)
+{
+    robot_pos_t init_pos = {1.5f, 1.0f, 1.0f, 1.0f, 0.0f};
+
+    kalman_init(handle, &init_pos);
+    kalman_set_update_mode(handle, engine->mode);
+    kalman_set_covariance_update(handle, engine->form);
+    kalman_update_measurement_covariance(handle, meas_var, meas_var, 0.0f);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// double precision filter on the full 4x4 covariance,
+// state (x, y, v_x, v_y), F = | I dt*I |, H = | I 0 |
+//                             | 0 I    |
+static void reference_step(double p[4][4], double r, double dt, int valid)
+{
+    double q_base = PROC_NOISE_PROP * MAX_ACC;
+    double pred[4][4];
+    int i, j;
+
+    // F*P*F^T
+    for(i = 0; i < 4; i++) {
+        for(j = 0; j < 4; j++) {
+            pred[i][j] = p[i][j];
+        }
+    }
+    for(i = 0; i < 4; i++) {
+        pred[i][0] += dt * pred[i][2];
+        pred[i][1] += dt * pred[i][3];
+    }
+    for(i = 0; i < 4; i++) {
+        pred[0][i] += dt * pred[2][i];
+        pred[1][i] += dt * pred[3][i];
+    }
+    for(i = 0; i < 2; i++) {
+        pred[i][i] += 0.25 * dt * dt * dt * dt * q_base;
+        pred[i][i + 2] += 0.5 * dt * dt * dt * q_base;
+        pred[i + 2][i] += 0.5 * dt * dt * dt * q_base;
+        pred[i + 2][i + 2] += dt * dt * q_base;
+    }
+
+    if(!valid) {
+        for(i = 0; i < 4; i++) {
+            for(j = 0; j < 4; j++) {
+                p[i][j] = pred[i][j];
+            }
+        }
+        return;
+    }
+
+    // K = P*H^T*(H*P*H^T + R)^-1, P = P - K*H*P
+    double s_a = pred[0][0] + r;
+    double s_b = pred[0][1];
+    double s_d = pred[1][1] + r;
+    double det = s_a * s_d - s_b * s_b;
+    double s_inv[2][2] = {{s_d / det, -s_b / det}, {-s_b / det, s_a / det}};
+    double gain[4][2];
+    for(i = 0; i < 4; i++) {
+        for(j = 0; j < 2; j++) {
+            gain[i][j] = pred[i][0] * s_inv[0][j] + pred[i][1] * s_inv[1][j];
+        }
+    }
+    for(i = 0; i < 4; i++) {
+        for(j = 0; j < 4; j++) {
+            p[i][j] = pred[i][j] - gain[i][0] * pred[0][j] - gain[i][1] * pred[1][j];
+        }
+    }
+}
+
+// expands the packed covariance of handle
+static void full_covariance(const kalman_robot_handle_t * handle, double p[4][4])
+{
+    const covariance_t * c = &(handle->_state_covariance);
+
+    p[0][0] = c->_cov_a._a;
+    p[0][1] = p[1][0] = c->_cov_a._b;
+    p[1][1] = c->_cov_a._d;
+    p[0][2] = p[2][0] = c->_cov_b._a;
+    p[0][3] = p[3][0] = c->_cov_b._b;
+    p[1][2] = p[2][1] = c->_cov_b._c;
+    p[1][3] = p[3][1] = c->_cov_b._d;
+    p[2][2] = c->_cov_d._a;
+    p[2][3] = p[3][2] = c->_cov_d._b;
+    p[3][3] = c->_cov_d._d;
+}
+
+// cholesky decomposition, fails if p isn't positive definite
+static int positive_definite(double p[4][4])
+{
+    double l[4][4] = {{0}};
+    int i, j, k;
+
+    for(j = 0; j < 4; j++) {
+        double sum = p[j][j];
+        for(k = 0; k < j; k++) {
+            sum -= l[j][k] * l[j][k];
+        }
+        if(sum <= 0.0) {
+            return 0;
+        }
+        l[j][j] = sqrt(sum);
+        for(i = j + 1; i < 4; i++) {
+            sum = p[i][j];
+            for(k = 0; k < j; k++) {
+                sum -= l[i][k] * l[j][k];
+            }
+            l[i][j] = sum / l[j][j];
+        }
+    }
+
+    return 1;
+}
+
+static void benchmark(const engine_t * engine, float meas_var)
+{
+    kalman_robot_handle_t handle;
+    robot_pos_t dest;
+    int i;
+
+    // timing
+    init_handle(&handle, engine, meas_var);
+    double start = now_ns();
+#ifdef HAVE_TSC
+    uint64_t start_cycles = __rdtsc();
+#endif
+    for(i = 0; i < NB_STEPS; i++) {
+        position_t meas = {steps[i].x, steps[i].y};
+        kalman_update(
+                &handle,
+                steps[i].valid ? &meas : NULL,
+                steps[i].delta_t,
+                &dest);
+    }
+#ifdef HAVE_TSC
+    double cycles = (double)(__rdtsc() - start_cycles) / NB_STEPS;
+#else
+    double cycles = 0.0;
+#endif
+    double ns = (now_ns() - start) / NB_STEPS;
+
+    // drift against the double precision reference
+    double ref[4][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
+    double max_rel_err = 0.0;
+    int first_not_pd = -1;
+    int nb_not_pd = 0;
+
+    init_handle(&handle, engine, meas_var);
+    for(i = 0; i < NB_STEPS; i++) {
+        position_t meas = {steps[i].x, steps[i].y};
+        kalman_update(
+                &handle,
+                steps[i].valid ? &meas : NULL,
+                steps[i].delta_t,
+                &dest);
+        reference_step(ref, meas_var, steps[i].delta_t, steps[i].valid);
+
+        double p[4][4];
+        full_covariance(&handle, p);
+        if(!positive_definite(p)) {
+            nb_not_pd++;
+            if(first_not_pd < 0) {
+                first_not_pd = i;
+            }
+        }
+
+        int j;
+        for(j = 0; j < 4; j++) {
+            double err = fabs(p[j][j] - ref[j][j]) / ref[j][j];
+            if(err > max_rel_err) {
+                max_rel_err = err;
+            }
+        }
+    }
+
+    printf("%-20s %10.1f %10.0f %14.3g %10d %12d\n",
+            engine->name, ns, cycles, max_rel_err, nb_not_pd, first_not_pd);
+}
+
+int main(void)
+{
+    unsigned int i, j;
+
+    for(i = 0; i < sizeof(meas_vars) / sizeof(meas_vars[0]); i++) {
+        generate_steps(meas_vars[i]);
+
+        printf("\n%d steps, measurement variance %g m^2, delta_t in [%g, %g] s\n",
+                NB_STEPS, meas_vars[i], MIN_DELTA_T, MAX_DELTA_T);
+        printf("%-20s %10s %10s %14s %10s %12s\n",
+                "engine", "ns/step", "cyc/step", "max rel. err", "not PD", "first not PD");
+
+        for(j = 0; j < sizeof(engines) / sizeof(engines[0]); j++) {
+            benchmark(&engines[j], meas_vars[i]);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "../src/positioning.h"
+#include "../src/positioning_lut.h"
+#include "../src/beacon_config.h"
+
+// chooses the resolution of positioning_lut_t: for every resolution the
+// size of the table, the error against the true position on every point of
+// a GRID_STEP grid over the table (without noise) and the time per fix,
+// next to positioning_from_angles
+//
+// a point counts in the error only if positioning_from_angles trusts it,
+// 'lost' are those points the table doesn't trust. 'bytes' counts the
+// table and the sines and cosines of its grid lines, which stay in RAM
+//
+// usage: lut_benchmark              report
+//        lut_benchmark <resolution> prints the table of the beacons of
+//                                   beacon_config.h as C, to keep in flash
+//                                   with positioning_lut_attach
+
+#define GRID_STEP       (0.01)      // [m]
+#define GRID_SIZE_X     (300)       // 3 [m]
+#define GRID_SIZE_Y     (200)       // 2 [m]
+#define NB_ROUNDS       (20)
+
+typedef struct {
+    double x;
+    double y;
+    float alpha;
+    float beta;
+    float gamma;
+    uint8_t valid;
+} sample_t;
+
+static const position_t beacons[3] = {BEACON_POS_A, BEACON_POS_B, BEACON_POS_C};
+// the grid points, the table of positioning_lut_init covers them
+static const position_t area_min = {GRID_STEP, GRID_STEP};
+static const position_t area_max = {
+    (GRID_SIZE_X - 1) * GRID_STEP, (GRID_SIZE_Y - 1) * GRID_STEP};
+static const uint16_t resolutions[] = {16, 24, 32, 48, 64, 96, 128};
+
+static sample_t samples[GRID_SIZE_X * GRID_SIZE_Y];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// directed angle at (x, y) from first to second, in [0, 2 Pi)
+static double directed_angle(
+        double x,
+        double y,
+        const position_t * first,
+        const position_t * second)
+{
+    double angle = atan2(second->y - y, second->x - x)
+        - atan2(first->y - y, first->x - x);
+
+    return angle < 0 ? angle + 2 * M_PI : angle;
+}
+
+static void print_table(const reference_triangle_t * t, uint16_t resolution)
+{
+    positioning_lut_entry_t * entries =
+        malloc(POSITIONING_LUT_SIZE(resolution) * sizeof(*entries));
+    positioning_lut_trig_t * trig =
+        malloc(POSITIONING_LUT_TRIG_SIZE(resolution) * sizeof(*trig));
+    positioning_lut_t lut;
+    int i;
+
+    positioning_lut_init(&lut, t, &area_min, &area_max, entries, trig,
+            resolution);
+    const positioning_lut_range_t * range = positioning_lut_get_range(&lut);
+
+    printf("// generated by benchmark/lut_benchmark %u for the beacons\n",
+            resolution);
+    printf("// A (%g, %g), B (%g, %g), C (%g, %g)\n",
+            beacons[0].x, beacons[0].y, beacons[1].x, beacons[1].y,
+            beacons[2].x, beacons[2].y);
+    printf("#define POSITIONING_LUT_RESOLUTION (%u)\n\n", resolution);
+    printf("const positioning_lut_range_t positioning_lut_range = "
+            "{%.9gf, %.9gf, %.9gf, %.9gf};\n\n", range->alpha_min,
+            range->alpha_max, range->beta_min, range->beta_max);
+    printf("const positioning_lut_entry_t positioning_lut_entries[] = {\n");
+    for(i = 0; i < POSITIONING_LUT_SIZE(resolution); i++) {
+        printf("    {%d, %d},\n", entries[i].x, entries[i].y);
+    }
+    printf("};\n");
+
+    free(entries);
+    free(trig);
+}
+
+static void benchmark(
+        const char * name,
+        size_t size,
+        const positioning_lut_t * lut,
+        const reference_triangle_t * t,
+        int nb_samples)
+{
+    double sum_err = 0.0, max_err = 0.0, checksum = 0.0;
+    int nb_valid = 0, nb_lost = 0;
+    int round, i;
+
+    for(i = 0; i < nb_samples; i++) {
+        const sample_t * s = &samples[i];
+        position_t out = {0, 0};
+        uint8_t valid = lut != NULL
+            ? positioning_lut_from_angles(lut, s->alpha, s->beta, s->gamma, &out)
+            : positioning_from_angles(s->alpha, s->beta, s->gamma, t, &out);
+
+        if(!s->valid) {
+            continue;
+        }
+        if(!valid) {
+            nb_lost++;
+            continue;
+        }
+        double err = hypot(out.x - s->x, out.y - s->y);
+        nb_valid++;
+        sum_err += err;
+        max_err = err > max_err ? err : max_err;
+    }
+
+    double start = now_ns();
+    uint64_t start_cycles = now_cycles();
+    for(round = 0; round < NB_ROUNDS; round++) {
+        for(i = 0; i < nb_samples; i++) {
+            const sample_t * s = &samples[i];
+            position_t out = {0, 0};
+            if(lut != NULL) {
+                positioning_lut_from_angles(lut, s->alpha, s->beta, s->gamma,
+                        &out);
+            } else {
+                positioning_from_angles(s->alpha, s->beta, s->gamma, t, &out);
+            }
+            checksum += out.x;
+        }
+    }
+    double nb_calls = (double)NB_ROUNDS * nb_samples;
+    double cycles = (now_cycles() - start_cycles) / nb_calls;
+    double ns = (now_ns() - start) / nb_calls;
+
+    printf("%-10s %10zu %10.1f %10.0f %8d %14.3g %14.3g\n",
+            name, size, ns, cycles, nb_lost,
+            nb_valid > 0 ? sum_err / nb_valid : 0.0, max_err);
+
+    // keeps the timing loop from being optimized away
+    if(checksum == 0.0) {
+        printf("\n");
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    int nb_samples = 0;
+    size_t k;
+    int i, j;
+
+    positioning_reference_triangle_from_points(
+            &beacons[0], &beacons[1], &beacons[2], &t);
+
+    if(argc > 1) {
+        int resolution = atoi(argv[1]);
+        if(resolution < 1 || resolution > 1000) {
+            fprintf(stderr, "usage: %s [resolution]\n", argv[0]);
+            return 1;
+        }
+        print_table(&t, resolution);
+        return 0;
+    }
+
+    for(i = 1; i < GRID_SIZE_X; i++) {
+        for(j = 1; j < GRID_SIZE_Y; j++) {
+            sample_t * s = &samples[nb_samples++];
+            position_t out = {0, 0};
+            s->x = i * GRID_STEP;
+            s->y = j * GRID_STEP;
+            s->alpha = directed_angle(s->x, s->y, &beacons[1], &beacons[2]);
+            s->beta = directed_angle(s->x, s->y, &beacons[2], &beacons[0]);
+            s->gamma = directed_angle(s->x, s->y, &beacons[0], &beacons[1]);
+            s->valid = positioning_from_angles(s->alpha, s->beta, s->gamma,
+                    &t, &out);
+        }
+    }
+
+    printf("positioning_lut_from_angles, %d grid points x %d rounds\n",
+            nb_samples, NB_ROUNDS);
+    printf("%-10s %10s %10s %10s %8s %14s %14s\n",
+            "table", "bytes", "ns/call", "cyc/call", "lost",
+            "mean err [m]", "max err [m]");
+    benchmark("no table", 0, NULL, &t, nb_samples);
+
+    for(k = 0; k < sizeof(resolutions) / sizeof(resolutions[0]); k++) {
+        size_t entries_size = POSITIONING_LUT_SIZE(resolutions[k])
+            * sizeof(positioning_lut_entry_t);
+        size_t trig_size = POSITIONING_LUT_TRIG_SIZE(resolutions[k])
+            * sizeof(positioning_lut_trig_t);
+        positioning_lut_entry_t * entries = malloc(entries_size);
+        positioning_lut_trig_t * trig = malloc(trig_size);
+        positioning_lut_t lut;
+        char name[16];
+
+        positioning_lut_init(&lut, &t, &area_min, &area_max, entries, trig,
+                resolutions[k]);
+        snprintf(name, sizeof(name), "%u^2", resolutions[k]);
+        benchmark(name, entries_size + trig_size, &lut, &t, nb_samples);
+        free(entries);
+        free(trig);
+    }
+
+    return 0;
+}
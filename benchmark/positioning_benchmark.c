@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "../src/positioning.h"
+
+// times positioning_from_angles against the previous implementation, which
+// went through tan(), fabs() and the double M_PI constants, on every point
+// of a GRID_STEP grid over the table, and positioning_from_angles_batch on
+// the same points
+//
+// an x86 host has double precision hardware so the difference mostly shows
+// the cost of the libm double functions, on the Cortex-M4F every double
+// operation is software emulated
+
+#define GRID_STEP       (0.01)      // [m]
+#define GRID_SIZE_X     (300)       // 3 [m]
+#define GRID_SIZE_Y     (200)       // 2 [m]
+#define NB_ROUNDS       (20)
+
+typedef struct {
+    float alpha;
+    float beta;
+    float gamma;
+} sample_t;
+
+static const position_t p_a = {3.0f, 1.0f};
+static const position_t p_b = {0.0f, 2.0f};
+static const position_t p_c = {0.0f, 0.0f};
+
+static sample_t samples[GRID_SIZE_X * GRID_SIZE_Y];
+
+// the same samples as structure of arrays for the batch version
+static float alphas[GRID_SIZE_X * GRID_SIZE_Y];
+static float betas[GRID_SIZE_X * GRID_SIZE_Y];
+static float gammas[GRID_SIZE_X * GRID_SIZE_Y];
+static float xs[GRID_SIZE_X * GRID_SIZE_Y];
+static float ys[GRID_SIZE_X * GRID_SIZE_Y];
+static uint32_t valid[(GRID_SIZE_X * GRID_SIZE_Y + 31) / 32];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// directed angle at (x, y) from first to second, in [0, 2 Pi)
+static double directed_angle(
+        double x,
+        double y,
+        const position_t * first,
+        const position_t * second)
+{
+    double angle = atan2(second->y - y, second->x - x)
+        - atan2(first->y - y, first->x - x);
+
+    return angle < 0 ? angle + 2 * M_PI : angle;
+}
+
+// previous positioning_from_angles, every helper promotes to double
+static uint8_t legacy_feq(float a, float b)
+{
+    static const float EPSILON = 0.1f;
+    return fabs(a - b) < EPSILON;
+}
+
+static float legacy_cot(float alpha)
+{
+    return tan(M_PI_2 - alpha);
+}
+
+static uint8_t legacy_positioning_from_angles(
+        float alpha,
+        float beta,
+        float gamma,
+        const reference_triangle_t * t,
+        position_t * output)
+{
+    if (!legacy_feq(alpha + beta + gamma, 2 * M_PI)) {
+        return 0;
+    }
+
+    uint8_t is_valid = 1;
+    float cot_alpha = legacy_cot(alpha);
+    float cot_beta = legacy_cot(beta);
+    float cot_gamma = legacy_cot(gamma);
+    if (
+        legacy_feq(cot_alpha, t->cotangent_at_a) ||
+        legacy_feq(cot_beta, t->cotangent_at_b) ||
+        legacy_feq(cot_gamma, t->cotangent_at_c))
+    {
+        is_valid = 0;
+    }
+
+    float barycentric_a = 1.0f / (t->cotangent_at_a - cot_alpha);
+    float barycentric_b = 1.0f / (t->cotangent_at_b - cot_beta);
+    float barycentric_c = 1.0f / (t->cotangent_at_c - cot_gamma);
+    float magnitude = barycentric_a + barycentric_b + barycentric_c;
+    barycentric_a /= magnitude;
+    barycentric_b /= magnitude;
+    barycentric_c /= magnitude;
+
+    position_t pos = {
+        barycentric_a * t->point_a->x + barycentric_b * t->point_b->x +
+            barycentric_c * t->point_c->x,
+        barycentric_a * t->point_a->y + barycentric_b * t->point_b->y +
+            barycentric_c * t->point_c->y};
+    memcpy(output, &pos, sizeof(position_t));
+
+    return is_valid;
+}
+
+typedef uint8_t (*positioning_fn_t)(
+        float, float, float, const reference_triangle_t *, position_t *);
+
+static void benchmark(
+        const char * name,
+        positioning_fn_t fn,
+        const reference_triangle_t * t,
+        int nb_samples)
+{
+    double checksum = 0.0;
+    int nb_valid = 0;
+    int round, i;
+
+    double start = now_ns();
+    uint64_t start_cycles = now_cycles();
+    for(round = 0; round < NB_ROUNDS; round++) {
+        for(i = 0; i < nb_samples; i++) {
+            position_t out = {0, 0};
+            nb_valid += fn(samples[i].alpha, samples[i].beta, samples[i].gamma,
+                    t, &out);
+            checksum += out.x + out.y;
+        }
+    }
+    double nb_calls = (double)NB_ROUNDS * nb_samples;
+    double cycles = (now_cycles() - start_cycles) / nb_calls;
+    double ns = (now_ns() - start) / nb_calls;
+
+    printf("%-10s %10.1f %10.0f %10d %14.6g\n",
+            name, ns, cycles, nb_valid / NB_ROUNDS, checksum / nb_calls);
+}
+
+static void benchmark_batch(const reference_triangle_t * t, int nb_samples)
+{
+    double checksum = 0.0;
+    int nb_valid = 0;
+    int round, i;
+
+    for(i = 0; i < nb_samples; i++) {
+        alphas[i] = samples[i].alpha;
+        betas[i] = samples[i].beta;
+        gammas[i] = samples[i].gamma;
+    }
+
+    double start = now_ns();
+    uint64_t start_cycles = now_cycles();
+    for(round = 0; round < NB_ROUNDS; round++) {
+        nb_valid += positioning_from_angles_batch(alphas, betas, gammas,
+                nb_samples, t, xs, ys, valid);
+        for(i = 0; i < nb_samples; i++) {
+            checksum += xs[i] + ys[i];
+        }
+    }
+    double nb_calls = (double)NB_ROUNDS * nb_samples;
+    double cycles = (now_cycles() - start_cycles) / nb_calls;
+    double ns = (now_ns() - start) / nb_calls;
+
+    printf("%-10s %10.1f %10.0f %10d %14.6g\n",
+            "batch", ns, cycles, nb_valid / NB_ROUNDS, checksum / nb_calls);
+}
+
+int main(void)
+{
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    int nb_samples = 0;
+    int i, j;
+
+    positioning_reference_triangle_from_points(&p_a, &p_b, &p_c, &t);
+
+    for(i = 1; i < GRID_SIZE_X; i++) {
+        for(j = 1; j < GRID_SIZE_Y; j++) {
+            sample_t * s = &samples[nb_samples++];
+            s->alpha = directed_angle(i * GRID_STEP, j * GRID_STEP, &p_b, &p_c);
+            s->beta = directed_angle(i * GRID_STEP, j * GRID_STEP, &p_c, &p_a);
+            s->gamma = directed_angle(i * GRID_STEP, j * GRID_STEP, &p_a, &p_b);
+        }
+    }
+
+    printf("positioning_from_angles, %d grid points x %d rounds\n",
+            nb_samples, NB_ROUNDS);
+    printf("%-10s %10s %10s %10s %14s\n",
+            "version", "ns/call", "cyc/call", "valid", "mean x + y");
+    benchmark("double", legacy_positioning_from_angles, &t, nb_samples);
+    benchmark("float", positioning_from_angles, &t, nb_samples);
+    benchmark_batch(&t, nb_samples);
+
+    return 0;
+}
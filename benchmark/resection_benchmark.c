@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/resection.h"
+#include "../src/beacon_config.h"
+
+// resection_from_bearings against the number of beacons
+//
+// for 3 to RESECTION_MAX_BEACONS beacons around the table (the three of
+// beacon_config.h first) every cell of a GRID_STEP grid over the table gets
+// NB_SAMPLES fixes from its center, the bearings with a gaussian noise of
+// NOISE [rad] and an origin turning from fix to fix. the iterations start
+// GUESS_ERROR [m] away from the center, like from the estimate of the
+// filter, or from the center of the beacons without guess. a fix is usable
+// if its variance (var_x + var_y) is below MEAS_VAR_MAX, like in the
+// pipeline. the last table hides the first beacon, as if the other robot
+// stood in front of it
+//
+// usage: resection_benchmark
+
+#define GRID_STEP       (0.05)      // [m]
+#define GRID_SIZE_X     (60)        // 3 [m]
+#define GRID_SIZE_Y     (40)        // 2 [m]
+#define NB_SAMPLES      (20)        // per cell
+#define NOISE           (0.001)     // [rad]
+#define GUESS_ERROR     (0.05)      // [m]
+
+static const position_t beacons[RESECTION_MAX_BEACONS] = {
+    BEACON_POS_A, BEACON_POS_B, BEACON_POS_C,
+    {3.0f, 2.0f}, {3.0f, 0.0f}, {1.5f, 2.0f}, {1.5f, 0.0f}, {0.0f, 1.0f}};
+
+typedef struct {
+    float bearings[RESECTION_MAX_BEACONS];
+    double x;
+    double y;
+} sample_t;
+
+static sample_t samples[GRID_SIZE_X * GRID_SIZE_Y * NB_SAMPLES];
+static float errors[GRID_SIZE_X * GRID_SIZE_Y * NB_SAMPLES];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// deterministic xorshift
+static double uniform(uint32_t * state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state >> 8) * (1.0 / 16777216.0);
+}
+
+static double gaussian(uint32_t * state)
+{
+    double u = uniform(state);
+    if(u < 1e-7) {
+        u = 1e-7;
+    }
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * uniform(state));
+}
+
+static int compare_float(const void * a, const void * b)
+{
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+
+    return (fa > fb) - (fa < fb);
+}
+
+static void benchmark(
+        int nb_beacons,
+        uint8_t visible,
+        int with_guess,
+        int nb_samples)
+{
+    resection_t resection;
+    int nb_fixes = 0, nb_usable = 0;
+    double sum_sq = 0.0;
+    int i;
+
+    resection_init(&resection, beacons, nb_beacons);
+
+    double start = now_ns();
+    for(i = 0; i < nb_samples; i++) {
+        position_t pos = {0.0f, 0.0f};
+        position_t guess = {samples[i].x + GUESS_ERROR,
+            samples[i].y - GUESS_ERROR};
+        position_covariance_t cov;
+
+        if(!resection_from_bearings(&resection, samples[i].bearings, visible,
+                    (float)(NOISE * NOISE), with_guess ? &guess : NULL, &pos,
+                    &cov)) {
+            continue;
+        }
+        nb_fixes++;
+        if(cov.var_x + cov.var_y < MEAS_VAR_MAX) {
+            double err = hypot(pos.x - samples[i].x, pos.y - samples[i].y);
+            errors[nb_usable++] = err;
+            sum_sq += err * err;
+        }
+    }
+    double ns = (now_ns() - start) / nb_samples;
+
+    qsort(errors, nb_usable, sizeof(errors[0]), compare_float);
+    printf("%-8d %10.1f %10.2f %10.2f %14.3g %14.3g\n", nb_beacons, ns,
+            100.0 * nb_fixes / nb_samples, 100.0 * nb_usable / nb_samples,
+            nb_usable > 0 ? sqrt(sum_sq / nb_usable) : NAN,
+            nb_usable > 0 ? errors[nb_usable * 99 / 100] : NAN);
+}
+
+int main(void)
+{
+    uint32_t rng_state = 2463534242u;
+    int nb_samples = 0;
+    int i, j, k, n;
+
+    for(i = 0; i < GRID_SIZE_X; i++) {
+        for(j = 0; j < GRID_SIZE_Y; j++) {
+            for(k = 0; k < NB_SAMPLES; k++) {
+                sample_t * s = &samples[nb_samples++];
+                double origin = 2.0 * M_PI * uniform(&rng_state);
+
+                s->x = (i + 0.5) * GRID_STEP;
+                s->y = (j + 0.5) * GRID_STEP;
+                for(n = 0; n < RESECTION_MAX_BEACONS; n++) {
+                    s->bearings[n] = atan2(beacons[n].y - s->y,
+                            beacons[n].x - s->x) - origin
+                        + NOISE * gaussian(&rng_state);
+                }
+            }
+        }
+    }
+
+    printf("resection_from_bearings, %d fixes over the table, noise %g "
+            "[rad]\n", nb_samples, NOISE);
+    printf("\nguess %g [m] off\n", GUESS_ERROR);
+    printf("%-8s %10s %10s %10s %14s %14s\n", "beacons", "ns/call",
+            "fixes %", "usable %", "rms err [m]", "p99 err [m]");
+    for(n = 3; n <= RESECTION_MAX_BEACONS; n++) {
+        benchmark(n, (uint8_t)((1u << n) - 1), 1, nb_samples);
+    }
+
+    printf("\nno guess\n");
+    printf("%-8s %10s %10s %10s %14s %14s\n", "beacons", "ns/call",
+            "fixes %", "usable %", "rms err [m]", "p99 err [m]");
+    for(n = 3; n <= RESECTION_MAX_BEACONS; n++) {
+        benchmark(n, (uint8_t)((1u << n) - 1), 0, nb_samples);
+    }
+
+    printf("\nfirst beacon hidden, guess %g [m] off\n", GUESS_ERROR);
+    printf("%-8s %10s %10s %10s %14s %14s\n", "beacons", "ns/call",
+            "fixes %", "usable %", "rms err [m]", "p99 err [m]");
+    for(n = 4; n <= RESECTION_MAX_BEACONS; n++) {
+        benchmark(n, (uint8_t)((1u << n) - 2), 1, nb_samples);
+    }
+
+    return 0;
+}
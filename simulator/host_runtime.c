@@ -0,0 +1,291 @@
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <platform-abstraction/threading.h>
+#include <platform-abstraction/semaphore.h>
+#include <platform-abstraction/mutex.h>
+#include <platform-abstraction/timestamp.h>
+
+// the platform-abstraction calls the pipeline makes, on pthreads
+//
+// mutex_t and semaphore_t are the types of the mock port, their fields
+// aren't used: every object initialized gets a pthread mutex and condition
+// variable of its own, found again by its address. thread priorities and
+// stacks are ignored, the host scheduler runs the threads as it likes.
+
+#define MAX_OBJECTS (32)
+
+typedef struct {
+    const void *object;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    // semaphore count, 1 for a mutex which is taken
+    int32_t count;
+} host_object_t;
+
+typedef struct {
+    void (*function)(void *);
+    void *context;
+} thread_start_t;
+
+static host_object_t objects[MAX_OBJECTS];
+static int nb_objects = 0;
+static pthread_mutex_t objects_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct timespec start_time;
+static pthread_once_t start_time_once = PTHREAD_ONCE_INIT;
+
+static host_object_t *object_get(const void *object, int32_t init_count);
+static host_object_t *object_find(const void *object);
+static void *thread_start(void *arg);
+static void start_time_init(void);
+static void deadline_from_now(uint32_t us, struct timespec *deadline);
+
+
+void os_init(void)
+{
+    pthread_once(&start_time_once, start_time_init);
+}
+
+// the threads already run, only the main thread of the host waits here
+void os_run(void)
+{
+    while(1){
+        pause();
+    }
+}
+
+void os_thread_create(os_thread_t *thread, void (*function)(void *),
+        void *stack, int stack_size, const char *name, int priority,
+        void *context)
+{
+    pthread_t handle;
+    thread_start_t *start = malloc(sizeof(thread_start_t));
+
+    (void)thread;
+    (void)stack;
+    (void)stack_size;
+    (void)priority;
+
+    if(start == NULL){
+        fprintf(stderr, "no memory for thread %s\n", name);
+        exit(1);
+    }
+    start->function = function;
+    start->context = context;
+
+    if(pthread_create(&handle, NULL, thread_start, start) != 0){
+        fprintf(stderr, "can't create thread %s\n", name);
+        exit(1);
+    }
+    pthread_detach(handle);
+}
+
+void os_thread_sleep_us(uint32_t us)
+{
+    struct timespec duration;
+
+    duration.tv_sec = us / 1000000;
+    duration.tv_nsec = (us % 1000000) * 1000;
+    while(nanosleep(&duration, &duration) != 0 && errno == EINTR);
+}
+
+void os_thread_sleep_least_us(uint32_t us)
+{
+    os_thread_sleep_us(us);
+}
+
+uint32_t os_timestamp_get(void)
+{
+    struct timespec now;
+
+    pthread_once(&start_time_once, start_time_init);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((int64_t)(now.tv_sec - start_time.tv_sec) * 1000000
+            + (now.tv_nsec - start_time.tv_nsec) / 1000);
+}
+
+void os_mutex_init(mutex_t *mutex)
+{
+    object_get(mutex, 0);
+}
+
+void os_mutex_take(mutex_t *mutex)
+{
+    host_object_t *o = object_find(mutex);
+
+    pthread_mutex_lock(&o->lock);
+    while(o->count != 0){
+        pthread_cond_wait(&o->changed, &o->lock);
+    }
+    o->count = 1;
+    pthread_mutex_unlock(&o->lock);
+}
+
+void os_mutex_release(mutex_t *mutex)
+{
+    host_object_t *o = object_find(mutex);
+
+    pthread_mutex_lock(&o->lock);
+    o->count = 0;
+    pthread_cond_signal(&o->changed);
+    pthread_mutex_unlock(&o->lock);
+}
+
+void os_semaphore_init(semaphore_t *sem, uint32_t count)
+{
+    object_get(sem, count);
+}
+
+void os_semaphore_signal(semaphore_t *sem)
+{
+    host_object_t *o = object_find(sem);
+
+    pthread_mutex_lock(&o->lock);
+    o->count++;
+    pthread_cond_signal(&o->changed);
+    pthread_mutex_unlock(&o->lock);
+}
+
+void os_semaphore_wait(semaphore_t *sem)
+{
+    host_object_t *o = object_find(sem);
+
+    pthread_mutex_lock(&o->lock);
+    while(o->count == 0){
+        pthread_cond_wait(&o->changed, &o->lock);
+    }
+    o->count--;
+    pthread_mutex_unlock(&o->lock);
+}
+
+bool os_semaphore_try(semaphore_t *sem)
+{
+    host_object_t *o = object_find(sem);
+    bool taken = false;
+
+    pthread_mutex_lock(&o->lock);
+    if(o->count > 0){
+        o->count--;
+        taken = true;
+    }
+    pthread_mutex_unlock(&o->lock);
+
+    return taken;
+}
+
+bool os_semaphore_wait_timeout(semaphore_t *sem, uint32_t timeout_us)
+{
+    host_object_t *o = object_find(sem);
+    struct timespec deadline;
+    bool taken = false;
+
+    deadline_from_now(timeout_us, &deadline);
+
+    pthread_mutex_lock(&o->lock);
+    while(o->count == 0){
+        if(pthread_cond_timedwait(&o->changed, &o->lock, &deadline)
+                == ETIMEDOUT){
+            break;
+        }
+    }
+    if(o->count > 0){
+        o->count--;
+        taken = true;
+    }
+    pthread_mutex_unlock(&o->lock);
+
+    return taken;
+}
+
+
+// (re)initializes the host object of 'object', creates it the first time
+static host_object_t *object_get(const void *object, int32_t init_count)
+{
+    host_object_t *o = NULL;
+    pthread_condattr_t attr;
+    int i;
+
+    pthread_mutex_lock(&objects_lock);
+
+    for(i = 0; i < nb_objects; i++){
+        if(objects[i].object == object){
+            o = &objects[i];
+            break;
+        }
+    }
+
+    if(o == NULL){
+        if(nb_objects == MAX_OBJECTS){
+            fprintf(stderr, "more than %d mutexes and semaphores\n",
+                    MAX_OBJECTS);
+            exit(1);
+        }
+        o = &objects[nb_objects];
+        o->object = object;
+        pthread_mutex_init(&o->lock, NULL);
+        // timed waits are against CLOCK_MONOTONIC like os_timestamp_get
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&o->changed, &attr);
+        pthread_condattr_destroy(&attr);
+        nb_objects++;
+    }
+
+    o->count = init_count;
+
+    pthread_mutex_unlock(&objects_lock);
+
+    return o;
+}
+
+static host_object_t *object_find(const void *object)
+{
+    int i;
+
+    pthread_mutex_lock(&objects_lock);
+    for(i = 0; i < nb_objects; i++){
+        if(objects[i].object == object){
+            pthread_mutex_unlock(&objects_lock);
+            return &objects[i];
+        }
+    }
+    pthread_mutex_unlock(&objects_lock);
+
+    fprintf(stderr, "mutex or semaphore %p used before its init\n", object);
+    exit(1);
+}
+
+static void *thread_start(void *arg)
+{
+    thread_start_t start = *(thread_start_t *)arg;
+
+    free(arg);
+    start.function(start.context);
+
+    return NULL;
+}
+
+static void start_time_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+static void deadline_from_now(uint32_t us, struct timespec *deadline)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += us / 1000000;
+    deadline->tv_nsec += (us % 1000000) * 1000;
+    if(deadline->tv_nsec >= 1000000000){
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
@@ -0,0 +1,258 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <platform-abstraction/threading.h>
+
+#include "../src/pipeline.h"
+#include "../src/edge_trace.h"
+
+// replays an edge trace (see edge_trace.h) through the laser and filter
+// steps of the pipeline (src/pipeline.c), as fast as the host goes
+//
+// the edges go to beacon_angles_update_timestamp in the order of the trace
+// and every rotation they close goes through laser_fix and filter_update,
+// like in the laser and kalman threads of the board. on the board the
+// kalman thread also predicts without fix, when its schedule allows: the
+// replay only updates the filters with the fixes, so a trace always gives
+// the same estimates, bit for bit, and two builds can be compared on it.
+// commands the board applied during the trace aren't replayed.
+//
+// usage: replay <trace file>
+// prints a line per fix to stdout: time [us], laser, then the estimate of
+// its robot x, y [m], var_x, var_y, cov_xy [m^2]. the statistics go to
+// stderr
+
+typedef struct {
+    beacon_angles_t angles;
+    // os time [us] of the next edge, from an EDGE_TRACE_SYNC record
+    uint8_t sync_next;
+    uint32_t sync_os_time;
+    // last edge the os time is known of
+    uint8_t synced;
+    uint32_t sync_timestamp;
+} replay_laser_t;
+
+typedef struct {
+    uint32_t nb_records;
+    uint32_t nb_edges;
+    uint32_t nb_rotations;
+    uint32_t nb_fixes;
+    uint32_t nb_dropped;
+    uint32_t nb_skipped;
+} replay_stats_t;
+
+static replay_laser_t replay_lasers[NB_LASERS];
+static uint8_t filter_started[NB_ROBOTS];
+static replay_stats_t stats;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// converts a timestamp of the laser to the os time of the board, from the
+// last synchronized edge
+static uint32_t to_os_time(int laser, uint32_t timestamp)
+{
+    const replay_laser_t *l = &replay_lasers[laser];
+    uint32_t freq = lasers[laser].timestamp_freq;
+
+    if(!l->synced) {
+        return (uint32_t)((uint64_t)timestamp * 1000000 / freq);
+    }
+
+    int32_t delta = (int32_t)(timestamp - l->sync_timestamp);
+    return l->sync_os_time + (int32_t)((int64_t)delta * 1000000 / freq);
+}
+
+static uint32_t laser_one_to_os_time(uint32_t timestamp)
+{
+    return to_os_time(0, timestamp);
+}
+
+static uint32_t laser_two_to_os_time(uint32_t timestamp)
+{
+    return to_os_time(1, timestamp);
+}
+
+void pipeline_fix_hook(void)
+{
+    stats.nb_fixes++;
+}
+
+uint32_t pipeline_output_dropped(void)
+{
+    return 0;
+}
+
+static void print_estimate(int laser, const robot_estimate_t *estimate)
+{
+#if BEACON_FIXED_POINT
+    printf("%u %d %.9g %.9g %.9g %.9g %.9g\n", estimate->time, laser + 1,
+            Q8_24_TO_FLOAT(estimate->pos.x), Q8_24_TO_FLOAT(estimate->pos.y),
+            Q8_24_TO_FLOAT(estimate->pos.var_x),
+            Q8_24_TO_FLOAT(estimate->pos.var_y),
+            Q8_24_TO_FLOAT(estimate->pos.cov_xy));
+#else
+    printf("%u %d %.9g %.9g %.9g %.9g %.9g\n", estimate->time, laser + 1,
+            estimate->pos.x, estimate->pos.y,
+            estimate->pos.var_x, estimate->pos.var_y, estimate->pos.cov_xy);
+#endif
+}
+
+// the laser thread and the kalman thread of the board for one edge
+static void replay_edge(int laser, enum beacon_nb beacon, uint32_t time)
+{
+    replay_laser_t *l = &replay_lasers[laser];
+    robot_t *robot = lasers[laser].robot;
+    laser_fix_t fix;
+
+    stats.nb_edges++;
+    if(l->sync_next) {
+        l->sync_next = 0;
+        l->synced = 1;
+        l->sync_timestamp = time;
+    }
+
+    beacon_angles_update_timestamp(&l->angles, beacon, time);
+
+    while(beacon_angles_calculate(&l->angles)) {
+        stats.nb_rotations++;
+        if(!laser_fix(&lasers[laser], &fix)) {
+            continue;
+        }
+        pipeline_fix_hook();
+
+        if(!filter_started[robot - robots]) {
+            filter_init(&robot->filter, fix.time);
+            filter_started[robot - robots] = 1;
+        }
+        filter_update(robot, fix.time, &fix);
+        if(triple_buffer_update(&robot->estimate)) {
+            print_estimate(laser, triple_buffer_read(&robot->estimate));
+        }
+    }
+}
+
+static void replay_record(const edge_trace_record_t *record)
+{
+    replay_laser_t *l = &replay_lasers[record->laser];
+
+    stats.nb_records++;
+    switch(record->kind) {
+        case EDGE_TRACE_EDGE_A:
+        case EDGE_TRACE_EDGE_B:
+        case EDGE_TRACE_EDGE_C:
+            replay_edge(record->laser, (enum beacon_nb)record->kind,
+                    record->args[0]);
+            break;
+        case EDGE_TRACE_SYNC:
+            l->sync_next = 1;
+            l->sync_os_time = record->args[0];
+            break;
+        case EDGE_TRACE_CONFIG:
+            if(record->args[0] != 0) {
+                lasers[record->laser].timestamp_freq = record->args[0];
+            }
+            beacon_angles_set_minimal_period(&l->angles, record->args[1]);
+            break;
+        case EDGE_TRACE_DROPPED:
+            stats.nb_dropped += record->args[0];
+            break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct stat st;
+    const uint8_t *trace;
+    edge_trace_record_t record;
+    size_t offset;
+    int fd;
+    int i;
+
+    if(argc != 2) {
+        fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+        return 1;
+    }
+
+    fd = open(argv[1], O_RDONLY);
+    if(fd < 0 || fstat(fd, &st) != 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    if(st.st_size < EDGE_TRACE_MAGIC_SIZE) {
+        fprintf(stderr, "%s: not an edge trace\n", argv[1]);
+        return 1;
+    }
+
+    // traces of hours are read straight from the page cache
+    trace = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(trace == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    madvise((void *)trace, st.st_size, MADV_SEQUENTIAL);
+
+    if(memcmp(trace, EDGE_TRACE_MAGIC, EDGE_TRACE_MAGIC_SIZE) != 0) {
+        fprintf(stderr, "%s: not an edge trace\n", argv[1]);
+        return 1;
+    }
+
+    os_init();
+    pipeline_init();
+
+    for(i = 0; i < NB_LASERS; i++) {
+        beacon_angles_init(&replay_lasers[i].angles);
+        lasers[i].angles = &replay_lasers[i].angles;
+        lasers[i].capture = NULL;
+        lasers[i].timestamp_freq = 1000000;
+    }
+    lasers[0].to_os_time = laser_one_to_os_time;
+    lasers[1].to_os_time = laser_two_to_os_time;
+
+    double start = now_ns();
+
+    offset = EDGE_TRACE_MAGIC_SIZE;
+    while(offset < (size_t)st.st_size) {
+        size_t size = edge_trace_decode(&trace[offset], st.st_size - offset,
+                &record);
+
+        // a record cut by the end of the recording, or garbage
+        if(size == 0) {
+            stats.nb_skipped++;
+            offset++;
+            continue;
+        }
+        if(record.laser < NB_LASERS) {
+            replay_record(&record);
+        } else {
+            stats.nb_skipped++;
+        }
+        offset += size;
+    }
+
+    double elapsed = (now_ns() - start) / 1e9;
+
+    fflush(stdout);
+    fprintf(stderr, "%u records, %u edges (%u dropped by the board), "
+            "%u rotations, %u fixes, %u skipped\n",
+            stats.nb_records, stats.nb_edges, stats.nb_dropped,
+            stats.nb_rotations, stats.nb_fixes, stats.nb_skipped);
+    fprintf(stderr, "%.3f [s], %.0f edges per second\n", elapsed,
+            elapsed > 0 ? stats.nb_edges / elapsed : 0.0);
+
+    munmap((void *)trace, st.st_size);
+    close(fd);
+
+    return 0;
+}
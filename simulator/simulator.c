@@ -0,0 +1,376 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <platform-abstraction/threading.h>
+#include <platform-abstraction/timestamp.h>
+
+#include "../src/pipeline.h"
+#include "../src/telemetry.h"
+#include "../src/edge_trace.h"
+
+// runs the firmware pipeline (src/pipeline.c) on the host, see
+// host_runtime.c, fed by simulated lasers
+//
+// every laser turns at a constant speed on its robot and "interrupts" at
+// each beacon it sweeps, on the real time of the host, so the threads see
+// the edges like on the board. the robots drive circles around the table.
+// the telemetry the communication thread writes to stdout is decoded and
+// compared to the true position of the robot at the time of the state.
+//
+// usage: simulator [duration [s]] [laser frequency [Hz]] [trace file]
+// commands (see command.h) can be typed on stdin, the report goes to
+// stdout once the duration is over. with a trace file the pipeline traces
+// the edges (trace command) which are written to the file for
+// simulator/replay.c, the telemetry then has no robot states
+
+#define DEFAULT_DURATION    (10)        // [s]
+#define DEFAULT_LASER_FREQ  (10.0)      // [Hz]
+#define EDGE_JITTER         (2.0)       // [us], standard deviation
+
+#define CIRCLE_X            (1.5)       // [m]
+#define CIRCLE_Y            (1.0)       // [m]
+#define CIRCLE_RADIUS       (0.5)       // [m]
+#define CIRCLE_SPEED        (1.0)       // [rad/s]
+
+// the laser turns clockwise: from beacon A it sweeps C first, which is
+// wired to the input of beacon B, see laser_fix in pipeline.c
+static const enum beacon_nb beacon_input[3] = {A, C, B};
+
+typedef struct {
+    int index;
+    beacon_angles_t angles;
+    double period;                  // [us]
+    uint32_t rng_state;
+    volatile uint32_t nb_rotations;
+} sim_laser_t;
+
+typedef struct {
+    uint32_t nb_frames;
+    uint32_t nb_fixes;
+    uint32_t nb_lost;
+    uint8_t tracking;
+    double age_sum;                 // [us]
+    uint32_t age_max;               // [us]
+    uint32_t nb_errors;
+    double error_sum;               // [m]
+    double error_max;               // [m]
+} sim_robot_stats_t;
+
+static const position_t beacons[3] = {BEACON_POS_A, BEACON_POS_B, BEACON_POS_C};
+
+static sim_laser_t sim_lasers[NB_LASERS];
+static sim_robot_stats_t stats[NB_ROBOTS];
+static volatile uint32_t nb_fixes;
+static volatile uint32_t nb_bad_frames;
+static volatile uint32_t nb_trace_frames;
+static FILE *trace_file;
+
+static os_thread_t sim_laser_threads[NB_LASERS];
+static os_thread_t telemetry_thread;
+
+
+// true position of 'robot' at 'time' [us]
+static void robot_position(int robot, uint32_t time, double *x, double *y)
+{
+    double angle = CIRCLE_SPEED * time / 1e6 + robot * M_PI;
+
+    *x = CIRCLE_X + CIRCLE_RADIUS * cos(angle);
+    *y = CIRCLE_Y + CIRCLE_RADIUS * sin(angle);
+}
+
+// deterministic xorshift, one stream per laser
+static double uniform(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state >> 8) * (1.0 / 16777216.0);
+}
+
+static double gaussian(uint32_t *state)
+{
+    double u = uniform(state);
+    if(u < 1e-7) {
+        u = 1e-7;
+    }
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * uniform(state));
+}
+
+static void sleep_until(uint32_t time)
+{
+    int32_t remaining = (int32_t)(time - os_timestamp_get());
+
+    if(remaining > 0) {
+        os_thread_sleep_us(remaining);
+    }
+}
+
+// emits the edges of every rotation of the laser at the time the laser
+// sweeps each beacon
+static void sim_laser_main(void *context)
+{
+    sim_laser_t *laser = (sim_laser_t *)context;
+    int robot = lasers[laser->index].robot - robots;
+    // lasers on the same robot don't sweep the beacons at the same time
+    double start = os_timestamp_get() + laser->index * laser->period / 2;
+
+    while(1) {
+        double offset[3];
+        double x, y;
+        int order[3] = {A, B, C};
+        int i, j;
+
+        // the heading of the laser is 0 at 'start' and decreases, the
+        // robot moves a bit until the laser reaches a beacon
+        for(i = 0; i < 3; i++) {
+            offset[i] = 0.0;
+            for(j = 0; j < 2; j++) {
+                robot_position(robot, (uint32_t)(start + offset[i]), &x, &y);
+                double bearing = atan2(beacons[i].y - y, beacons[i].x - x);
+                double sweep = fmod(-bearing + 2 * M_PI, 2 * M_PI);
+                offset[i] = sweep / (2 * M_PI) * laser->period;
+            }
+        }
+
+        for(i = 1; i < 3; i++) {
+            for(j = i; j > 0 && offset[order[j]] < offset[order[j - 1]]; j--) {
+                int tmp = order[j];
+                order[j] = order[j - 1];
+                order[j - 1] = tmp;
+            }
+        }
+
+        // the edge carries the time the laser hit the beacon, like an input
+        // capture, waking up late only delays it
+        for(i = 0; i < 3; i++) {
+            double jitter = EDGE_JITTER * gaussian(&laser->rng_state);
+            uint32_t time = (uint32_t)(start + offset[order[i]] + jitter);
+            sleep_until(time);
+            beacon_angles_update_timestamp(&laser->angles,
+                    beacon_input[order[i]], time);
+        }
+
+        laser->nb_rotations++;
+        start += laser->period;
+    }
+}
+
+static uint32_t read_u32(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16)
+        | ((uint32_t)data[3] << 24);
+}
+
+static float read_float(const uint8_t *data)
+{
+    uint32_t raw = read_u32(data);
+    float value;
+
+    memcpy(&value, &raw, sizeof(value));
+    return value;
+}
+
+static void frame_received(const uint8_t *frame, size_t length)
+{
+    uint8_t payload[TELEMETRY_FRAME_MAX_SIZE];
+    uint32_t now = os_timestamp_get();
+    size_t size = telemetry_cobs_decode(frame, length, payload);
+
+    if(size >= 3 && payload[0] == TELEMETRY_EDGE_TRACE
+            && telemetry_crc16(payload, size - 2)
+                == (payload[size - 2] | (payload[size - 1] << 8))) {
+        nb_trace_frames++;
+        if(trace_file != NULL) {
+            fwrite(&payload[1], 1, size - 3, trace_file);
+        }
+        return;
+    }
+
+    if(size != TELEMETRY_ROBOT_STATE_SIZE + 2
+            || telemetry_crc16(payload, size - 2)
+                != (payload[size - 2] | (payload[size - 1] << 8))
+            || payload[0] != TELEMETRY_ROBOT_STATE
+            || payload[1] >= NB_ROBOTS) {
+        nb_bad_frames++;
+        return;
+    }
+
+    sim_robot_stats_t *s = &stats[payload[1]];
+    uint8_t flags = payload[2];
+    uint32_t time = read_u32(&payload[3]);
+    double x, y;
+
+    s->nb_frames++;
+    if(flags & TELEMETRY_FLAG_FIX) {
+        s->nb_fixes++;
+        s->tracking = 1;
+    }
+    if(flags & TELEMETRY_FLAG_LOST) {
+        s->nb_lost++;
+    }
+
+    // age of the state when it reaches the host
+    uint32_t age = now - time;
+    s->age_sum += age;
+    s->age_max = age > s->age_max ? age : s->age_max;
+
+    // the filter starts far away, only count once it got a fix
+    if(s->tracking && !(flags & TELEMETRY_FLAG_LOST)) {
+        robot_position(payload[1], time, &x, &y);
+        double error = hypot(read_float(&payload[7]) - x,
+                read_float(&payload[11]) - y);
+        s->nb_errors++;
+        s->error_sum += error;
+        s->error_max = error > s->error_max ? error : s->error_max;
+    }
+}
+
+// decodes what the communication thread writes to stdout
+static void telemetry_main(void *context)
+{
+    int fd = *(int *)context;
+    uint8_t frame[2 * TELEMETRY_FRAME_MAX_SIZE];
+    size_t length = 0;
+    uint8_t c;
+
+    while(read(fd, &c, 1) == 1) {
+        if(c == 0) {
+            frame_received(frame, length);
+            length = 0;
+        } else if(length < sizeof(frame)) {
+            frame[length++] = c;
+        }
+    }
+}
+
+static uint32_t laser_to_os_time(uint32_t timestamp)
+{
+    return timestamp;
+}
+
+void pipeline_fix_hook(void)
+{
+    nb_fixes++;
+}
+
+// stdout is a pipe, writes block instead of dropping
+uint32_t pipeline_output_dropped(void)
+{
+    return 0;
+}
+
+static void report(FILE *out, double duration, double laser_freq)
+{
+    int i;
+
+    fprintf(out, "%g [s] at %g [Hz] per laser, %d laser(s) on %d robot(s)\n",
+            duration, laser_freq, NB_LASERS, NB_ROBOTS);
+    for(i = 0; i < NB_LASERS; i++) {
+        fprintf(out, "laser %d: %u rotations\n",
+                i + 1, sim_lasers[i].nb_rotations);
+    }
+    fprintf(out, "%u fixes, %.1f per second, %u bad frames\n",
+            nb_fixes, nb_fixes / duration, nb_bad_frames);
+    fprintf(out, "%u edge trace frames\n\n", nb_trace_frames);
+
+    fprintf(out, "%-6s %8s %8s %8s %12s %12s %12s %12s\n",
+            "robot", "frames", "fixes", "lost", "mean age", "max age",
+            "mean err", "max err");
+    fprintf(out, "%-6s %8s %8s %8s %12s %12s %12s %12s\n",
+            "", "", "", "", "[ms]", "[ms]", "[mm]", "[mm]");
+    for(i = 0; i < NB_ROBOTS; i++) {
+        const sim_robot_stats_t *s = &stats[i];
+        uint32_t nb_frames = s->nb_frames > 0 ? s->nb_frames : 1;
+        uint32_t nb_errors = s->nb_errors > 0 ? s->nb_errors : 1;
+
+        fprintf(out, "%-6d %8u %8u %8u %12.2f %12.2f %12.2f %12.2f\n",
+                i, s->nb_frames, s->nb_fixes, s->nb_lost,
+                s->age_sum / nb_frames / 1e3, s->age_max / 1e3,
+                s->error_sum / nb_errors * 1e3, s->error_max * 1e3);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double duration = argc > 1 ? atof(argv[1]) : DEFAULT_DURATION;
+    double laser_freq = argc > 2 ? atof(argv[2]) : DEFAULT_LASER_FREQ;
+    static int telemetry_fd;
+    int output[2];
+    FILE *out;
+    int i;
+
+    if(duration <= 0 || laser_freq <= 0) {
+        fprintf(stderr, "usage: %s [duration [s]] [laser frequency [Hz]] "
+                "[trace file]\n", argv[0]);
+        return 1;
+    }
+
+    if(argc > 3) {
+        trace_file = fopen(argv[3], "wb");
+        if(trace_file == NULL) {
+            perror(argv[3]);
+            return 1;
+        }
+        fwrite(EDGE_TRACE_MAGIC, 1, EDGE_TRACE_MAGIC_SIZE, trace_file);
+    }
+
+    // the communication thread writes to stdout, the report goes to the
+    // original one
+    out = fdopen(dup(STDOUT_FILENO), "w");
+    if(out == NULL || pipe(output) != 0
+            || dup2(output[1], STDOUT_FILENO) < 0) {
+        perror("stdout");
+        return 1;
+    }
+    telemetry_fd = output[0];
+
+    os_init();
+
+    pipeline_init();
+
+    for(i = 0; i < NB_LASERS; i++) {
+        sim_laser_t *laser = &sim_lasers[i];
+
+        laser->index = i;
+        laser->period = 1e6 / laser_freq;
+        laser->rng_state = 2463534242u + i;
+        laser->nb_rotations = 0;
+        beacon_angles_init(&laser->angles);
+        beacon_angles_set_minimal_period(&laser->angles,
+                (uint32_t)(laser->period / 2));
+
+        lasers[i].angles = &laser->angles;
+        lasers[i].capture = NULL;
+        lasers[i].timestamp_freq = 1000000;
+        lasers[i].to_os_time = laser_to_os_time;
+    }
+
+    pipeline_start();
+
+    if(trace_file != NULL) {
+        command_t trace = {COMMAND_TRACE, {1.0f}};
+        command_apply(&trace);
+    }
+
+    os_thread_create(&telemetry_thread, telemetry_main, NULL, 0,
+            "Telemetry", 0, &telemetry_fd);
+    for(i = 0; i < NB_LASERS; i++) {
+        os_thread_create(&sim_laser_threads[i], sim_laser_main, NULL, 0,
+                "Laser", 0, &sim_lasers[i]);
+    }
+
+    os_thread_sleep_us((uint32_t)(duration * 1e6));
+
+    report(out, duration, laser_freq);
+    fflush(out);
+    if(trace_file != NULL) {
+        fflush(trace_file);
+    }
+
+    // the threads never return
+    exit(0);
+}
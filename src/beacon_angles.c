@@ -1,7 +1,8 @@
 #include "beacon_angles.h"
-#include <math.h>
+#include "float_math.h"
 #include <stdio.h>
-#include <platform-abstraction/criticalsection.h>
+
+static int calculate_rotation(beacon_angles_t *angles);
 
 void beacon_angles_init(beacon_angles_t *angles)
 {
@@ -9,15 +10,21 @@ void beacon_angles_init(beacon_angles_t *angles)
     angles->_time_b = 0;
     angles->_time_c = 0;
 
-    angles->_time_a_old = 0;
-    angles->_time_b_old = 0;
-    angles->_time_c_old = 0;
-
     angles->_minimal_period = 0;
 
-    angles->alpha = 0.0;
-    angles->beta = 0.0;
-    angles->gamma = 0.0;
+    timestamp_ring_init(&angles->_ring);
+    angles->_trace = NULL;
+    angles->_edge[A] = angles->_edge[B] = angles->_edge[C] = 0;
+    angles->_edge_old[A] = angles->_edge_old[B] = angles->_edge_old[C] = 0;
+
+    angles->alpha = 0.0f;
+    angles->beta = 0.0f;
+    angles->gamma = 0.0f;
+
+    angles->delta_alpha = 0;
+    angles->delta_beta = 0;
+    angles->delta_gamma = 0;
+    angles->timestamp = 0;
 
     os_mutex_init(&angles->access);
     os_semaphore_init(&angles->measurement_ready, 0);
@@ -27,24 +34,30 @@ void beacon_angles_update_timestamp(beacon_angles_t *angles,
                                     enum beacon_nb beacon,
                                     uint32_t time)
 {
+    timestamp_ring_t *trace = angles->_trace;
+
+    if(trace != NULL){
+        timestamp_ring_push(trace, beacon, time);
+    }
+
     switch (beacon) {
         case A:
             if((time - angles->_time_a) > angles->_minimal_period){
-                angles->_time_a_old = angles->_time_a;
                 angles->_time_a = time;
+                timestamp_ring_push(&angles->_ring, A, time);
                 os_semaphore_signal(&angles->measurement_ready);
             }
             break;
         case B:
             if((time - angles->_time_b) > angles->_minimal_period){
-                angles->_time_b_old = angles->_time_b;
                 angles->_time_b = time;
+                timestamp_ring_push(&angles->_ring, B, time);
             }
             break;
         case C:
             if((time - angles->_time_c) > angles->_minimal_period){
-                angles->_time_c_old = angles->_time_c;
                 angles->_time_c = time;
+                timestamp_ring_push(&angles->_ring, C, time);
             }
             break;
     }
@@ -55,25 +68,47 @@ void beacon_angles_set_minimal_period(beacon_angles_t *angles, uint32_t period)
     angles->_minimal_period = period;
 }
 
+uint32_t beacon_angles_get_minimal_period(const beacon_angles_t *angles)
+{
+    return angles->_minimal_period;
+}
+
+void beacon_angles_set_trace(beacon_angles_t *angles, timestamp_ring_t *trace)
+{
+    angles->_trace = trace;
+}
+
 int beacon_angles_calculate(beacon_angles_t *angles)
 {
-    uint32_t my_time_a;
-    uint32_t my_time_b;
-    uint32_t my_time_c;
-    uint32_t my_time_a_old;
-    uint32_t my_time_b_old;
-    uint32_t my_time_c_old;
-
-    CRITICAL_SECTION_ALLOC()
-
-    CRITICAL_SECTION_ENTER()
-    my_time_a     = angles->_time_a;
-    my_time_b     = angles->_time_b;
-    my_time_c     = angles->_time_c;
-    my_time_a_old = angles->_time_a_old;
-    my_time_b_old = angles->_time_b_old;
-    my_time_c_old = angles->_time_c_old;
-    CRITICAL_SECTION_EXIT()
+    timestamp_event_t event;
+
+    // drain edges until one of beacon A closes a valid rotation, what comes
+    // after it stays queued for the next call so no rotation is lost when
+    // the calling thread lags behind
+    while(timestamp_ring_pop(&angles->_ring, &event)){
+        if(event.beacon > C){
+            continue;
+        }
+
+        angles->_edge_old[event.beacon] = angles->_edge[event.beacon];
+        angles->_edge[event.beacon] = event.time;
+
+        if(event.beacon == A && calculate_rotation(angles)){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int calculate_rotation(beacon_angles_t *angles)
+{
+    uint32_t my_time_a     = angles->_edge[A];
+    uint32_t my_time_b     = angles->_edge[B];
+    uint32_t my_time_c     = angles->_edge[C];
+    uint32_t my_time_a_old = angles->_edge_old[A];
+    uint32_t my_time_b_old = angles->_edge_old[B];
+    uint32_t my_time_c_old = angles->_edge_old[C];
 
     if((my_time_a - my_time_b_old > my_time_a - my_time_c_old)
         && (my_time_a - my_time_c_old > my_time_a - my_time_a_old)
@@ -83,12 +118,16 @@ int beacon_angles_calculate(beacon_angles_t *angles)
         float period;
 
         period = my_time_a - my_time_a_old;
-        period /= 2 * M_PI;
+        period /= FLOAT_2_PI;
 
         os_mutex_take(&angles->access);
         angles->alpha = (my_time_c - my_time_b) / period;
         angles->beta = (my_time_a - my_time_c) / period;
         angles->gamma = (my_time_b - my_time_a_old) / period;
+        angles->delta_alpha = my_time_c - my_time_b;
+        angles->delta_beta = my_time_a - my_time_c;
+        angles->delta_gamma = my_time_b - my_time_a_old;
+        angles->timestamp = my_time_a;
         os_mutex_release(&angles->access);
 
         return true;
@@ -13,17 +13,30 @@ extern "C" {
 #include <platform-abstraction/semaphore.h>
 #include <platform-abstraction/mutex.h>
 
+#include "timestamp_ring.h"
+
 typedef struct {
+    // last accepted edge of every beacon, only used by the interrupt
+    // handlers to reject edges closer than _minimal_period
     uint32_t _time_a;
     uint32_t _time_b;
     uint32_t _time_c;
 
-    uint32_t _time_a_old;
-    uint32_t _time_b_old;
-    uint32_t _time_c_old;
-
     uint32_t _minimal_period;
 
+    // accepted edges, pushed from interrupt context and drained by
+    // beacon_angles_calculate
+    timestamp_ring_t _ring;
+
+    // every edge received is also pushed there if it isn't NULL, see
+    // beacon_angles_set_trace
+    timestamp_ring_t * volatile _trace;
+
+    // latest and previous edge of every beacon as drained from _ring,
+    // indexed by enum beacon_nb
+    uint32_t _edge[3];
+    uint32_t _edge_old[3];
+
     mutex_t access;
     semaphore_t measurement_ready;
 
@@ -31,6 +44,15 @@ typedef struct {
     float beta;
     float gamma;
 
+    // raw time deltas the angles were computed from (same unit as the
+    // timestamps), set together with the angles
+    uint32_t delta_alpha;
+    uint32_t delta_beta;
+    uint32_t delta_gamma;
+
+    // edge of beacon A closing the rotation the angles were computed from
+    uint32_t timestamp;
+
 } beacon_angles_t;
 
 
@@ -44,6 +66,12 @@ void beacon_angles_update_timestamp(beacon_angles_t *angles,
                                     uint32_t time);
 
 void beacon_angles_set_minimal_period(beacon_angles_t *angles, uint32_t period);
+uint32_t beacon_angles_get_minimal_period(const beacon_angles_t *angles);
+
+// records every edge given to beacon_angles_update_timestamp to 'trace',
+// before the minimal period filter, NULL stops the recording. the caller of
+// beacon_angles_update_timestamp is the producer of 'trace'
+void beacon_angles_set_trace(beacon_angles_t *angles, timestamp_ring_t *trace);
 int beacon_angles_calculate(beacon_angles_t *angles);
 
 #ifdef __cplusplus
@@ -8,6 +8,20 @@
 
 #define KALMAN_TRANS_FREQ    (50)        // [Hz]
 
+// set to 1 to fuse every fix as soon as it is available (stamped with the
+// time of its last edge), with predictions at KALMAN_TRANS_FREQ in between.
+// set to 0 to poll for fixes at KALMAN_TRANS_FREQ
+#define KALMAN_EVENT_DRIVEN  (1)
+
+// how the fixes of both lasers are filtered
+// LASER_FUSION_JOINT: both lasers are on one robot, their fixes update the
+//                     same filter (twice the measurement rate)
+// LASER_FUSION_SEPARATE: every laser is on its own robot with its own
+//                        filter, the output carries both robots
+#define LASER_FUSION_JOINT      (0)
+#define LASER_FUSION_SEPARATE   (1)
+#define LASER_FUSION_MODE       LASER_FUSION_JOINT
+
 #define BEACON_POS_A    {3.0f, 1.0f}    // {[m], [m]}
 #define BEACON_POS_B    {0.0f, 2.0f}    // {[m], [m]}
 #define BEACON_POS_C    {0.0f, 0.0f}    // {[m], [m]}
@@ -15,10 +29,79 @@
 #define MAX_ACC (1.0f)  // [m/s/s]
 #define PROC_NOISE_PROP (0.0625f)
 
+// wheel odometry received with the odom command (see command.h) drives
+// the kalman prediction, it is dropped once older than ODOMETRY_TIMEOUT
+#define ODOMETRY_VAR        (0.05f * 0.05f) // [m^2/s^2] per velocity axis
+#define ODOMETRY_TIMEOUT    (200000)        // [us]
+
 #define MEAS_VAR_X (0.05f * 0.05f)  // [m^2]
 #define MEAS_VAR_Y (0.05f * 0.05f)  // [m^2]
 #define MEAS_COV_XY (0.0f)
 
-#define OUTPUT_FREQ     (10)    // [Hz]
+// set to 1 to fuse every fix with its own covariance, propagated from the
+// jitter of the edge times through the geometry of the beacons (see
+// positioning_from_angles_with_covariance), instead of MEAS_VAR_X/Y and
+// MEAS_COV_XY. fixes near the circle of the beacons are then weighted down
+// instead of dropped, those above MEAS_VAR_MAX (var_x + var_y) still are.
+// MEAS_VAR_MIN is added to var_x and var_y for the errors the jitter
+// doesn't cover (beacon placement, laser mounting), the cov command
+// replaces it
+#define MEAS_COV_FROM_GEOMETRY  (1)
+#define MEAS_VAR_EDGE_TIME      (10e-6f * 10e-6f)   // [s^2]
+#define MEAS_VAR_MIN            (0.005f * 0.005f)   // [m^2]
+#define MEAS_VAR_MAX            (0.25f * 0.25f)     // [m^2]
+
+// steady-state kalman gain, see kalman_enable_steady_state
+#define KALMAN_STEADY_STATE_DT_TOL      (0.05f) // relative to nominal delta_t
+#define KALMAN_STEADY_STATE_GAIN_EPS    (1e-5f)
+#define KALMAN_STEADY_STATE_MAX_ITER    (1000)
+
+// set to 1 to filter the raw beacon time deltas with the EKF instead of
+// triangulating every fix and filtering positions. needs
+// LASER_FUSION_SEPARATE, the EKF tracks the rotation speed of one laser
+#define KALMAN_USE_EKF  (0)
+
+// set to 1 to triangulate and filter with the integer only
+// implementations (positioning_q.h, kalman_q.h), for boards without FPU or
+// to get data independent timing. can't be combined with KALMAN_USE_EKF
+#define BEACON_FIXED_POINT  (0)
+
+#define EKF_INIT_OMEGA      (2.0f * 3.14159f * 10.0f)   // [rad/s]
+#define EKF_INIT_OMEGA_VAR  (10.0f * 10.0f)             // [rad^2/s^2]
+#define EKF_OMEGA_NOISE     (0.1f)                      // [rad^2/s^3]
+#define EKF_MEAS_VAR_DT     (10e-6f * 10e-6f)           // [s^2]
+#define EKF_MIN_BEACON_DIST_SQ  (0.01f * 0.01f)         // [m^2]
+
+// the edges of laser one are latched by TIM2 input captures and copied by
+// DMA, the thread collects them on the capture interrupt of beacon A and
+// at least every BEACON_CAPTURE_POLL_PERIOD
+#define BEACON_CAPTURE_FREQ         (8000000)   // [Hz], timestamp resolution
+#define BEACON_CAPTURE_BUFFER_SIZE  (16)        // edges per beacon
+#define BEACON_CAPTURE_POLL_PERIOD  (100000)    // [us]
+
+// a telemetry frame is 31 bytes, UART1_BAUDRATE carries up to 61 frames
+// per second. one frame goes out every 1 / OUTPUT_FREQ, the robots take
+// turns: 25 [Hz] per robot with LASER_FUSION_SEPARATE. pipeline.c checks
+// that OUTPUT_FREQ fits
+#define UART1_BAUDRATE      (19200)     // [baud], stdout
+#define OUTPUT_FREQ         (50)        // [Hz]
+// a robot without fix for this long is flagged TELEMETRY_FLAG_LOST
+#define OUTPUT_LOST_TIME    (1000000)   // [us]
+// while the edges are traced (trace command) the link only carries the
+// trace, 5 bytes per edge, and every TRACE_SYNC_PERIOD the os time of an
+// edge of each laser
+#define TRACE_SYNC_PERIOD   (1000000)   // [us]
+
+// what a write to a UART does with the bytes that don't fit in its
+// transmit ring (BYTE_RING_DROP_NEW, BYTE_RING_DROP_OLDEST or
+// BYTE_RING_BLOCK), see byte_ring.h. a blocked write checks for room every
+// UART_TX_BLOCK_POLL_PERIOD
+#define UART1_TX_POLICY             BYTE_RING_DROP_OLDEST   // stdout, telemetry
+#define UART2_TX_POLICY             BYTE_RING_BLOCK         // stderr, st-link
+#define UART_TX_BLOCK_POLL_PERIOD   (1000)                  // [us]
+
+// a read of a UART with nothing received checks again every
+// UART_RX_POLL_PERIOD, bytes received while the ring is full are dropped
+#define UART_RX_POLL_PERIOD         (10000)                 // [us]
 
 #endif
@@ -0,0 +1,84 @@
+#include <stdbool.h>
+
+#include "byte_ring.h"
+
+#define BYTE_RING_MASK (BYTE_RING_SIZE - 1)
+
+void byte_ring_init(byte_ring_t *ring)
+{
+    ring->_head = 0;
+    ring->_tail = 0;
+    ring->_dropped = 0;
+}
+
+size_t byte_ring_write(byte_ring_t *ring,
+                     const void *data,
+                     size_t length,
+                     int policy)
+{
+    const uint8_t *bytes = data;
+    uint32_t head = ring->_head;
+    uint32_t tail = __atomic_load_n(&ring->_tail, __ATOMIC_ACQUIRE);
+    size_t skipped = 0;
+    size_t count = length;
+    size_t i;
+
+    if(policy == BYTE_RING_DROP_OLDEST){
+        // only the end of a write longer than the ring is kept
+        if(count > BYTE_RING_SIZE){
+            skipped = count - BYTE_RING_SIZE;
+            count = BYTE_RING_SIZE;
+        }
+
+        // the slots are only overwritten once _tail moved past them, a
+        // concurrent pop of one of them fails its compare and swap
+        while(head - tail + count > BYTE_RING_SIZE){
+            uint32_t new_tail = head + count - BYTE_RING_SIZE;
+            if(__atomic_compare_exchange_n(&ring->_tail, &tail, new_tail,
+                        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+                ring->_dropped += new_tail - tail;
+                break;
+            }
+        }
+        ring->_dropped += skipped;
+    } else if(head - tail + count > BYTE_RING_SIZE){
+        count = BYTE_RING_SIZE - (head - tail);
+        if(policy == BYTE_RING_DROP_NEW){
+            ring->_dropped += length - count;
+        }
+    }
+
+    for(i = 0; i < count; i++){
+        ring->_data[(head + i) & BYTE_RING_MASK] = bytes[skipped + i];
+    }
+
+    // the bytes must be in place before the consumer can see them
+    __atomic_store_n(&ring->_head, head + count, __ATOMIC_RELEASE);
+
+    if(policy == BYTE_RING_BLOCK){
+        return count;
+    }
+
+    return length;
+}
+
+uint8_t byte_ring_pop(byte_ring_t *ring, uint8_t *byte)
+{
+    uint32_t tail = __atomic_load_n(&ring->_tail, __ATOMIC_ACQUIRE);
+
+    // the producer may drop the byte while it is read, start over then
+    do {
+        if(tail == __atomic_load_n(&ring->_head, __ATOMIC_ACQUIRE)){
+            return 0;
+        }
+        *byte = ring->_data[tail & BYTE_RING_MASK];
+    } while(!__atomic_compare_exchange_n(&ring->_tail, &tail, tail + 1,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return 1;
+}
+
+uint32_t byte_ring_dropped(const byte_ring_t *ring)
+{
+    return ring->_dropped;
+}
@@ -0,0 +1,60 @@
+#ifndef BYTE_RING_H_
+#define BYTE_RING_H_
+/*
+ * Lock-free single-producer/single-consumer ring of bytes between a thread
+ * and a UART interrupt: the thread writes to the transmit ring and the
+ * interrupt empties it, the interrupt fills the receive ring and the thread
+ * reads it. Both sides advance the read counter with a compare and swap,
+ * so the producer can drop the oldest bytes without disabling interrupts.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// number of bytes the ring can hold, must be a power of 2
+#define BYTE_RING_SIZE (256)
+
+// what byte_ring_write does with bytes that don't fit
+#define BYTE_RING_DROP_NEW    (0) // drops them
+#define BYTE_RING_DROP_OLDEST (1) // drops the oldest queued bytes instead
+#define BYTE_RING_BLOCK       (2) // leaves them to the caller
+
+// all zero is an empty ring
+typedef struct {
+    uint8_t _data[BYTE_RING_SIZE];
+
+    // free running counters, _head is only written by the producer
+    uint32_t _head;
+    uint32_t _tail;
+
+    // bytes dropped because the ring was full
+    uint32_t _dropped;
+} byte_ring_t;
+
+void byte_ring_init(byte_ring_t *ring);
+
+// producer side, queues the 'length' bytes of 'data' and handles what
+// doesn't fit according to 'policy'
+//
+// return the number of bytes of 'data' that are done with (queued or
+// dropped), less than 'length' only with BYTE_RING_BLOCK
+size_t byte_ring_write(byte_ring_t *ring,
+                     const void *data,
+                     size_t length,
+                     int policy);
+
+// consumer side, return 1 if the oldest byte was moved to 'byte',
+// 0 if the ring is empty
+uint8_t byte_ring_pop(byte_ring_t *ring, uint8_t *byte);
+
+uint32_t byte_ring_dropped(const byte_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,188 @@
+#include <string.h>
+#include <math.h>
+
+#include "command.h"
+
+typedef struct {
+    const char *name;
+    command_id_t id;
+    uint8_t nb_args;
+} command_desc_t;
+
+static const command_desc_t commands[] = {
+    {"cov", COMMAND_MEAS_COV, 3},
+    {"acc", COMMAND_MAX_ACC, 1},
+    {"noise", COMMAND_PROC_NOISE, 1},
+    {"period", COMMAND_MIN_PERIOD, 2},
+    {"odom", COMMAND_ODOMETRY, 4},
+    {"trace", COMMAND_TRACE, 1},
+};
+
+#define NB_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+static const char *skip_spaces(const char *s);
+static const char *parse_float(const char *s, float *value);
+
+uint8_t command_parse(const char *line, command_t *command)
+{
+    const char *s;
+    size_t name_length = 0;
+    size_t i;
+    uint8_t arg;
+
+    if(line == NULL || command == NULL){
+        return 0;
+    }
+
+    s = skip_spaces(line);
+
+    while(s[name_length] != '\0' && s[name_length] != ' '){
+        name_length++;
+    }
+
+    for(i = 0; i < NB_COMMANDS; i++){
+        if(strlen(commands[i].name) == name_length
+                && strncmp(commands[i].name, s, name_length) == 0){
+            break;
+        }
+    }
+    if(i == NB_COMMANDS){
+        return 0;
+    }
+    s += name_length;
+
+    for(arg = 0; arg < commands[i].nb_args; arg++){
+        // arguments are separated from what comes before by a space
+        if(*s != ' '){
+            return 0;
+        }
+        s = parse_float(skip_spaces(s), &command->args[arg]);
+        if(s == NULL){
+            return 0;
+        }
+    }
+
+    if(*skip_spaces(s) != '\0'){
+        return 0;
+    }
+
+    command->id = commands[i].id;
+
+    return 1;
+}
+
+void command_reader_init(command_reader_t *reader)
+{
+    reader->_length = 0;
+    reader->_overflow = 0;
+}
+
+const char *command_reader_feed(command_reader_t *reader, char c)
+{
+    if(c == '\n' || c == '\r'){
+        uint8_t complete = !reader->_overflow;
+        uint32_t length = reader->_length;
+
+        reader->_length = 0;
+        reader->_overflow = 0;
+
+        // the '\n' of a "\r\n" ending is an empty line, ignore it
+        if(complete && length > 0){
+            reader->_line[length] = '\0';
+            return reader->_line;
+        }
+        return NULL;
+    }
+
+    if(reader->_length + 1 >= COMMAND_LINE_SIZE){
+        reader->_overflow = 1;
+    } else{
+        reader->_line[reader->_length++] = c;
+    }
+
+    return NULL;
+}
+
+static const char *skip_spaces(const char *s)
+{
+    while(*s == ' '){
+        s++;
+    }
+    return s;
+}
+
+// [+-]digits[.digits][(e|E)[+-]digits], at least one digit in the
+// mantissa. avoids strtof which pulls the heavyweight newlib number
+// conversion and its stack usage into the command thread
+//
+// return a pointer past the number, NULL if there is none or it doesn't
+// fit in a float
+static const char *parse_float(const char *s, float *value)
+{
+    uint32_t mantissa = 0;
+    int exponent = 0;
+    int nb_digits = 0;
+    int negative = 0;
+    float result;
+
+    if(*s == '+' || *s == '-'){
+        negative = (*s == '-');
+        s++;
+    }
+
+    for(; *s >= '0' && *s <= '9'; s++, nb_digits++){
+        // digits beyond float precision only scale the value
+        if(mantissa < 100000000){
+            mantissa = 10 * mantissa + (*s - '0');
+        } else{
+            exponent++;
+        }
+    }
+    if(*s == '.'){
+        for(s++; *s >= '0' && *s <= '9'; s++, nb_digits++){
+            if(mantissa < 100000000){
+                mantissa = 10 * mantissa + (*s - '0');
+                exponent--;
+            }
+        }
+    }
+    if(nb_digits == 0){
+        return NULL;
+    }
+
+    if(*s == 'e' || *s == 'E'){
+        int exp_negative = 0;
+        int exp_value = 0;
+        int exp_digits = 0;
+
+        s++;
+        if(*s == '+' || *s == '-'){
+            exp_negative = (*s == '-');
+            s++;
+        }
+        for(; *s >= '0' && *s <= '9'; s++, exp_digits++){
+            if(exp_value < 100){
+                exp_value = 10 * exp_value + (*s - '0');
+            }
+        }
+        if(exp_digits == 0){
+            return NULL;
+        }
+        exponent += exp_negative ? -exp_value : exp_value;
+    }
+
+    result = (float)mantissa;
+    for(; exponent > 0; exponent--){
+        result *= 10.0f;
+    }
+    for(; exponent < 0; exponent++){
+        result /= 10.0f;
+    }
+    if(!isfinite(result)){
+        return NULL;
+    }
+
+    *value = negative ? -result : result;
+
+    return s;
+}
@@ -0,0 +1,74 @@
+#ifndef COMMAND_H_
+#define COMMAND_H_
+/*
+ * Text commands to tune the filters at runtime, one per line, arguments
+ * separated by spaces:
+ *
+ *   cov <var_x> <var_y> <cov_xy>   measurement covariance [m^2], positive
+ *                                  definite. with MEAS_COV_FROM_GEOMETRY
+ *                                  added to the covariance of every fix
+ *   acc <max_acc>                  maximal acceleration [m/s/s]
+ *   noise <proportionality>        process noise proportionality
+ *   period <laser> <period>        minimal period between two edges of a
+ *                                  beacon, laser 1 or 2 [us]
+ *   odom <robot> <age> <v_x> <v_y> velocity of a robot from its wheel
+ *                                  odometry [m/s] (table frame), measured
+ *                                  <age> before the line ended [us]. robot
+ *                                  as numbered in the telemetry
+ *   trace <enable>                 1 sends the edges of both lasers in
+ *                                  edge trace telemetry frames, 0 stops
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define COMMAND_MAX_ARGS    (4)
+// longest line, line ending included, longer lines are discarded
+#define COMMAND_LINE_SIZE   (64)
+
+typedef enum {
+    COMMAND_MEAS_COV,
+    COMMAND_MAX_ACC,
+    COMMAND_PROC_NOISE,
+    COMMAND_MIN_PERIOD,
+    COMMAND_ODOMETRY,
+    COMMAND_TRACE,
+} command_id_t;
+
+typedef struct {
+    command_id_t id;
+    float args[COMMAND_MAX_ARGS];
+} command_t;
+
+// WARNING : this type should be opaque, its only here to
+// allow static allocation by user
+typedef struct {
+    char _line[COMMAND_LINE_SIZE];
+    uint32_t _length;
+    // the current line is too long, skip it up to its end
+    uint8_t _overflow;
+} command_reader_t;
+
+// parses the null terminated 'line' to 'command'
+//
+// return 1 on success
+// return 0 if the line isn't a known command with the right number of
+// valid arguments, a number too large for a float isn't valid
+uint8_t command_parse(const char *line, command_t *command);
+
+void command_reader_init(command_reader_t *reader);
+
+// assembles lines from the received bytes, "\n", "\r" and "\r\n" end a line
+//
+// return the null terminated line 'c' completed, valid until the next call
+// return NULL if no line was completed
+const char *command_reader_feed(command_reader_t *reader, char c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
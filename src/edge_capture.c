@@ -0,0 +1,117 @@
+#include <stddef.h>
+
+#include "edge_capture.h"
+
+bool edge_capture_init(edge_capture_t *capture,
+                       const volatile uint32_t *buffer_a,
+                       const volatile uint32_t *buffer_b,
+                       const volatile uint32_t *buffer_c,
+                       uint32_t size,
+                       edge_capture_write_index_t write_index,
+                       void *context)
+{
+    int beacon;
+
+    if(capture == NULL || buffer_a == NULL || buffer_b == NULL
+            || buffer_c == NULL || size == 0 || write_index == NULL){
+        return false;
+    }
+
+    capture->_buffers[A] = buffer_a;
+    capture->_buffers[B] = buffer_b;
+    capture->_buffers[C] = buffer_c;
+    capture->_size = size;
+    capture->_write_index = write_index;
+    capture->_context = context;
+    capture->_dropped = 0;
+
+    // start with whatever the producer already wrote
+    for(beacon = A; beacon <= C; beacon++){
+        uint32_t read = write_index(context, (enum beacon_nb)beacon) % size;
+
+        capture->_read_index[beacon] = read;
+        capture->_last[beacon] =
+            capture->_buffers[beacon][(read + size - 1) % size];
+    }
+
+    os_semaphore_init(&capture->_captured, 0);
+
+    return true;
+}
+
+void edge_capture_signal(edge_capture_t *capture)
+{
+    os_semaphore_signal(&capture->_captured);
+}
+
+bool edge_capture_wait(edge_capture_t *capture, uint32_t timeout_us)
+{
+    return os_semaphore_wait_timeout(&capture->_captured, timeout_us);
+}
+
+uint32_t edge_capture_drain(edge_capture_t *capture, beacon_angles_t *angles)
+{
+    const uint32_t size = capture->_size;
+    uint32_t pending[3];
+    uint32_t nb_edges = 0;
+    int beacon;
+
+    // snapshot of the producer, edges captured from now on wait for the
+    // next call
+    for(beacon = A; beacon <= C; beacon++){
+        uint32_t write = capture->_write_index(capture->_context,
+                                               (enum beacon_nb)beacon) % size;
+        uint32_t read = capture->_read_index[beacon];
+        uint32_t last = capture->_buffers[beacon][(read + size - 1) % size];
+
+        pending[beacon] = (write + size - read) % size;
+
+        // the slot of the last edge drained was overwritten, the producer
+        // lapped the buffer: it holds the 'size' newest edges, oldest at
+        // 'write', and the edges written over the ones not drained yet are
+        // lost
+        if(last != capture->_last[beacon]){
+            capture->_dropped += pending[beacon];
+            capture->_read_index[beacon] = write;
+            pending[beacon] = size;
+        }
+    }
+
+    while(1){
+        int oldest = -1;
+        uint32_t oldest_time = 0;
+
+        for(beacon = A; beacon <= C; beacon++){
+            if(pending[beacon] == 0){
+                continue;
+            }
+
+            // the timer wraps around, compare the difference
+            uint32_t time =
+                capture->_buffers[beacon][capture->_read_index[beacon]];
+            if(oldest < 0 || (int32_t)(time - oldest_time) < 0){
+                oldest = beacon;
+                oldest_time = time;
+            }
+        }
+
+        if(oldest < 0){
+            break;
+        }
+
+        capture->_read_index[oldest] =
+            (capture->_read_index[oldest] + 1) % size;
+        capture->_last[oldest] = oldest_time;
+        pending[oldest]--;
+        beacon_angles_update_timestamp(angles, (enum beacon_nb)oldest,
+                                       oldest_time);
+        nb_edges++;
+    }
+
+    return nb_edges;
+}
+
+uint32_t edge_capture_dropped(const edge_capture_t *capture)
+{
+    return capture->_dropped;
+}
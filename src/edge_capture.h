@@ -0,0 +1,88 @@
+#ifndef EDGE_CAPTURE_H_
+#define EDGE_CAPTURE_H_
+/*
+ * Hardware independent side of the beacon edge timestamping. Edges are
+ * latched by a timer input capture and written to one circular buffer per
+ * beacon by a producer (DMA on the target, a fake on the host) without any
+ * CPU involvement. edge_capture_drain merges the new entries of the three
+ * buffers in time order and feeds them to beacon_angles. The target calls
+ * edge_capture_signal from the capture interrupt of beacon A, which wakes
+ * up the thread waiting in edge_capture_wait.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <platform-abstraction/semaphore.h>
+
+#include "beacon_angles.h"
+
+// returns the index of the slot the producer will write next in the buffer
+// of 'beacon', for a DMA in circular mode: size - remaining transfers
+typedef uint32_t (*edge_capture_write_index_t)(void *context,
+                                               enum beacon_nb beacon);
+
+typedef struct {
+    const volatile uint32_t *_buffers[3];
+    uint32_t _size;
+
+    edge_capture_write_index_t _write_index;
+    void *_context;
+
+    // next slot to read per beacon, indexed by enum beacon_nb
+    uint32_t _read_index[3];
+
+    // last timestamp drained per beacon, it stays in the slot before
+    // _read_index until the producer laps the buffer
+    uint32_t _last[3];
+
+    // edges overwritten before they were drained
+    uint32_t _dropped;
+
+    // signaled by the capture interrupt of beacon A
+    semaphore_t _captured;
+} edge_capture_t;
+
+// 'buffer_a', 'buffer_b' and 'buffer_c' hold 'size' timestamps each
+//
+// return true on success, false if a pointer is NULL or 'size' is 0
+bool edge_capture_init(edge_capture_t *capture,
+                       const volatile uint32_t *buffer_a,
+                       const volatile uint32_t *buffer_b,
+                       const volatile uint32_t *buffer_c,
+                       uint32_t size,
+                       edge_capture_write_index_t write_index,
+                       void *context);
+
+// wakes up edge_capture_wait, called from interrupt context when beacon A
+// is captured
+void edge_capture_signal(edge_capture_t *capture);
+
+// waits for edge_capture_signal, at most 'timeout_us'
+//
+// return true if it was signaled
+bool edge_capture_wait(edge_capture_t *capture, uint32_t timeout_us);
+
+// passes every edge captured since the last call to
+// beacon_angles_update_timestamp, oldest first
+//
+// a buffer the producer lapped since the last call is passed on whole, the
+// edges overwritten are counted in edge_capture_dropped. the producer must
+// not write 'size' edges of a beacon while this runs
+//
+// returns the number of edges passed on
+uint32_t edge_capture_drain(edge_capture_t *capture, beacon_angles_t *angles);
+
+// number of edges overwritten by the producer before they were drained, at
+// least: a buffer lapped more than once between two calls of
+// edge_capture_drain is counted as lapped once
+uint32_t edge_capture_dropped(const edge_capture_t *capture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+#include "edge_trace.h"
+
+static uint8_t *put_u32(uint8_t *dest, uint32_t value);
+static uint32_t get_u32(const uint8_t *data);
+
+size_t edge_trace_record_size(edge_trace_kind_t kind)
+{
+    switch(kind){
+        case EDGE_TRACE_EDGE_A:
+        case EDGE_TRACE_EDGE_B:
+        case EDGE_TRACE_EDGE_C:
+        case EDGE_TRACE_SYNC:
+        case EDGE_TRACE_DROPPED:
+            return 5;
+        case EDGE_TRACE_CONFIG:
+            return 9;
+    }
+
+    return 0;
+}
+
+size_t edge_trace_encode(const edge_trace_record_t *record, uint8_t *dest)
+{
+    size_t size = edge_trace_record_size(record->kind);
+    uint8_t *p = dest;
+
+    if(size == 0 || record->laser > 0x0f){
+        return 0;
+    }
+
+    *p++ = (record->laser << 4) | record->kind;
+    p = put_u32(p, record->args[0]);
+    if(size == 9){
+        put_u32(p, record->args[1]);
+    }
+
+    return size;
+}
+
+size_t edge_trace_decode(const uint8_t *data, size_t length,
+                         edge_trace_record_t *record)
+{
+    if(length == 0){
+        return 0;
+    }
+
+    edge_trace_kind_t kind = (edge_trace_kind_t)(data[0] & 0x0f);
+    size_t size = edge_trace_record_size(kind);
+
+    if(size == 0 || size > length){
+        return 0;
+    }
+
+    record->laser = data[0] >> 4;
+    record->kind = kind;
+    record->args[0] = get_u32(&data[1]);
+    record->args[1] = size == 9 ? get_u32(&data[5]) : 0;
+
+    return size;
+}
+
+static uint8_t *put_u32(uint8_t *dest, uint32_t value)
+{
+    dest[0] = value & 0xff;
+    dest[1] = (value >> 8) & 0xff;
+    dest[2] = (value >> 16) & 0xff;
+    dest[3] = value >> 24;
+
+    return dest + 4;
+}
+
+static uint32_t get_u32(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8) | ((uint32_t)data[2] << 16)
+        | ((uint32_t)data[3] << 24);
+}
@@ -0,0 +1,74 @@
+#ifndef EDGE_TRACE_H_
+#define EDGE_TRACE_H_
+/*
+ * Compact binary trace of the laser edges, so a host can replay exactly
+ * the timestamps the beacon angles of the board were fed, see
+ * simulator/replay.c.
+ *
+ * A trace is EDGE_TRACE_MAGIC followed by records. A record is a tag byte,
+ * laser << 4 | kind, followed by the little-endian uint32 arguments of its
+ * kind:
+ *
+ *   EDGE_TRACE_EDGE_A/B/C  time           timestamp of an edge on the input
+ *                                         of beacon A, B or C, before the
+ *                                         minimal period filter
+ *   EDGE_TRACE_SYNC        os_time        [us] os_timestamp_get time of the
+ *                                         next edge of the laser
+ *   EDGE_TRACE_CONFIG      freq, period   frequency [Hz] of the timestamps
+ *                                         and minimal period of the laser
+ *   EDGE_TRACE_DROPPED     count          edges of the laser lost since its
+ *                                         previous record
+ *
+ * The board sends the records in TELEMETRY_EDGE_TRACE frames, a trace file
+ * is the magic followed by the records of every frame.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define EDGE_TRACE_MAGIC            "BTR1"
+#define EDGE_TRACE_MAGIC_SIZE       (4)
+#define EDGE_TRACE_RECORD_MAX_SIZE  (9)
+
+typedef enum {
+    // same values as enum beacon_nb
+    EDGE_TRACE_EDGE_A,
+    EDGE_TRACE_EDGE_B,
+    EDGE_TRACE_EDGE_C,
+    EDGE_TRACE_SYNC,
+    EDGE_TRACE_CONFIG,
+    EDGE_TRACE_DROPPED,
+} edge_trace_kind_t;
+
+typedef struct {
+    uint8_t laser;
+    edge_trace_kind_t kind;
+    uint32_t args[2];
+} edge_trace_record_t;
+
+// return the size of a record of 'kind', tag included, 0 if it is unknown
+size_t edge_trace_record_size(edge_trace_kind_t kind);
+
+// writes 'record' to 'dest', which holds at least
+// EDGE_TRACE_RECORD_MAX_SIZE bytes
+//
+// return the size of the record, 0 if its kind or laser (up to 15) is
+// invalid
+size_t edge_trace_encode(const edge_trace_record_t *record, uint8_t *dest);
+
+// reads the record at the beginning of the 'length' bytes of 'data'
+//
+// return the number of bytes used, 0 if the record is truncated or of an
+// unknown kind
+size_t edge_trace_decode(const uint8_t *data, size_t length,
+                         edge_trace_record_t *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
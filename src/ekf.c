@@ -0,0 +1,305 @@
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "ekf.h"
+#include "beacon_config.h"
+#include "float_math.h"
+
+// indices into the state vector
+enum {
+    X = 0,
+    Y,
+    V_X,
+    V_Y,
+    OMEGA
+};
+
+// public function prototypes
+uint8_t ekf_init(
+        ekf_robot_handle_t * handle,
+        const robot_pos_t * initial_config,
+        float omega,
+        const reference_triangle_t * t);
+uint8_t ekf_update(
+        ekf_robot_handle_t * handle,
+        const ekf_measurement_t * measurement,
+        float delta_t,
+        robot_pos_t * dest);
+uint8_t ekf_set_measurement_variance(
+        ekf_robot_handle_t * handle,
+        float variance);
+uint8_t ekf_set_max_acc(
+        ekf_robot_handle_t * handle,
+        float max_acc);
+uint8_t ekf_get_omega(
+        ekf_robot_handle_t * handle,
+        float * omega);
+
+// private function prototypes
+static void predict(ekf_robot_handle_t * handle, float delta_t);
+static void scalar_update(
+        ekf_robot_handle_t * handle,
+        const position_t * first,
+        const position_t * second,
+        float measured_dt);
+static float wrap_angle(float angle);
+
+
+// public function implementations
+
+uint8_t ekf_init(
+        ekf_robot_handle_t * handle,
+        const robot_pos_t * initial_config,
+        float omega,
+        const reference_triangle_t * t)
+{
+    // verify input
+    if(handle == NULL || initial_config == NULL || t == NULL || omega <= 0.0f) {
+        return 0;
+    }
+
+    os_mutex_init(&(handle->_mutex));
+
+    os_mutex_take(&(handle->_mutex));
+
+    // set initial state, robot is assumed to stand still
+    handle->_state[X] = initial_config->x;
+    handle->_state[Y] = initial_config->y;
+    handle->_state[V_X] = 0.0f;
+    handle->_state[V_Y] = 0.0f;
+    handle->_state[OMEGA] = omega;
+
+    // set initial state covariance
+    int i, j;
+    for(i = 0; i < EKF_STATE_DIM; i++) {
+        for(j = 0; j < EKF_STATE_DIM; j++) {
+            handle->_state_covariance[i][j] = 0.0f;
+        }
+    }
+    handle->_state_covariance[X][X] = initial_config->var_x;
+    handle->_state_covariance[X][Y] = initial_config->cov_xy;
+    handle->_state_covariance[Y][X] = initial_config->cov_xy;
+    handle->_state_covariance[Y][Y] = initial_config->var_y;
+    handle->_state_covariance[OMEGA][OMEGA] = EKF_INIT_OMEGA_VAR;
+
+    handle->_triangle = t;
+
+    handle->_measurement_variance = EKF_MEAS_VAR_DT;
+    handle->_max_acc = MAX_ACC;
+    handle->_process_noise_proportionality = PROC_NOISE_PROP;
+    handle->_omega_noise = EKF_OMEGA_NOISE;
+
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t ekf_update(
+        ekf_robot_handle_t * handle,
+        const ekf_measurement_t * measurement,
+        float delta_t,
+        robot_pos_t * dest)
+{
+    if(handle == NULL || dest == NULL || delta_t < 0.0f) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+
+    predict(handle, delta_t);
+
+    // the three time deltas are fused one after the other, relinearizing
+    // around the refined state each time, this avoids inverting the 3x3
+    // innovation covariance
+    if(measurement != NULL) {
+        const reference_triangle_t * t = handle->_triangle;
+        scalar_update(handle, t->point_b, t->point_c, measurement->dt_alpha);
+        scalar_update(handle, t->point_c, t->point_a, measurement->dt_beta);
+        scalar_update(handle, t->point_a, t->point_b, measurement->dt_gamma);
+    }
+
+    // write resulting position (and associated variances) to dest
+    dest->x = handle->_state[X];
+    dest->y = handle->_state[Y];
+    dest->var_x = handle->_state_covariance[X][X];
+    dest->var_y = handle->_state_covariance[Y][Y];
+    dest->cov_xy = handle->_state_covariance[X][Y];
+
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t ekf_set_measurement_variance(
+        ekf_robot_handle_t * handle,
+        float variance)
+{
+    if(handle == NULL || variance < 0.0f) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    handle->_measurement_variance = variance;
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t ekf_set_max_acc(
+        ekf_robot_handle_t * handle,
+        float max_acc)
+{
+    if(handle == NULL || max_acc < 0.0f) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    handle->_max_acc = max_acc;
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t ekf_get_omega(
+        ekf_robot_handle_t * handle,
+        float * omega)
+{
+    if(handle == NULL || omega == NULL) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    *omega = handle->_state[OMEGA];
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+// private function implementations
+
+// x = F*x, P = F*P*F^T + Q
+//
+// F is the constant velocity model of the linear filter extended by omega,
+// which is modeled as a random walk
+static void predict(ekf_robot_handle_t * handle, float delta_t)
+{
+    float (*p)[EKF_STATE_DIM] = handle->_state_covariance;
+    int i;
+
+    handle->_state[X] += delta_t * handle->_state[V_X];
+    handle->_state[Y] += delta_t * handle->_state[V_Y];
+
+    // P*F^T: column X += dt * column V_X, column Y += dt * column V_Y
+    for(i = 0; i < EKF_STATE_DIM; i++) {
+        p[i][X] += delta_t * p[i][V_X];
+        p[i][Y] += delta_t * p[i][V_Y];
+    }
+    // F*(P*F^T): row X += dt * row V_X, row Y += dt * row V_Y
+    for(i = 0; i < EKF_STATE_DIM; i++) {
+        p[X][i] += delta_t * p[V_X][i];
+        p[Y][i] += delta_t * p[V_Y][i];
+    }
+
+    // process noise, same model as the linear kalman filter
+    float base_factor = handle->_process_noise_proportionality * handle->_max_acc;
+    float dt2 = delta_t * delta_t;
+    float q_pos = 0.25f * dt2 * dt2 * base_factor;
+    float q_cross = 0.5f * dt2 * delta_t * base_factor;
+    float q_vel = dt2 * base_factor;
+
+    p[X][X] += q_pos;
+    p[Y][Y] += q_pos;
+    p[X][V_X] += q_cross;
+    p[V_X][X] += q_cross;
+    p[Y][V_Y] += q_cross;
+    p[V_Y][Y] += q_cross;
+    p[V_X][V_X] += q_vel;
+    p[V_Y][V_Y] += q_vel;
+    p[OMEGA][OMEGA] += handle->_omega_noise * delta_t;
+}
+
+// EKF update with the time the laser needs to sweep from beacon 'first' to
+// beacon 'second':
+//
+// h(x, y, omega) = (atan2(second - p) - atan2(first - p)) / omega
+static void scalar_update(
+        ekf_robot_handle_t * handle,
+        const position_t * first,
+        const position_t * second,
+        float measured_dt)
+{
+    float (*p)[EKF_STATE_DIM] = handle->_state_covariance;
+    float * state = handle->_state;
+    float omega = state[OMEGA];
+    int i, j;
+
+    float d1_x = first->x - state[X];
+    float d1_y = first->y - state[Y];
+    float d2_x = second->x - state[X];
+    float d2_y = second->y - state[Y];
+    float r1_sq = d1_x * d1_x + d1_y * d1_y;
+    float r2_sq = d2_x * d2_x + d2_y * d2_y;
+
+    // the jacobian is not defined on a beacon, skip the update
+    if(r1_sq < EKF_MIN_BEACON_DIST_SQ || r2_sq < EKF_MIN_BEACON_DIST_SQ) {
+        return;
+    }
+
+    float angle = atan2f(d2_y, d2_x) - atan2f(d1_y, d1_x);
+    if(angle < 0.0f) {
+        angle += FLOAT_2_PI;
+    }
+
+    // compare in angle space so a measurement close to 0 or 2 Pi doesn't
+    // produce a residual of a whole rotation
+    float residual = wrap_angle(measured_dt * omega - angle) / omega;
+
+    // jacobian H of h
+    float h[EKF_STATE_DIM];
+    h[X] = (d2_y / r2_sq - d1_y / r1_sq) / omega;
+    h[Y] = (d1_x / r1_sq - d2_x / r2_sq) / omega;
+    h[V_X] = 0.0f;
+    h[V_Y] = 0.0f;
+    h[OMEGA] = - angle / (omega * omega);
+
+    // P*H^T
+    float ph[EKF_STATE_DIM];
+    for(i = 0; i < EKF_STATE_DIM; i++) {
+        ph[i] = p[i][X] * h[X] + p[i][Y] * h[Y] + p[i][OMEGA] * h[OMEGA];
+    }
+
+    // innovation covariance S = H*P*H^T + R, a scalar
+    float s = h[X] * ph[X] + h[Y] * ph[Y] + h[OMEGA] * ph[OMEGA]
+        + handle->_measurement_variance;
+    if(s <= 0.0f) {
+        return;
+    }
+
+    // K = P*H^T / S
+    float k[EKF_STATE_DIM];
+    for(i = 0; i < EKF_STATE_DIM; i++) {
+        k[i] = ph[i] / s;
+        state[i] += k[i] * residual;
+    }
+
+    // P = P - K*H*P, where H*P = (P*H^T)^T since P is symmetric
+    for(i = 0; i < EKF_STATE_DIM; i++) {
+        for(j = 0; j < EKF_STATE_DIM; j++) {
+            p[i][j] -= k[i] * ph[j];
+        }
+    }
+}
+
+// wrap angle into [-Pi, Pi)
+static float wrap_angle(float angle)
+{
+    while(angle >= FLOAT_PI) {
+        angle -= FLOAT_2_PI;
+    }
+    while(angle < -FLOAT_PI) {
+        angle += FLOAT_2_PI;
+    }
+    return angle;
+}
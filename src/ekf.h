@@ -0,0 +1,96 @@
+
+#ifndef BEACON_EKF_H
+#define BEACON_EKF_H
+
+#include <stdint.h>
+
+#include "positioning.h"
+#include "kalman.h"
+#include "platform-abstraction/mutex.h"
+
+// state: x, y, v_x, v_y, omega (angular velocity of the laser)
+#define EKF_STATE_DIM   (5)
+
+// time the laser took to sweep between the beacons [s], using the same
+// convention as the angles passed to 'positioning_from_angles'
+typedef struct {
+    float dt_alpha;     // between the passages at beacons B and C
+    float dt_beta;      // between the passages at beacons C and A
+    float dt_gamma;     // between the passages at beacons A and B
+} ekf_measurement_t;
+
+// WARNING : this type should be opaque, its only here to
+// allow static allocation by user
+typedef struct {
+    mutex_t _mutex;
+    float _state[EKF_STATE_DIM];
+    float _state_covariance[EKF_STATE_DIM][EKF_STATE_DIM];
+    const reference_triangle_t * _triangle;
+    float _measurement_variance;
+    float _max_acc;
+    float _process_noise_proportionality;
+    float _omega_noise;
+} ekf_robot_handle_t;
+
+// intializes all fields of 'handle'
+// 'initial_config' holds starting position (and associated covariances)
+// 'omega' is the initial guess of the laser's angular velocity [rad/s]
+// 't' is the reference triangle holding the beacon positions, it must stay
+// valid as long as the handle is used
+//
+// call this function before any call to 'ekf_update'
+//
+// return 1 if initialization was successful
+// return 0 if initialization failed (input parameters NULL or omega <= 0)
+uint8_t ekf_init(
+        ekf_robot_handle_t * handle,
+        const robot_pos_t * initial_config,
+        float omega,
+        const reference_triangle_t * t);
+
+// updates state estimates with the time deltas held by 'measurement'
+// 'delta_t' should be the time since the last update
+//
+// unlike 'kalman_update' no triangulation is needed, so measurements on
+// or near the circumcircle of the reference triangle can still be used
+//
+// writes update estimate of position (and associated covariance) to
+// memory pointed by 'dest'
+//
+// return 1 if everything went fine
+// return 0 on failure (result cannot be used/trusted, handle or dest NULL)
+// fails if delta_t < 0
+// if the measurement passed in is NULL it will skip the update step
+// and only make a prediction
+uint8_t ekf_update(
+        ekf_robot_handle_t * handle,
+        const ekf_measurement_t * measurement,
+        float delta_t,
+        robot_pos_t * dest);
+
+// update the variance [s^2] of a single measured time delta
+//
+// return 1 on success
+// return 0 on failure (handle is NULL or variance negative)
+uint8_t ekf_set_measurement_variance(
+        ekf_robot_handle_t * handle,
+        float variance);
+
+// set maximum acceleration of the robot associated with handle
+//
+// return 1 if setting was successful
+// return 0 on failure
+uint8_t ekf_set_max_acc(
+        ekf_robot_handle_t * handle,
+        float max_acc);
+
+// write the current estimate of the laser's angular velocity [rad/s]
+// to 'omega'
+//
+// return 1 on success
+// return 0 on failure (handle or omega NULL)
+uint8_t ekf_get_omega(
+        ekf_robot_handle_t * handle,
+        float * omega);
+
+#endif
@@ -0,0 +1,51 @@
+
+#ifndef BEACON_FIXED_POINT_H
+#define BEACON_FIXED_POINT_H
+
+#include <stdint.h>
+
+// fixed-point types used by the integer only build (BEACON_FIXED_POINT)
+//
+// q31_t:       values in [-1, 1), 31 fractional bits
+// q8_24_t:     lengths [m], variances [m^2], times [s], ... in [-128, 128),
+//              24 fractional bits
+// angle_q_t:   binary angle, 2^32 is a whole turn so angles wrap around
+//              like unsigned integers
+typedef int32_t q31_t;
+typedef int32_t q8_24_t;
+typedef uint32_t angle_q_t;
+
+#define Q31_ONE     (INT32_MAX)
+#define Q8_24_ONE   (1 << 24)
+
+// conversions, meant for constants and for talking to the float world
+#define Q8_24_FROM_FLOAT(x) ((q8_24_t)((x) * 16777216.0f))
+#define Q8_24_TO_FLOAT(x)   ((float)(x) / 16777216.0f)
+#define Q31_TO_FLOAT(x)     ((float)(x) / 2147483648.0f)
+#define ANGLE_Q_FROM_RAD(x) ((angle_q_t)(int64_t)((x) * 683565275.57643f))
+#define ANGLE_Q_TO_RAD(x)   ((float)(x) * 1.4629180792671596e-09f)
+
+// a * b
+static inline q31_t q31_mul(q31_t a, q31_t b)
+{
+    return (q31_t)(((int64_t)a * b) >> 31);
+}
+
+// a * b, rounded to nearest
+static inline q8_24_t q8_24_mul(q8_24_t a, q8_24_t b)
+{
+    return (q8_24_t)(((int64_t)a * b + (1 << 23)) >> 24);
+}
+
+// num / den in q8_24, num and den having the same number of fractional
+// bits. returns 0 if den is 0
+q8_24_t q8_24_ratio(int64_t num, int64_t den);
+
+// sine and cosine, table lookup with linear interpolation (error < 5e-6)
+q31_t q31_sin(angle_q_t angle);
+q31_t q31_cos(angle_q_t angle);
+
+// floor(sqrt(x))
+uint32_t fixed_isqrt64(uint64_t x);
+
+#endif
@@ -0,0 +1,18 @@
+
+#ifndef BEACON_FLOAT_MATH_H
+#define BEACON_FLOAT_MATH_H
+
+#include <math.h>
+
+// single precision constants, M_PI and friends are doubles and drag every
+// expression they appear in to double precision (software emulated on the
+// Cortex-M4F, its FPU only does single precision)
+//
+// use the float functions of math.h (sqrtf, fabsf, tanf, atan2f, ...)
+// together with these in the filter and positioning code, 'make float-check'
+// catches any promotion to double
+#define FLOAT_PI        (3.14159265f)
+#define FLOAT_PI_2      (1.57079633f)
+#define FLOAT_2_PI      (6.28318531f)
+
+#endif
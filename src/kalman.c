@@ -5,18 +5,10 @@
 
 #include "kalman.h"
 #include "beacon_config.h"
+#include "float_math.h"
 
 // data types
 
-/*
- * | k1 |
- * | k2 |
- */
-typedef struct {
-    matrix2d_t _k1;
-    matrix2d_t _k2;
-} kalman_gain_t;
-
 typedef struct {
     float _x;
     float _y;
@@ -31,29 +23,73 @@ uint8_t kalman_update(
         const position_t * measurement,
         float delta_t,
         robot_pos_t * dest);
+uint8_t kalman_update_with_covariance(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        const position_covariance_t * covariance,
+        float delta_t,
+        robot_pos_t * dest);
 uint8_t kalman_update_measurement_covariance(
         kalman_robot_handle_t * handle,
         float var_x,
         float var_y,
         float cov_xy);
+uint8_t kalman_set_update_mode(
+        kalman_robot_handle_t * handle,
+        kalman_update_mode_t mode);
+uint8_t kalman_set_covariance_update(
+        kalman_robot_handle_t * handle,
+        kalman_covariance_update_t form);
+uint8_t kalman_enable_steady_state(
+        kalman_robot_handle_t * handle,
+        float delta_t);
+uint8_t kalman_disable_steady_state(kalman_robot_handle_t * handle);
 uint8_t kalman_set_max_acc(
         kalman_robot_handle_t * handle,
         float max_acc);
 uint8_t kalman_set_proc_noise_proportionality(
         kalman_robot_handle_t * handle,
         float prop);
+uint8_t kalman_set_odometry(
+        kalman_robot_handle_t * handle,
+        const robot_odometry_t * odometry);
+uint8_t kalman_get_snapshot(
+        kalman_robot_handle_t * handle,
+        kalman_snapshot_t * dest);
+uint8_t kalman_set_snapshot(
+        kalman_robot_handle_t * handle,
+        const kalman_snapshot_t * snapshot);
 
 // private function prototypes
-static uint8_t feq(float a, float b);
+
+// steady-state helpers
+static void full_update(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        const matrix2d_t * measurement_noise_cov,
+        float delta_t);
+static void steady_state_update(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        float delta_t);
+static uint8_t is_nominal_delta_t(
+        const kalman_robot_handle_t * handle,
+        float delta_t);
+static uint8_t gain_converged(
+        const kalman_gain_t * g1,
+        const kalman_gain_t * g2);
+static void steady_state_reset(kalman_robot_handle_t * handle);
 
 // kalman functions
 static void predict_state(
         const robot_state_t * src,
+        const robot_odometry_t * odometry,
         float delta_t,
         robot_state_t * dest);
 static void predict_covariance(
         const covariance_t * src,
         const covariance_t * process_noise_cov,
+        const robot_odometry_t * odometry,
         float delta_t,
         covariance_t * dest);
 static void kalman_gain(
@@ -69,35 +105,60 @@ static void update_covariance(
         const covariance_t * predicted_cov,
         const kalman_gain_t * gain,
         covariance_t * dest);
+static void joseph_update_covariance(
+        const covariance_t * predicted_cov,
+        const kalman_gain_t * gain,
+        const matrix2d_t * measurement_noise_cov,
+        covariance_t * dest);
+static void correct_covariance(
+        const kalman_robot_handle_t * handle,
+        const kalman_gain_t * gain,
+        const matrix2d_t * measurement_noise_cov,
+        covariance_t * cov);
+static const robot_odometry_t * control_input(
+        const kalman_robot_handle_t * handle);
 static void process_noise_covariance(
         const kalman_robot_handle_t * handle,
         float delta_t,
         covariance_t * dest);
+static void sequential_update(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        const matrix2d_t * measurement_noise_cov);
+static void scalar_update(
+        robot_state_t * state,
+        covariance_t * cov,
+        float h_x,
+        float h_y,
+        float residual,
+        float variance,
+        kalman_covariance_update_t form);
 
 // 2x2 matrix functionality
 static void m_mult(
         const matrix2d_t * m1,
         const matrix2d_t * m2,
         matrix2d_t * dest);
-static void m_add(
+static void m_mult_trans(
         const matrix2d_t * m1,
         const matrix2d_t * m2,
         matrix2d_t * dest);
-static void m_diff(
+static void m_add(
         const matrix2d_t * m1,
         const matrix2d_t * m2,
         matrix2d_t * dest);
-//static void m_trans(const matrix2d_t * m1, matrix2d_t * dest);
-static uint8_t m_inv(const matrix2d_t * m1, matrix2d_t * dest);
-static void m_scalar_mult(
-        float scalar,
+static void m_diff(
         const matrix2d_t * m1,
+        const matrix2d_t * m2,
         matrix2d_t * dest);
+static void m_trans(const matrix2d_t * m1, matrix2d_t * dest);
+static void m_from_sym(const sym_matrix2d_t * m1, matrix2d_t * dest);
+static void m_to_sym(const matrix2d_t * m1, sym_matrix2d_t * dest);
+static uint8_t sym_inv(const sym_matrix2d_t * m1, sym_matrix2d_t * dest);
 static void m_vec_mult(
         const matrix2d_t * m,
         const vec2d_t * v,
         vec2d_t * dest);
-static void m_init_identity(matrix2d_t * dest);
 
 static void cov_add(
         const covariance_t * c1,
@@ -131,7 +192,6 @@ uint8_t kalman_init(
     // set initial state covariance
     handle->_state_covariance._cov_a._a = initial_config->var_x;
     handle->_state_covariance._cov_a._b = initial_config->cov_xy;
-    handle->_state_covariance._cov_a._c = initial_config->cov_xy;
     handle->_state_covariance._cov_a._d = initial_config->var_y;
 
     handle->_state_covariance._cov_b._a = 0.0f;
@@ -139,14 +199,8 @@ uint8_t kalman_init(
     handle->_state_covariance._cov_b._c = 0.0f;
     handle->_state_covariance._cov_b._d = 0.0f;
 
-    handle->_state_covariance._cov_c._a = 0.0f;
-    handle->_state_covariance._cov_c._b = 0.0f;
-    handle->_state_covariance._cov_c._c = 0.0f;
-    handle->_state_covariance._cov_c._d = 0.0f;
-
     handle->_state_covariance._cov_d._a = 0.0f;
     handle->_state_covariance._cov_d._b = 0.0f;
-    handle->_state_covariance._cov_d._c = 0.0f;
     handle->_state_covariance._cov_d._d = 0.0f;
 
     // set default measurment covariance
@@ -161,6 +215,16 @@ uint8_t kalman_init(
     // default proportionality constant for process noise covariance
     handle->_process_noise_proportionality = PROC_NOISE_PROP;
 
+    // constant velocity model until odometry comes in
+    handle->_odometry_valid = 0;
+
+    handle->_update_mode = KALMAN_UPDATE_JOINT;
+    handle->_covariance_update = KALMAN_COVARIANCE_STANDARD;
+
+    handle->_steady_state_enabled = 0;
+    handle->_steady_state_delta_t = 0.0f;
+    steady_state_reset(handle);
+
     os_mutex_release(&(handle->_mutex));
 
     return 1;
@@ -171,46 +235,44 @@ uint8_t kalman_update(
         const position_t * measurement,
         float delta_t,
         robot_pos_t * dest)
+{
+    return kalman_update_with_covariance(
+            handle, measurement, NULL, delta_t, dest);
+}
+
+uint8_t kalman_update_with_covariance(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        const position_covariance_t * covariance,
+        float delta_t,
+        robot_pos_t * dest)
 {
     if(handle == NULL || dest == NULL || delta_t < 0.0f) {
         return 0;
     }
 
-    os_mutex_take(&(handle->_mutex));
-
-    // predict new state
-    predict_state(&(handle->_state), delta_t, &(handle->_state));
-
-    // predict new covariance
-    covariance_t proc_noise_cov;
-    process_noise_covariance(handle, delta_t, &proc_noise_cov);
-    predict_covariance(
-            &(handle->_state_covariance),
-            &proc_noise_cov,
-            delta_t,
-            &(handle->_state_covariance));
-
-    // if there is a measurement make kalman update
-    if(measurement != NULL) {
-        // compute kalman gain
-        kalman_gain_t gain;
-        kalman_gain(
-                &(handle->_state_covariance),
-                &(handle->_measurement_covariance),
-                &gain);
-
-        // compute difference between prediction and measurement
-        vec2d_t residual;
-        residual._x = measurement->x - handle->_state._x;
-        residual._y = measurement->y - handle->_state._y;
+    matrix2d_t measurement_noise_cov;
+    if(covariance != NULL) {
+        measurement_noise_cov._a = covariance->var_x;
+        measurement_noise_cov._b = covariance->cov_xy;
+        measurement_noise_cov._c = covariance->cov_xy;
+        measurement_noise_cov._d = covariance->var_y;
+    }
 
-        // estimate new state considering measurement
-        update_state(&(handle->_state), &gain, &residual, &(handle->_state));
+    os_mutex_take(&(handle->_mutex));
 
-        update_covariance(
-                &(handle->_state_covariance),
-                &gain,
-                &(handle->_state_covariance));
+    // the steady-state gain only holds for the default covariance
+    if(covariance == NULL && handle->_steady_state_locked
+            && measurement != NULL && is_nominal_delta_t(handle, delta_t)) {
+        steady_state_update(handle, measurement, delta_t);
+    } else {
+        full_update(
+                handle,
+                measurement,
+                covariance != NULL
+                    ? &measurement_noise_cov
+                    : &(handle->_measurement_covariance),
+                delta_t);
     }
 
     // write resulting position (and associated variances) to dest
@@ -242,6 +304,106 @@ uint8_t kalman_update_measurement_covariance(
     handle->_measurement_covariance._c = cov_xy;
     handle->_measurement_covariance._d = var_y;
 
+    steady_state_reset(handle);
+
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_set_update_mode(
+        kalman_robot_handle_t * handle,
+        kalman_update_mode_t mode)
+{
+    if(handle == NULL ||
+            (mode != KALMAN_UPDATE_JOINT && mode != KALMAN_UPDATE_SEQUENTIAL)) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    handle->_update_mode = mode;
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_set_covariance_update(
+        kalman_robot_handle_t * handle,
+        kalman_covariance_update_t form)
+{
+    if(handle == NULL ||
+            (form != KALMAN_COVARIANCE_STANDARD && form != KALMAN_COVARIANCE_JOSEPH)) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    handle->_covariance_update = form;
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_enable_steady_state(
+        kalman_robot_handle_t * handle,
+        float delta_t)
+{
+    if(handle == NULL || delta_t <= 0.0f) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+
+    handle->_steady_state_enabled = 1;
+    handle->_steady_state_delta_t = delta_t;
+    steady_state_reset(handle);
+
+    // iterate the covariance equations until the gain converges
+    covariance_t cov = handle->_state_covariance;
+    covariance_t proc_noise_cov;
+    process_noise_covariance(handle, delta_t, &proc_noise_cov);
+
+    int i;
+    for(i = 0; i < KALMAN_STEADY_STATE_MAX_ITER; i++) {
+        kalman_gain_t gain;
+        predict_covariance(
+                &cov, &proc_noise_cov, control_input(handle), delta_t, &cov);
+        kalman_gain(&cov, &(handle->_measurement_covariance), &gain);
+        correct_covariance(
+                handle, &gain, &(handle->_measurement_covariance), &cov);
+
+        if(handle->_steady_state_gain_valid
+                && gain_converged(&gain, &(handle->_steady_state_gain))) {
+            handle->_steady_state_locked = 1;
+            handle->_state_covariance = cov;
+        }
+        handle->_steady_state_gain = gain;
+        handle->_steady_state_gain_valid = 1;
+
+        if(handle->_steady_state_locked) {
+            break;
+        }
+    }
+
+    // if it didn't converge kalman_update keeps looking for convergence
+    // while running the full computation
+    if(!handle->_steady_state_locked) {
+        steady_state_reset(handle);
+    }
+
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_disable_steady_state(kalman_robot_handle_t * handle)
+{
+    if(handle == NULL) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    handle->_steady_state_enabled = 0;
+    steady_state_reset(handle);
     os_mutex_release(&(handle->_mutex));
 
     return 1;
@@ -255,7 +417,10 @@ uint8_t kalman_set_max_acc(
         return 0;
     }
 
+    os_mutex_take(&(handle->_mutex));
     handle->_max_acc = max_acc;
+    steady_state_reset(handle);
+    os_mutex_release(&(handle->_mutex));
 
     return 1;
 }
@@ -268,87 +433,321 @@ uint8_t kalman_set_proc_noise_proportionality(
         return 0;
     }
 
+    os_mutex_take(&(handle->_mutex));
     handle->_process_noise_proportionality = prop;
+    steady_state_reset(handle);
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_set_odometry(
+        kalman_robot_handle_t * handle,
+        const robot_odometry_t * odometry)
+{
+    if(handle == NULL || (odometry != NULL && odometry->var < 0)) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+
+    // the velocity doesn't change the covariance equations, only switching
+    // the model or changing its noise does
+    if(odometry == NULL) {
+        if(handle->_odometry_valid) {
+            steady_state_reset(handle);
+        }
+        handle->_odometry_valid = 0;
+    } else {
+        if(!handle->_odometry_valid || odometry->var != handle->_odometry.var) {
+            steady_state_reset(handle);
+        }
+        handle->_odometry = *odometry;
+        handle->_odometry_valid = 1;
+    }
+
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_get_snapshot(
+        kalman_robot_handle_t * handle,
+        kalman_snapshot_t * dest)
+{
+    if(handle == NULL || dest == NULL) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    dest->_state = handle->_state;
+    dest->_state_covariance = handle->_state_covariance;
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_set_snapshot(
+        kalman_robot_handle_t * handle,
+        const kalman_snapshot_t * snapshot)
+{
+    if(handle == NULL || snapshot == NULL) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    handle->_state = snapshot->_state;
+    handle->_state_covariance = snapshot->_state_covariance;
+    os_mutex_release(&(handle->_mutex));
 
     return 1;
 }
 
 // private function implementations
 
-static uint8_t feq(float a, float b)
+// steady-state helpers
+
+// predict and update state and covariance
+//
+// if steady-state operation is enabled this keeps track of the gain and
+// switches to steady_state_update once it has converged, as long as the
+// measurements come with the default covariance
+static void full_update(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        const matrix2d_t * measurement_noise_cov,
+        float delta_t)
 {
-    static const float EPSILON = 0.0001f;
-    return fabs(a - b) < EPSILON;
+    // predict new state
+    predict_state(
+            &(handle->_state),
+            control_input(handle),
+            delta_t,
+            &(handle->_state));
+
+    // predict new covariance
+    covariance_t proc_noise_cov;
+    process_noise_covariance(handle, delta_t, &proc_noise_cov);
+    predict_covariance(
+            &(handle->_state_covariance),
+            &proc_noise_cov,
+            control_input(handle),
+            delta_t,
+            &(handle->_state_covariance));
+
+    uint8_t track_gain = handle->_steady_state_enabled
+        && measurement != NULL
+        && measurement_noise_cov == &(handle->_measurement_covariance)
+        && is_nominal_delta_t(handle, delta_t);
+
+    // the gain from an off-nominal or skipped update must not be compared
+    // to the next one
+    if(!track_gain) {
+        steady_state_reset(handle);
+    }
+
+    if(measurement == NULL) {
+        return;
+    }
+
+    kalman_gain_t gain;
+    if(handle->_update_mode == KALMAN_UPDATE_JOINT || track_gain) {
+        // compute kalman gain
+        kalman_gain(
+                &(handle->_state_covariance),
+                measurement_noise_cov,
+                &gain);
+    }
+
+    // make kalman update
+    if(handle->_update_mode == KALMAN_UPDATE_SEQUENTIAL) {
+        sequential_update(handle, measurement, measurement_noise_cov);
+    } else {
+        // compute difference between prediction and measurement
+        vec2d_t residual;
+        residual._x = measurement->x - handle->_state._x;
+        residual._y = measurement->y - handle->_state._y;
+
+        // estimate new state considering measurement
+        update_state(&(handle->_state), &gain, &residual, &(handle->_state));
+
+        correct_covariance(
+                handle,
+                &gain,
+                measurement_noise_cov,
+                &(handle->_state_covariance));
+    }
+
+    if(track_gain) {
+        if(handle->_steady_state_gain_valid
+                && gain_converged(&gain, &(handle->_steady_state_gain))) {
+            handle->_steady_state_locked = 1;
+        }
+        handle->_steady_state_gain = gain;
+        handle->_steady_state_gain_valid = 1;
+    }
+}
+
+// state equations only, the state covariance stays at its converged value
+static void steady_state_update(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        float delta_t)
+{
+    predict_state(
+            &(handle->_state),
+            control_input(handle),
+            delta_t,
+            &(handle->_state));
+
+    vec2d_t residual;
+    residual._x = measurement->x - handle->_state._x;
+    residual._y = measurement->y - handle->_state._y;
+
+    update_state(
+            &(handle->_state),
+            &(handle->_steady_state_gain),
+            &residual,
+            &(handle->_state));
+}
+
+static uint8_t is_nominal_delta_t(
+        const kalman_robot_handle_t * handle,
+        float delta_t)
+{
+    float nominal = handle->_steady_state_delta_t;
+    return fabsf(delta_t - nominal) <= KALMAN_STEADY_STATE_DT_TOL * nominal;
+}
+
+static uint8_t gain_converged(
+        const kalman_gain_t * g1,
+        const kalman_gain_t * g2)
+{
+    static const float EPSILON = KALMAN_STEADY_STATE_GAIN_EPS;
+    return fabsf(g1->_k1._a - g2->_k1._a) < EPSILON
+        && fabsf(g1->_k1._b - g2->_k1._b) < EPSILON
+        && fabsf(g1->_k1._c - g2->_k1._c) < EPSILON
+        && fabsf(g1->_k1._d - g2->_k1._d) < EPSILON
+        && fabsf(g1->_k2._a - g2->_k2._a) < EPSILON
+        && fabsf(g1->_k2._b - g2->_k2._b) < EPSILON
+        && fabsf(g1->_k2._c - g2->_k2._c) < EPSILON
+        && fabsf(g1->_k2._d - g2->_k2._d) < EPSILON;
+}
+
+// forget the converged gain, it has to be found again
+static void steady_state_reset(kalman_robot_handle_t * handle)
+{
+    handle->_steady_state_locked = 0;
+    handle->_steady_state_gain_valid = 0;
 }
 
 // kalman functions
+
+// constant velocity model, or the odometry velocity as control input
+// if it isn't NULL
 static void predict_state(
         const robot_state_t * src,
+        const robot_odometry_t * odometry,
         float delta_t,
         robot_state_t * dest)
 {
-    float n_x = src->_x + delta_t * src->_v_x;
-    float n_y = src->_y + delta_t * src->_v_y;
+    float v_x = src->_v_x;
+    float v_y = src->_v_y;
 
-    dest->_x = n_x;
-    dest->_y = n_y;
-    dest->_v_x = src->_v_x;
-    dest->_v_y = src->_v_y;
+    if(odometry != NULL) {
+        v_x = odometry->v_x;
+        v_y = odometry->v_y;
+    }
+
+    dest->_x = src->_x + delta_t * v_x;
+    dest->_y = src->_y + delta_t * v_y;
+    dest->_v_x = v_x;
+    dest->_v_y = v_y;
 }
 
+// F*P*F^T with F = | I dt*I |, written out on the packed blocks
+//                    | 0 I    |
+//
+// with odometry the velocity is the control input, it doesn't depend on
+// the previous state: F = | I 0 |, the control noise is in Q
+//                         | 0 0 |
 static void predict_covariance(
         const covariance_t * src,
         const covariance_t * process_noise_cov,
+        const robot_odometry_t * odometry,
         float delta_t,
         covariance_t * dest)
 {
-    // Ddest = Dsrc
-    dest->_cov_d = src->_cov_d;
+    const sym_matrix2d_t * a = &(src->_cov_a);
+    const matrix2d_t * b = &(src->_cov_b);
+    const sym_matrix2d_t * d = &(src->_cov_d);
+    float dt2 = delta_t * delta_t;
+
+    // incase src == dest, src is read completely before dest is written
+    covariance_t result;
+
+    if(odometry != NULL) {
+        result._cov_a = *a;
+        result._cov_b._a = 0.0f;
+        result._cov_b._b = 0.0f;
+        result._cov_b._c = 0.0f;
+        result._cov_b._d = 0.0f;
+        result._cov_d._a = 0.0f;
+        result._cov_d._b = 0.0f;
+        result._cov_d._d = 0.0f;
+        cov_add(&result, process_noise_cov, dest);
+        return;
+    }
 
-    // D = dt*D
-    matrix2d_t dtD;
-    m_scalar_mult(delta_t, &(src->_cov_d), &dtD);
+    // Adest = Asrc + dt*(Bsrc + Bsrc^T) + dt*dt*Dsrc
+    result._cov_a._a = a->_a + 2.0f * delta_t * b->_a + dt2 * d->_a;
+    result._cov_a._b = a->_b + delta_t * (b->_b + b->_c) + dt2 * d->_b;
+    result._cov_a._d = a->_d + 2.0f * delta_t * b->_d + dt2 * d->_d;
 
     // Bdest = Bsrc + dt*Dsrc
-    m_add(&(src->_cov_b), &dtD, &(dest->_cov_b));
-
-    // Cdest = Csrc + dt*Dsrc
-    m_add(&(src->_cov_c), &dtD, &(dest->_cov_c));
-
-    // D = dt*dt*D
-    m_scalar_mult(delta_t, &dtD, &dtD);
+    result._cov_b._a = b->_a + delta_t * d->_a;
+    result._cov_b._b = b->_b + delta_t * d->_b;
+    result._cov_b._c = b->_c + delta_t * d->_b;
+    result._cov_b._d = b->_d + delta_t * d->_d;
 
-    // B = dt*B
-    matrix2d_t dtB;
-    m_scalar_mult(delta_t, &(src->_cov_b), &dtB);
-
-    // C = dt*C
-    matrix2d_t dtC;
-    m_scalar_mult(delta_t, &(src->_cov_c), &dtC);
-
-    // Adest = Asrc + dt*B + dt*C + dt*dt*D
-    m_add(&dtD, &dtB, &dtD);
-    m_add(&dtD, &dtC, &dtD);
-    m_add(&dtD, &(src->_cov_a), &(dest->_cov_a));
+    // Ddest = Dsrc
+    result._cov_d = *d;
 
     // add noise covariance Q
-    cov_add(dest, process_noise_cov, dest);
+    cov_add(&result, process_noise_cov, dest);
 }
 
+// K1 = A*S^-1, K2 = B^T*S^-1 with S = A + R
 static void kalman_gain(
         const covariance_t * predicted_covariance,
         const matrix2d_t * measurement_noise_cov,
         kalman_gain_t * dest)
 {
-    matrix2d_t residual;
-
-    m_add(&(predicted_covariance->_cov_a), measurement_noise_cov, &residual);
-    uint8_t inverse_success = m_inv(&residual, &residual);
+    const sym_matrix2d_t * a = &(predicted_covariance->_cov_a);
+    const matrix2d_t * b = &(predicted_covariance->_cov_b);
+
+    // the measurement noise covariance is symmetric too
+    sym_matrix2d_t residual;
+    residual._a = a->_a + measurement_noise_cov->_a;
+    residual._b = a->_b + measurement_noise_cov->_b;
+    residual._d = a->_d + measurement_noise_cov->_d;
+
+    // the measurement carries no usable information, don't update
+    if(!sym_inv(&residual, &residual)) {
+        residual._a = 0.0f;
+        residual._b = 0.0f;
+        residual._d = 0.0f;
+    }
 
-    if(inverse_success);    // TODO error handling
+    dest->_k1._a = a->_a * residual._a + a->_b * residual._b;
+    dest->_k1._b = a->_a * residual._b + a->_b * residual._d;
+    dest->_k1._c = a->_b * residual._a + a->_d * residual._b;
+    dest->_k1._d = a->_b * residual._b + a->_d * residual._d;
 
-    m_mult(&(predicted_covariance->_cov_a), &residual, &(dest->_k1));
-    m_mult(&(predicted_covariance->_cov_c), &residual, &(dest->_k2));
+    dest->_k2._a = b->_a * residual._a + b->_c * residual._b;
+    dest->_k2._b = b->_a * residual._b + b->_c * residual._d;
+    dest->_k2._c = b->_b * residual._a + b->_d * residual._b;
+    dest->_k2._d = b->_b * residual._b + b->_d * residual._d;
 }
 
 static void update_state(
@@ -370,29 +769,129 @@ static void update_state(
     dest->_v_y = predicted->_v_y + lower._y;
 }
 
+// P - K*H*P, only the upper triangle of the symmetric result is computed
 static void update_covariance(
         const covariance_t * predicted_cov,
         const kalman_gain_t * gain,
         covariance_t * dest)
 {
-    matrix2d_t intermediate;
+    const sym_matrix2d_t * a = &(predicted_cov->_cov_a);
+    const matrix2d_t * b = &(predicted_cov->_cov_b);
+    const sym_matrix2d_t * d = &(predicted_cov->_cov_d);
+    const matrix2d_t * k1 = &(gain->_k1);
+    const matrix2d_t * k2 = &(gain->_k2);
+
+    // incase predicted_cov == dest, Asrc and Bsrc are still needed after
+    // Adest and Bdest have been computed
+    covariance_t result;
+
     // Adest = Asrc - K1*Asrc
-    m_mult(&(gain->_k1), &(predicted_cov->_cov_a), &intermediate);
-    m_diff(&(predicted_cov->_cov_a), &intermediate, &(dest->_cov_a));
+    result._cov_a._a = a->_a - (k1->_a * a->_a + k1->_b * a->_b);
+    result._cov_a._b = a->_b - (k1->_a * a->_b + k1->_b * a->_d);
+    result._cov_a._d = a->_d - (k1->_c * a->_b + k1->_d * a->_d);
 
     // Bdest = Bsrc - K1*Bsrc
-    m_mult(&(gain->_k1), &(predicted_cov->_cov_b), &intermediate);
-    m_diff(&(predicted_cov->_cov_b), &intermediate, &(dest->_cov_b));
-
-    // Cdest = Csrc - K2*Asrc
-    m_mult(&(gain->_k2), &(predicted_cov->_cov_a), &intermediate);
-    m_diff(&(predicted_cov->_cov_c), &intermediate, &(dest->_cov_c));
+    result._cov_b._a = b->_a - (k1->_a * b->_a + k1->_b * b->_c);
+    result._cov_b._b = b->_b - (k1->_a * b->_b + k1->_b * b->_d);
+    result._cov_b._c = b->_c - (k1->_c * b->_a + k1->_d * b->_c);
+    result._cov_b._d = b->_d - (k1->_c * b->_b + k1->_d * b->_d);
 
     // Ddest = Dsrc - K2*Bsrc
-    m_mult(&(gain->_k2), &(predicted_cov->_cov_b), &intermediate);
-    m_diff(&(predicted_cov->_cov_d), &intermediate, &(dest->_cov_d));
+    result._cov_d._a = d->_a - (k2->_a * b->_a + k2->_b * b->_c);
+    result._cov_d._b = d->_b - (k2->_a * b->_b + k2->_b * b->_d);
+    result._cov_d._d = d->_d - (k2->_c * b->_b + k2->_d * b->_d);
+
+    *dest = result;
+}
+
+// P = (I - K*H)*P*(I - K*H)^T + K*R*K^T
+//
+// with H = | I 0 | and M = I - K1:
+// A = M*A*M^T + K1*R*K1^T
+// B = M*(B - A*K2^T) + K1*R*K2^T
+// D = D - K2*B - (K2*B)^T + K2*(A + R)*K2^T
+static void joseph_update_covariance(
+        const covariance_t * predicted_cov,
+        const kalman_gain_t * gain,
+        const matrix2d_t * measurement_noise_cov,
+        covariance_t * dest)
+{
+    const matrix2d_t * k1 = &(gain->_k1);
+    const matrix2d_t * k2 = &(gain->_k2);
+    matrix2d_t a, d, m, k1_r, tmp1, tmp2, tmp3;
+
+    m_from_sym(&(predicted_cov->_cov_a), &a);
+    m_from_sym(&(predicted_cov->_cov_d), &d);
+
+    m._a = 1.0f - k1->_a;
+    m._b = - k1->_b;
+    m._c = - k1->_c;
+    m._d = 1.0f - k1->_d;
+
+    m_mult(k1, measurement_noise_cov, &k1_r);
+
+    // incase predicted_cov == dest, it is still needed after
+    // Adest and Bdest have been computed
+    covariance_t result;
+
+    // Adest
+    m_mult(&m, &a, &tmp1);
+    m_mult_trans(&tmp1, &m, &tmp1);
+    m_mult_trans(&k1_r, k1, &tmp2);
+    m_add(&tmp1, &tmp2, &tmp1);
+    m_to_sym(&tmp1, &(result._cov_a));
+
+    // Bdest
+    m_mult_trans(&a, k2, &tmp1);
+    m_diff(&(predicted_cov->_cov_b), &tmp1, &tmp1);
+    m_mult(&m, &tmp1, &tmp1);
+    m_mult_trans(&k1_r, k2, &tmp2);
+    m_add(&tmp1, &tmp2, &(result._cov_b));
+
+    // Ddest
+    m_mult(k2, &(predicted_cov->_cov_b), &tmp1);
+    m_trans(&tmp1, &tmp2);
+    m_add(&tmp1, &tmp2, &tmp1);
+    m_diff(&d, &tmp1, &tmp3);
+    m_add(&a, measurement_noise_cov, &tmp2);
+    m_mult(k2, &tmp2, &tmp2);
+    m_mult_trans(&tmp2, k2, &tmp2);
+    m_add(&tmp3, &tmp2, &tmp3);
+    m_to_sym(&tmp3, &(result._cov_d));
+
+    *dest = result;
 }
 
+// apply the covariance update selected on handle
+static void correct_covariance(
+        const kalman_robot_handle_t * handle,
+        const kalman_gain_t * gain,
+        const matrix2d_t * measurement_noise_cov,
+        covariance_t * cov)
+{
+    if(handle->_covariance_update == KALMAN_COVARIANCE_JOSEPH) {
+        joseph_update_covariance(
+                cov,
+                gain,
+                measurement_noise_cov,
+                cov);
+    } else {
+        update_covariance(cov, gain, cov);
+    }
+}
+
+// odometry used as control input, NULL for the constant velocity model
+static const robot_odometry_t * control_input(
+        const kalman_robot_handle_t * handle)
+{
+    return handle->_odometry_valid ? &(handle->_odometry) : NULL;
+}
+
+// every block of Q is a multiple of the identity
+//
+// with odometry Q = G*var*G^T, G = | dt*I |, the odometry velocity error
+//                                  | I    |
+// integrated over delta_t
 static void process_noise_covariance(
         const kalman_robot_handle_t * handle,
         float delta_t,
@@ -400,19 +899,158 @@ static void process_noise_covariance(
 {
     float base_factor =
         handle->_process_noise_proportionality * handle->_max_acc;
+    float dt2 = delta_t * delta_t;
+
+    if(handle->_odometry_valid) {
+        float var = handle->_odometry.var;
+
+        dest->_cov_a._a = dt2 * var;
+        dest->_cov_a._b = 0.0f;
+        dest->_cov_a._d = dt2 * var;
+
+        dest->_cov_b._a = delta_t * var;
+        dest->_cov_b._b = 0.0f;
+        dest->_cov_b._c = 0.0f;
+        dest->_cov_b._d = delta_t * var;
+
+        dest->_cov_d._a = var;
+        dest->_cov_d._b = 0.0f;
+        dest->_cov_d._d = var;
+        return;
+    }
+
+    float q_a = 0.25f * dt2 * dt2 * base_factor;
+    dest->_cov_a._a = q_a;
+    dest->_cov_a._b = 0.0f;
+    dest->_cov_a._d = q_a;
+
+    float q_b = 0.5f * dt2 * delta_t * base_factor;
+    dest->_cov_b._a = q_b;
+    dest->_cov_b._b = 0.0f;
+    dest->_cov_b._c = 0.0f;
+    dest->_cov_b._d = q_b;
+
+    float q_d = dt2 * base_factor;
+    dest->_cov_d._a = q_d;
+    dest->_cov_d._b = 0.0f;
+    dest->_cov_d._d = q_d;
+}
+
+// fuse x and y one after the other
+//
+// the measurement noise R is decorrelated with R = L*D*L^T,
+// L = | 1 0 |, D = | r_x 0                 |
+//     | l 1 |      | 0   r_y - l*cov_xy |
+// where l = cov_xy / r_x, and the measurement is transformed by L^-1:
+// the first scalar measures x, the second measures y - l*x
+static void sequential_update(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        const matrix2d_t * measurement_noise_cov)
+{
+    const matrix2d_t * r = measurement_noise_cov;
+    robot_state_t * state = &(handle->_state);
+
+    float l = 0.0f;
+    if(r->_a > 0.0f) {
+        l = r->_b / r->_a;
+    }
 
-    m_init_identity(&(dest->_cov_a));
-    m_init_identity(&(dest->_cov_b));
-    m_init_identity(&(dest->_cov_c));
-    m_init_identity(&(dest->_cov_d));
+    float residual = measurement->x - state->_x;
+    scalar_update(
+            state,
+            &(handle->_state_covariance),
+            1.0f, 0.0f,
+            residual,
+            r->_a,
+            handle->_covariance_update);
+
+    // the residual is computed from the state refined by the first update
+    residual = (measurement->y - l * measurement->x) - (state->_y - l * state->_x);
+    scalar_update(
+            state,
+            &(handle->_state_covariance),
+            - l, 1.0f,
+            residual,
+            r->_d - l * r->_b,
+            handle->_covariance_update);
+}
+
+// kalman update with a scalar measurement z = h_x*x + h_y*y
+//
+// the only division is by the scalar innovation variance, which is skipped
+// if the measurement carries no information
+static void scalar_update(
+        robot_state_t * state,
+        covariance_t * cov,
+        float h_x,
+        float h_y,
+        float residual,
+        float variance,
+        kalman_covariance_update_t form)
+{
+    sym_matrix2d_t * a = &(cov->_cov_a);
+    matrix2d_t * b = &(cov->_cov_b);
+    sym_matrix2d_t * d = &(cov->_cov_d);
+
+    // P*H^T, since P is symmetric H*P is its transpose
+    float ph_0 = a->_a * h_x + a->_b * h_y;
+    float ph_1 = a->_b * h_x + a->_d * h_y;
+    float ph_2 = b->_a * h_x + b->_c * h_y;
+    float ph_3 = b->_b * h_x + b->_d * h_y;
+
+    // innovation variance S = H*P*H^T + R
+    float hph = h_x * ph_0 + h_y * ph_1;
+    float s = hph + variance;
+    if(s <= 0.0f) {
+        return;
+    }
+    float s_inv = 1.0f / s;
+
+    // K = P*H^T / S
+    float k_0 = ph_0 * s_inv;
+    float k_1 = ph_1 * s_inv;
+    float k_2 = ph_2 * s_inv;
+    float k_3 = ph_3 * s_inv;
+
+    state->_x += k_0 * residual;
+    state->_y += k_1 * residual;
+    state->_v_x += k_2 * residual;
+    state->_v_y += k_3 * residual;
+
+    if(form == KALMAN_COVARIANCE_JOSEPH) {
+        // P = (I - K*H)*P*(I - K*H)^T + K*R*K^T
+        //   = P - K*H*P - P*H^T*K^T + K*H*P*H^T*K^T + K*R*K^T
+        // R is added last, it would be lost in S when it is much smaller
+        // than H*P*H^T
+        a->_a = a->_a - 2.0f * k_0 * ph_0 + hph * k_0 * k_0 + variance * k_0 * k_0;
+        a->_b = a->_b - k_0 * ph_1 - ph_0 * k_1 + hph * k_0 * k_1 + variance * k_0 * k_1;
+        a->_d = a->_d - 2.0f * k_1 * ph_1 + hph * k_1 * k_1 + variance * k_1 * k_1;
+
+        b->_a = b->_a - k_0 * ph_2 - ph_0 * k_2 + hph * k_0 * k_2 + variance * k_0 * k_2;
+        b->_b = b->_b - k_0 * ph_3 - ph_0 * k_3 + hph * k_0 * k_3 + variance * k_0 * k_3;
+        b->_c = b->_c - k_1 * ph_2 - ph_1 * k_2 + hph * k_1 * k_2 + variance * k_1 * k_2;
+        b->_d = b->_d - k_1 * ph_3 - ph_1 * k_3 + hph * k_1 * k_3 + variance * k_1 * k_3;
+
+        d->_a = d->_a - 2.0f * k_2 * ph_2 + hph * k_2 * k_2 + variance * k_2 * k_2;
+        d->_b = d->_b - k_2 * ph_3 - ph_2 * k_3 + hph * k_2 * k_3 + variance * k_2 * k_3;
+        d->_d = d->_d - 2.0f * k_3 * ph_3 + hph * k_3 * k_3 + variance * k_3 * k_3;
+        return;
+    }
+
+    // P = P - K*H*P
+    a->_a -= k_0 * ph_0;
+    a->_b -= k_0 * ph_1;
+    a->_d -= k_1 * ph_1;
 
-    float factor = 0.25f * delta_t * delta_t * delta_t * delta_t;
-    m_scalar_mult(factor * base_factor, &(dest->_cov_a), &(dest->_cov_a));
-    factor = 0.5f * delta_t * delta_t * delta_t;
-    m_scalar_mult(factor * base_factor, &(dest->_cov_b), &(dest->_cov_b));
-    m_scalar_mult(factor * base_factor, &(dest->_cov_c), &(dest->_cov_c));
-    factor = delta_t * delta_t;
-    m_scalar_mult(factor * base_factor, &(dest->_cov_d), &(dest->_cov_d));
+    b->_a -= k_0 * ph_2;
+    b->_b -= k_0 * ph_3;
+    b->_c -= k_1 * ph_2;
+    b->_d -= k_1 * ph_3;
+
+    d->_a -= k_2 * ph_2;
+    d->_b -= k_2 * ph_3;
+    d->_d -= k_3 * ph_3;
 }
 
 
@@ -435,6 +1073,24 @@ static void m_mult(
     dest->_d = n_d;
 }
 
+// m1 * m2^T
+static void m_mult_trans(
+        const matrix2d_t * m1,
+        const matrix2d_t * m2,
+        matrix2d_t * dest)
+{
+    // incase m1 == dest or m2 == dest
+    float n_a = m1->_a * m2->_a + m1->_b * m2->_b;
+    float n_b = m1->_a * m2->_c + m1->_b * m2->_d;
+    float n_c = m1->_c * m2->_a + m1->_d * m2->_b;
+    float n_d = m1->_c * m2->_c + m1->_d * m2->_d;
+
+    dest->_a = n_a;
+    dest->_b = n_b;
+    dest->_c = n_c;
+    dest->_d = n_d;
+}
+
 static void m_add(
         const matrix2d_t * m1,
         const matrix2d_t * m2,
@@ -457,7 +1113,6 @@ static void m_diff(
     dest->_d = m1->_d - m2->_d;
 }
 
-/*
 static void m_trans(const matrix2d_t * m1, matrix2d_t * dest)
 {
     // incase m1 == dest
@@ -469,13 +1124,32 @@ static void m_trans(const matrix2d_t * m1, matrix2d_t * dest)
     dest->_c = new_c;
     dest->_d = m1->_d;
 }
-*/
 
-static uint8_t m_inv(const matrix2d_t * m1, matrix2d_t * dest)
+static void m_from_sym(const sym_matrix2d_t * m1, matrix2d_t * dest)
+{
+    dest->_a = m1->_a;
+    dest->_b = m1->_b;
+    dest->_c = m1->_b;
+    dest->_d = m1->_d;
+}
+
+// the off-diagonal entries only differ by rounding errors
+static void m_to_sym(const matrix2d_t * m1, sym_matrix2d_t * dest)
 {
-    float det = m1->_a * m1->_d - m1->_b * m1->_c;
+    dest->_a = m1->_a;
+    dest->_b = 0.5f * (m1->_b + m1->_c);
+    dest->_d = m1->_d;
+}
 
-    if(feq(det, 0.0f)) {
+// inverse of a symmetric 2x2 matrix
+static uint8_t sym_inv(const sym_matrix2d_t * m1, sym_matrix2d_t * dest)
+{
+    static const float EPSILON = 1e-6f;
+    float det = m1->_a * m1->_d - m1->_b * m1->_b;
+
+    // singular relative to the magnitude of the entries, an absolute
+    // threshold would reject the small covariances used here
+    if(fabsf(det) <= EPSILON * (fabsf(m1->_a * m1->_d) + m1->_b * m1->_b)) {
         return 0;
     }
 
@@ -483,28 +1157,15 @@ static uint8_t m_inv(const matrix2d_t * m1, matrix2d_t * dest)
 
     float n_a = det * m1->_d;
     float n_b = det * m1->_b;
-    float n_c = det * m1->_c;
     float n_d = det * m1->_a;
 
     dest->_a = n_a;
     dest->_b = - n_b;
-    dest->_c = - n_c;
     dest->_d = n_d;
 
     return 1;
 }
 
-static void m_scalar_mult(
-        float scalar,
-        const matrix2d_t * m1,
-        matrix2d_t * dest)
-{
-    dest->_a = scalar * m1->_a;
-    dest->_b = scalar * m1->_b;
-    dest->_c = scalar * m1->_c;
-    dest->_d = scalar * m1->_d;
-}
-
 static void m_vec_mult(
         const matrix2d_t * m,
         const vec2d_t * v,
@@ -517,21 +1178,21 @@ static void m_vec_mult(
     dest->_y = n_y;
 }
 
-static void m_init_identity(matrix2d_t * dest)
-{
-    dest->_a = 1.0f;
-    dest->_b = 0.0f;
-    dest->_c = 0.0f;
-    dest->_d = 1.0f;
-}
-
 static void cov_add(
         const covariance_t * c1,
         const covariance_t * c2,
         covariance_t * dest)
 {
-    m_add(&(c1->_cov_a), &(c2->_cov_a), &(dest->_cov_a));
-    m_add(&(c1->_cov_b), &(c2->_cov_b), &(dest->_cov_b));
-    m_add(&(c1->_cov_c), &(c2->_cov_c), &(dest->_cov_c));
-    m_add(&(c1->_cov_d), &(c2->_cov_d), &(dest->_cov_d));
+    dest->_cov_a._a = c1->_cov_a._a + c2->_cov_a._a;
+    dest->_cov_a._b = c1->_cov_a._b + c2->_cov_a._b;
+    dest->_cov_a._d = c1->_cov_a._d + c2->_cov_a._d;
+
+    dest->_cov_b._a = c1->_cov_b._a + c2->_cov_b._a;
+    dest->_cov_b._b = c1->_cov_b._b + c2->_cov_b._b;
+    dest->_cov_b._c = c1->_cov_b._c + c2->_cov_b._c;
+    dest->_cov_b._d = c1->_cov_b._d + c2->_cov_b._d;
+
+    dest->_cov_d._a = c1->_cov_d._a + c2->_cov_d._a;
+    dest->_cov_d._b = c1->_cov_d._b + c2->_cov_d._b;
+    dest->_cov_d._d = c1->_cov_d._d + c2->_cov_d._d;
 }
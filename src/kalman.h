@@ -16,6 +16,15 @@ typedef struct {
     float cov_xy;
 } robot_pos_t;
 
+// velocity of the robot measured by its wheel odometry, in the table frame
+//
+// used as control input of the prediction, see kalman_set_odometry
+typedef struct {
+    float v_x;
+    float v_y;
+    float var;
+} robot_odometry_t;
+
 // ATTENTION : this type is only exported to allow static allocation
 // of kalman_robot_handle_t
 //
@@ -41,14 +50,67 @@ typedef struct {
 
 // WARNING : this type is only exported to allow static allocation
 // of kalman_robot_handle_t
+//
+// symmetric 2x2 matrix
+// | a b |
+// | b d |
+typedef struct {
+    float _a;
+    float _b;
+    float _d;
+} sym_matrix2d_t;
+
+// WARNING : this type is only exported to allow static allocation
+// of kalman_robot_handle_t
+//
+// state covariance, symmetric so only the upper triangle is stored
+// | A   B |  A = cov(position), D = cov(velocity)
+// | B^T D |  B = cov(position, velocity)
 typedef struct {
-    matrix2d_t _cov_a;
+    sym_matrix2d_t _cov_a;
     matrix2d_t _cov_b;
-    matrix2d_t _cov_c;
-    matrix2d_t _cov_d;
+    sym_matrix2d_t _cov_d;
 } covariance_t;
 
 
+// WARNING : this type is only exported to allow static allocation
+// of kalman_robot_handle_t
+//
+// | k1 |
+// | k2 |
+typedef struct {
+    matrix2d_t _k1;
+    matrix2d_t _k2;
+} kalman_gain_t;
+
+// WARNING : this type is only exported to allow static allocation
+//
+// state and state covariance of the filter at some point in time
+typedef struct {
+    robot_state_t _state;
+    covariance_t _state_covariance;
+} kalman_snapshot_t;
+
+// selects how kalman_update fuses a measurement into the state
+typedef enum {
+    // x and y are fused jointly, the 2x2 innovation covariance is inverted
+    KALMAN_UPDATE_JOINT = 0,
+    // x and y are fused as two scalar updates after decorrelating the
+    // measurement noise, no matrix inversion is needed
+    KALMAN_UPDATE_SEQUENTIAL
+} kalman_update_mode_t;
+
+// selects how kalman_update computes the state covariance after a
+// measurement
+typedef enum {
+    // P = (I - K*H)*P, cheapest, but rounding errors can make P lose
+    // positive definiteness over long runs
+    KALMAN_COVARIANCE_STANDARD = 0,
+    // P = (I - K*H)*P*(I - K*H)^T + K*R*K^T, stays positive definite
+    // for any gain at the cost of more multiplications
+    KALMAN_COVARIANCE_JOSEPH
+} kalman_covariance_update_t;
+
 // WARNING : this type should be opaque, its only here to 
 // allow static allocation by user
 typedef struct {
@@ -58,6 +120,15 @@ typedef struct {
     matrix2d_t _measurement_covariance;
     float _max_acc;
     float _process_noise_proportionality;
+    uint8_t _odometry_valid;
+    robot_odometry_t _odometry;
+    kalman_update_mode_t _update_mode;
+    kalman_covariance_update_t _covariance_update;
+    uint8_t _steady_state_enabled;
+    uint8_t _steady_state_locked;
+    uint8_t _steady_state_gain_valid;
+    float _steady_state_delta_t;
+    kalman_gain_t _steady_state_gain;
 } kalman_robot_handle_t;
 
 // intializes all fields of 'handle'
@@ -95,6 +166,22 @@ uint8_t kalman_update(
         float delta_t,
         robot_pos_t * dest);
 
+// kalman_update with the covariance of this measurement instead of the
+// measurement covariance of the handle, e.g. from
+// positioning_from_angles_with_covariance. NULL uses the one of the handle
+//
+// the steady-state gain is only valid for the measurement covariance of the
+// handle, a measurement with its own covariance runs the full computation
+//
+// return 1 if everything went fine
+// return 0 on failure (handle or dest NULL, delta_t < 0)
+uint8_t kalman_update_with_covariance(
+        kalman_robot_handle_t * handle,
+        const position_t * measurement,
+        const position_covariance_t * covariance,
+        float delta_t,
+        robot_pos_t * dest);
+
 // update measurement covariance in case you don't want to use
 // the default provided in 'beacon_config.h'
 //
@@ -109,6 +196,50 @@ uint8_t kalman_update_measurement_covariance(
         float var_y,
         float cov_xy);
 
+// select how measurements are fused into the state of the robot
+// associated with handle, KALMAN_UPDATE_JOINT is the default
+//
+// return 1 if setting was successful
+// return 0 on failure (handle is NULL or mode unknown)
+uint8_t kalman_set_update_mode(
+        kalman_robot_handle_t * handle,
+        kalman_update_mode_t mode);
+
+// select how the state covariance of the robot associated with handle is
+// updated, KALMAN_COVARIANCE_STANDARD is the default
+//
+// return 1 if setting was successful
+// return 0 on failure (handle is NULL or form unknown)
+uint8_t kalman_set_covariance_update(
+        kalman_robot_handle_t * handle,
+        kalman_covariance_update_t form);
+
+// enable steady-state operation of the filter at a fixed rate of
+// 1/delta_t
+//
+// with a constant update rate and measurement covariance the state
+// covariance converges, so does the kalman gain. it is solved for here
+// (the state covariance jumps to its converged value) and from then on
+// kalman_update only evaluates the state equations.
+//
+// kalman_update falls back to the full computation whenever a measurement
+// is missing or its delta_t is off by more than KALMAN_STEADY_STATE_DT_TOL,
+// and switches back once the gain has converged again. changing the
+// measurement covariance or the process noise parameters also triggers
+// a fallback.
+//
+// return 1 on success
+// return 0 on failure (handle is NULL or delta_t <= 0)
+uint8_t kalman_enable_steady_state(
+        kalman_robot_handle_t * handle,
+        float delta_t);
+
+// go back to always running the full kalman computation
+//
+// return 1 on success
+// return 0 on failure (handle is NULL)
+uint8_t kalman_disable_steady_state(kalman_robot_handle_t * handle);
+
 // set maximum acceleration of the robot associated with handle
 //
 // return 1 if setting was successful
@@ -126,4 +257,34 @@ uint8_t kalman_set_proc_noise_proportionality(
         kalman_robot_handle_t * handle,
         float prop);
 
+// drive the prediction of the robot associated with handle with its
+// odometry instead of the constant velocity model
+//
+// the velocity of the state is replaced by the odometry velocity, the
+// position moves by delta_t times it. the process noise then only comes
+// from 'var' (variance of each velocity component [m^2/s^2]) instead of
+// the maximal acceleration, so the covariance stays small while the
+// beacons are hidden. the odometry is used by every following update
+// (replays of kalman_history included) until it is replaced, passing NULL
+// goes back to the constant velocity model.
+//
+// return 1 on success
+// return 0 on failure (handle is NULL or var < 0)
+uint8_t kalman_set_odometry(
+        kalman_robot_handle_t * handle,
+        const robot_odometry_t * odometry);
+
+// copy the state and state covariance of the robot associated with handle
+// to 'dest', kalman_set_snapshot puts them back. allows to roll the filter
+// back in time, see kalman_history.h
+//
+// return 1 on success
+// return 0 on failure (handle or snapshot is NULL)
+uint8_t kalman_get_snapshot(
+        kalman_robot_handle_t * handle,
+        kalman_snapshot_t * dest);
+uint8_t kalman_set_snapshot(
+        kalman_robot_handle_t * handle,
+        const kalman_snapshot_t * snapshot);
+
 #endif
@@ -0,0 +1,255 @@
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "kalman_batch.h"
+#include "beacon_config.h"
+
+// public function prototypes
+uint8_t kalman_batch_init(
+        kalman_batch_t * batch,
+        kalman_batch_block_t * storage,
+        uint32_t count,
+        const robot_pos_t * initial_config);
+uint8_t kalman_batch_update(
+        kalman_batch_t * batch,
+        const float * meas_x,
+        const float * meas_y,
+        const uint8_t * meas_valid,
+        float delta_t);
+uint8_t kalman_batch_get(
+        const kalman_batch_t * batch,
+        uint32_t index,
+        robot_pos_t * dest);
+uint8_t kalman_batch_update_measurement_covariance(
+        kalman_batch_t * batch,
+        float var_x,
+        float var_y,
+        float cov_xy);
+
+// private function prototypes
+static void update_block(
+        kalman_batch_block_t * block,
+        uint32_t nb_tracks,
+        const float * meas_x,
+        const float * meas_y,
+        const uint8_t * meas_valid,
+        const kalman_batch_t * batch,
+        float delta_t);
+
+
+// public function implementations
+
+uint8_t kalman_batch_init(
+        kalman_batch_t * batch,
+        kalman_batch_block_t * storage,
+        uint32_t count,
+        const robot_pos_t * initial_config)
+{
+    if(batch == NULL || storage == NULL || initial_config == NULL || count == 0) {
+        return 0;
+    }
+
+    batch->_blocks = storage;
+    batch->_count = count;
+
+    uint32_t i;
+    for(i = 0; i < KALMAN_BATCH_NB_BLOCKS(count); i++) {
+        memset(&storage[i], 0, sizeof(kalman_batch_block_t));
+    }
+
+    for(i = 0; i < count; i++) {
+        kalman_batch_block_t * block = &storage[i / KALMAN_BATCH_BLOCK_SIZE];
+        uint32_t j = i % KALMAN_BATCH_BLOCK_SIZE;
+
+        block->x[j] = initial_config[i].x;
+        block->y[j] = initial_config[i].y;
+        block->a_xx[j] = initial_config[i].var_x;
+        block->a_xy[j] = initial_config[i].cov_xy;
+        block->a_yy[j] = initial_config[i].var_y;
+    }
+
+    batch->_measurement_covariance._a = MEAS_VAR_X;
+    batch->_measurement_covariance._b = MEAS_COV_XY;
+    batch->_measurement_covariance._c = MEAS_COV_XY;
+    batch->_measurement_covariance._d = MEAS_VAR_Y;
+    batch->_max_acc = MAX_ACC;
+    batch->_process_noise_proportionality = PROC_NOISE_PROP;
+
+    return 1;
+}
+
+uint8_t kalman_batch_update(
+        kalman_batch_t * batch,
+        const float * meas_x,
+        const float * meas_y,
+        const uint8_t * meas_valid,
+        float delta_t)
+{
+    if(batch == NULL || meas_x == NULL || meas_y == NULL || delta_t < 0.0f) {
+        return 0;
+    }
+
+    uint32_t begin;
+    for(begin = 0; begin < batch->_count; begin += KALMAN_BATCH_BLOCK_SIZE) {
+        uint32_t nb_tracks = batch->_count - begin;
+        if(nb_tracks > KALMAN_BATCH_BLOCK_SIZE) {
+            nb_tracks = KALMAN_BATCH_BLOCK_SIZE;
+        }
+
+        update_block(
+                &batch->_blocks[begin / KALMAN_BATCH_BLOCK_SIZE],
+                nb_tracks,
+                &meas_x[begin],
+                &meas_y[begin],
+                meas_valid == NULL ? NULL : &meas_valid[begin],
+                batch,
+                delta_t);
+    }
+
+    return 1;
+}
+
+uint8_t kalman_batch_get(
+        const kalman_batch_t * batch,
+        uint32_t index,
+        robot_pos_t * dest)
+{
+    if(batch == NULL || dest == NULL || index >= batch->_count) {
+        return 0;
+    }
+
+    const kalman_batch_block_t * block =
+        &batch->_blocks[index / KALMAN_BATCH_BLOCK_SIZE];
+    uint32_t j = index % KALMAN_BATCH_BLOCK_SIZE;
+
+    dest->x = block->x[j];
+    dest->y = block->y[j];
+    dest->var_x = block->a_xx[j];
+    dest->var_y = block->a_yy[j];
+    dest->cov_xy = block->a_xy[j];
+
+    return 1;
+}
+
+uint8_t kalman_batch_update_measurement_covariance(
+        kalman_batch_t * batch,
+        float var_x,
+        float var_y,
+        float cov_xy)
+{
+    if(batch == NULL) {
+        return 0;
+    }
+
+    batch->_measurement_covariance._a = var_x;
+    batch->_measurement_covariance._b = cov_xy;
+    batch->_measurement_covariance._c = cov_xy;
+    batch->_measurement_covariance._d = var_y;
+
+    return 1;
+}
+
+// private function implementations
+
+// one iteration per track without data dependent branches, skipped
+// measurements and singular innovation covariances zero the gain. the
+// measurements of skipped tracks may be NaN or inf
+static void update_block(
+        kalman_batch_block_t * block,
+        uint32_t nb_tracks,
+        const float * meas_x,
+        const float * meas_y,
+        const uint8_t * meas_valid,
+        const kalman_batch_t * batch,
+        float delta_t)
+{
+    const float dt = delta_t;
+    const float dt2 = dt * dt;
+    const float base_factor =
+        batch->_process_noise_proportionality * batch->_max_acc;
+    const float q_a = 0.25f * dt2 * dt2 * base_factor;
+    const float q_b = 0.5f * dt2 * dt * base_factor;
+    const float q_d = dt2 * base_factor;
+    const float r_xx = batch->_measurement_covariance._a;
+    const float r_xy = batch->_measurement_covariance._b;
+    const float r_yy = batch->_measurement_covariance._d;
+    static const float EPSILON = 1e-6f;
+
+    // expand the measurement validity into a mask, skipped measurements
+    // are replaced by 0 as the zeroed gain alone would keep a NaN (0 * NaN)
+    float valid[KALMAN_BATCH_BLOCK_SIZE];
+    float m_x[KALMAN_BATCH_BLOCK_SIZE];
+    float m_y[KALMAN_BATCH_BLOCK_SIZE];
+    uint32_t i;
+    for(i = 0; i < nb_tracks; i++) {
+        valid[i] = (meas_valid == NULL || meas_valid[i] != 0) ? 1.0f : 0.0f;
+        m_x[i] = valid[i] != 0.0f ? meas_x[i] : 0.0f;
+        m_y[i] = valid[i] != 0.0f ? meas_y[i] : 0.0f;
+    }
+
+    for(i = 0; i < nb_tracks; i++) {
+        // predict state
+        float px = block->x[i] + dt * block->v_x[i];
+        float py = block->y[i] + dt * block->v_y[i];
+        float vx = block->v_x[i];
+        float vy = block->v_y[i];
+
+        // predict covariance, F*P*F^T + Q
+        float pd_xx = block->d_xx[i] + q_d;
+        float pd_xy = block->d_xy[i];
+        float pd_yy = block->d_yy[i] + q_d;
+        float pb_xx = block->b_xx[i] + dt * block->d_xx[i] + q_b;
+        float pb_xy = block->b_xy[i] + dt * block->d_xy[i];
+        float pb_yx = block->b_yx[i] + dt * block->d_xy[i];
+        float pb_yy = block->b_yy[i] + dt * block->d_yy[i] + q_b;
+        float pa_xx = block->a_xx[i] + 2.0f * dt * block->b_xx[i] + dt2 * block->d_xx[i] + q_a;
+        float pa_xy = block->a_xy[i] + dt * (block->b_xy[i] + block->b_yx[i]) + dt2 * block->d_xy[i];
+        float pa_yy = block->a_yy[i] + 2.0f * dt * block->b_yy[i] + dt2 * block->d_yy[i] + q_a;
+
+        // innovation covariance S = A + R and its inverse
+        float s_xx = pa_xx + r_xx;
+        float s_xy = pa_xy + r_xy;
+        float s_yy = pa_yy + r_yy;
+        float det = s_xx * s_yy - s_xy * s_xy;
+        float regular =
+            fabsf(det) > EPSILON * (fabsf(s_xx * s_yy) + s_xy * s_xy) ? 1.0f : 0.0f;
+        float use = valid[i] * regular;
+        float inv_det = use / (use * det + (1.0f - use));
+        float si_xx = inv_det * s_yy;
+        float si_xy = - inv_det * s_xy;
+        float si_yy = inv_det * s_xx;
+
+        // K1 = A*S^-1, K2 = B^T*S^-1
+        float k1_xx = pa_xx * si_xx + pa_xy * si_xy;
+        float k1_xy = pa_xx * si_xy + pa_xy * si_yy;
+        float k1_yx = pa_xy * si_xx + pa_yy * si_xy;
+        float k1_yy = pa_xy * si_xy + pa_yy * si_yy;
+        float k2_xx = pb_xx * si_xx + pb_yx * si_xy;
+        float k2_xy = pb_xx * si_xy + pb_yx * si_yy;
+        float k2_yx = pb_xy * si_xx + pb_yy * si_xy;
+        float k2_yy = pb_xy * si_xy + pb_yy * si_yy;
+
+        // update state
+        float r_x = m_x[i] - px;
+        float r_y = m_y[i] - py;
+        block->x[i] = px + k1_xx * r_x + k1_xy * r_y;
+        block->y[i] = py + k1_yx * r_x + k1_yy * r_y;
+        block->v_x[i] = vx + k2_xx * r_x + k2_xy * r_y;
+        block->v_y[i] = vy + k2_yx * r_x + k2_yy * r_y;
+
+        // update covariance, A -= K1*A, B -= K1*B, D -= K2*B
+        block->a_xx[i] = pa_xx - (k1_xx * pa_xx + k1_xy * pa_xy);
+        block->a_xy[i] = pa_xy - (k1_xx * pa_xy + k1_xy * pa_yy);
+        block->a_yy[i] = pa_yy - (k1_yx * pa_xy + k1_yy * pa_yy);
+        block->b_xx[i] = pb_xx - (k1_xx * pb_xx + k1_xy * pb_yx);
+        block->b_xy[i] = pb_xy - (k1_xx * pb_xy + k1_xy * pb_yy);
+        block->b_yx[i] = pb_yx - (k1_yx * pb_xx + k1_yy * pb_yx);
+        block->b_yy[i] = pb_yy - (k1_yx * pb_xy + k1_yy * pb_yy);
+        block->d_xx[i] = pd_xx - (k2_xx * pb_xx + k2_xy * pb_yx);
+        block->d_xy[i] = pd_xy - (k2_xx * pb_xy + k2_xy * pb_yy);
+        block->d_yy[i] = pd_yy - (k2_yx * pb_xy + k2_yy * pb_yy);
+    }
+}
@@ -0,0 +1,98 @@
+
+#ifndef BEACON_KALMAN_BATCH_H
+#define BEACON_KALMAN_BATCH_H
+
+#include <stdint.h>
+
+#include "kalman.h"
+
+// the same constant velocity filter as kalman_update, but for many tracks
+// at once. all tracks share delta_t and the filter parameters.
+//
+// tracks are stored in blocks of KALMAN_BATCH_BLOCK_SIZE, inside a block
+// every field is an array (all x, then all y, ...) so that the update loop
+// vectorizes on the host. the state covariance is symmetric, only its upper
+// triangle is stored:
+// | A   B |, A and D symmetric 2x2 blocks (position, velocity),
+// | B^T D |  B the position/velocity cross covariance
+#define KALMAN_BATCH_BLOCK_SIZE (16)
+
+// number of blocks needed to hold 'count' tracks
+#define KALMAN_BATCH_NB_BLOCKS(count) \
+    (((count) + KALMAN_BATCH_BLOCK_SIZE - 1) / KALMAN_BATCH_BLOCK_SIZE)
+
+typedef struct {
+    float x[KALMAN_BATCH_BLOCK_SIZE];
+    float y[KALMAN_BATCH_BLOCK_SIZE];
+    float v_x[KALMAN_BATCH_BLOCK_SIZE];
+    float v_y[KALMAN_BATCH_BLOCK_SIZE];
+    float a_xx[KALMAN_BATCH_BLOCK_SIZE];
+    float a_xy[KALMAN_BATCH_BLOCK_SIZE];
+    float a_yy[KALMAN_BATCH_BLOCK_SIZE];
+    float b_xx[KALMAN_BATCH_BLOCK_SIZE];    // cov(x, v_x)
+    float b_xy[KALMAN_BATCH_BLOCK_SIZE];    // cov(x, v_y)
+    float b_yx[KALMAN_BATCH_BLOCK_SIZE];    // cov(y, v_x)
+    float b_yy[KALMAN_BATCH_BLOCK_SIZE];    // cov(y, v_y)
+    float d_xx[KALMAN_BATCH_BLOCK_SIZE];
+    float d_xy[KALMAN_BATCH_BLOCK_SIZE];
+    float d_yy[KALMAN_BATCH_BLOCK_SIZE];
+} kalman_batch_block_t;
+
+// WARNING : this type should be opaque, its only here to
+// allow static allocation by user
+typedef struct {
+    kalman_batch_block_t * _blocks;
+    uint32_t _count;
+    matrix2d_t _measurement_covariance;
+    float _max_acc;
+    float _process_noise_proportionality;
+} kalman_batch_t;
+
+// initializes 'batch' to filter 'count' tracks using 'storage', which
+// must hold KALMAN_BATCH_NB_BLOCKS(count) blocks
+// 'initial_config' holds the starting position (and associated covariances)
+// of every track
+//
+// return 1 if initialization was successful
+// return 0 if initialization failed (input parameters NULL or count is 0)
+uint8_t kalman_batch_init(
+        kalman_batch_t * batch,
+        kalman_batch_block_t * storage,
+        uint32_t count,
+        const robot_pos_t * initial_config);
+
+// updates all tracks with the measurements 'meas_x[i]', 'meas_y[i]'
+// 'meas_valid[i]' set to 0 skips the update step of track i, it only
+// makes a prediction. if 'meas_valid' is NULL all measurements are used.
+// 'delta_t' should be the time since the last update
+//
+// return 1 if everything went fine
+// return 0 on failure (batch or measurements NULL, delta_t < 0)
+uint8_t kalman_batch_update(
+        kalman_batch_t * batch,
+        const float * meas_x,
+        const float * meas_y,
+        const uint8_t * meas_valid,
+        float delta_t);
+
+// writes the estimated position (and associated covariance) of track
+// 'index' to memory pointed by 'dest'
+//
+// return 1 on success
+// return 0 on failure (batch or dest NULL, index out of range)
+uint8_t kalman_batch_get(
+        const kalman_batch_t * batch,
+        uint32_t index,
+        robot_pos_t * dest);
+
+// update measurement covariance shared by all tracks
+//
+// return 1 on success
+// return 0 on failure (batch is NULL)
+uint8_t kalman_batch_update_measurement_covariance(
+        kalman_batch_t * batch,
+        float var_x,
+        float var_y,
+        float cov_xy);
+
+#endif
@@ -0,0 +1,153 @@
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "kalman_history.h"
+
+// public function prototypes
+uint8_t kalman_history_init(
+        kalman_history_t * history,
+        kalman_robot_handle_t * filter,
+        uint32_t time);
+uint8_t kalman_history_update(
+        kalman_history_t * history,
+        const position_t * measurement,
+        uint32_t time,
+        robot_pos_t * dest);
+uint8_t kalman_history_update_with_covariance(
+        kalman_history_t * history,
+        const position_t * measurement,
+        const position_covariance_t * covariance,
+        uint32_t time,
+        robot_pos_t * dest);
+
+// private function prototypes
+static uint8_t is_before(uint32_t a, uint32_t b);
+static void apply_step(
+        kalman_history_t * history,
+        kalman_history_step_t * step,
+        robot_pos_t * dest);
+
+
+// public function implementations
+
+uint8_t kalman_history_init(
+        kalman_history_t * history,
+        kalman_robot_handle_t * filter,
+        uint32_t time)
+{
+    if(history == NULL || filter == NULL) {
+        return 0;
+    }
+
+    history->_filter = filter;
+    history->_time = time;
+    history->_nb_steps = 0;
+
+    return 1;
+}
+
+uint8_t kalman_history_update(
+        kalman_history_t * history,
+        const position_t * measurement,
+        uint32_t time,
+        robot_pos_t * dest)
+{
+    return kalman_history_update_with_covariance(
+            history, measurement, NULL, time, dest);
+}
+
+uint8_t kalman_history_update_with_covariance(
+        kalman_history_t * history,
+        const position_t * measurement,
+        const position_covariance_t * covariance,
+        uint32_t time,
+        robot_pos_t * dest)
+{
+    if(history == NULL || dest == NULL) {
+        return 0;
+    }
+
+    kalman_history_step_t * steps = history->_steps;
+    uint32_t index = history->_nb_steps;
+
+    // place of the new step, after the steps at the same time
+    while(index > 0 && is_before(time, steps[index - 1]._time)) {
+        index--;
+    }
+
+    // the new step would be forgotten right away, checked before the roll
+    // back so the filter is left as it was
+    if(history->_nb_steps == KALMAN_HISTORY_SIZE && index == 0) {
+        return 0;
+    }
+
+    if(index < history->_nb_steps) {
+        // roll back to the state the step at 'index' started from
+        if(is_before(time, steps[index]._prev_time)) {
+            return 0;
+        }
+        history->_time = steps[index]._prev_time;
+        kalman_set_snapshot(history->_filter, &steps[index]._prev);
+    } else if(is_before(time, history->_time)) {
+        // older than the oldest step
+        return 0;
+    }
+
+    // make room, the oldest step is forgotten once the history is full
+    if(history->_nb_steps == KALMAN_HISTORY_SIZE) {
+        memmove(&steps[0], &steps[1], (KALMAN_HISTORY_SIZE - 1) * sizeof(steps[0]));
+        history->_nb_steps--;
+        index--;
+    }
+    memmove(&steps[index + 1], &steps[index],
+            (history->_nb_steps - index) * sizeof(steps[0]));
+    history->_nb_steps++;
+
+    steps[index]._time = time;
+    steps[index]._has_measurement = measurement != NULL;
+    steps[index]._has_covariance = measurement != NULL && covariance != NULL;
+    if(measurement != NULL) {
+        steps[index]._meas_x = measurement->x;
+        steps[index]._meas_y = measurement->y;
+    }
+    if(steps[index]._has_covariance) {
+        steps[index]._meas_cov = *covariance;
+    }
+
+    // apply the new step and replay the ones after it
+    for(; index < history->_nb_steps; index++) {
+        apply_step(history, &steps[index], dest);
+    }
+
+    return 1;
+}
+
+
+// private function implementations
+
+// a happened strictly before b, the times may wrap around
+static uint8_t is_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static void apply_step(
+        kalman_history_t * history,
+        kalman_history_step_t * step,
+        robot_pos_t * dest)
+{
+    position_t measurement = {step->_meas_x, step->_meas_y};
+
+    step->_prev_time = history->_time;
+    kalman_get_snapshot(history->_filter, &step->_prev);
+
+    kalman_update_with_covariance(
+            history->_filter,
+            step->_has_measurement ? &measurement : NULL,
+            step->_has_covariance ? &step->_meas_cov : NULL,
+            (step->_time - history->_time) / 1000000.0f,
+            dest);
+    history->_time = step->_time;
+}
@@ -0,0 +1,85 @@
+
+#ifndef BEACON_KALMAN_HISTORY_H
+#define BEACON_KALMAN_HISTORY_H
+
+#include <stdint.h>
+
+#include "kalman.h"
+
+// number of past filter steps kept to fuse late measurements. the pipeline
+// steps at KALMAN_TRANS_FREQ and with every fix, 70 steps per second with
+// both lasers on one filter: 8 steps reach back more than 100 [ms] while a
+// fix reaches the filter a few [ms] after its last edge. every step costs
+// 88 [B] of RAM per filter
+#ifndef KALMAN_HISTORY_SIZE
+#define KALMAN_HISTORY_SIZE (8)
+#endif
+
+// keeps the last KALMAN_HISTORY_SIZE steps of a kalman filter together with
+// the filter state before each of them. a measurement older than the
+// filter state is inserted at its place in time: the filter is rolled back
+// to the step before it and every later step is applied again.
+//
+// times are in [us] and may wrap around, steps are at most 2^31 [us] apart
+
+// WARNING : this type is only exported to allow static allocation
+// of kalman_history_t
+typedef struct {
+    uint32_t _time;
+    uint8_t _has_measurement;
+    uint8_t _has_covariance;
+    float _meas_x;
+    float _meas_y;
+    position_covariance_t _meas_cov;
+    // filter state before the step and the time it refers to
+    uint32_t _prev_time;
+    kalman_snapshot_t _prev;
+} kalman_history_step_t;
+
+// WARNING : this type should be opaque, its only here to
+// allow static allocation by user
+typedef struct {
+    kalman_robot_handle_t * _filter;
+    // time the filter state refers to
+    uint32_t _time;
+    // steps in chronological order
+    kalman_history_step_t _steps[KALMAN_HISTORY_SIZE];
+    uint32_t _nb_steps;
+} kalman_history_t;
+
+// starts recording the steps of 'filter', its state refers to 'time'
+//
+// return 1 on success
+// return 0 on failure (history or filter NULL)
+uint8_t kalman_history_init(
+        kalman_history_t * history,
+        kalman_robot_handle_t * filter,
+        uint32_t time);
+
+// fuses 'measurement' taken at 'time' or only predicts to 'time' if
+// measurement is NULL, like kalman_update
+//
+// if 'time' is older than the filter state the steps after it are replayed,
+// the filter state still refers to the latest step afterwards. writes the
+// resulting position (and associated covariance) to 'dest'.
+//
+// return 1 on success
+// return 0 on failure (a pointer is NULL, 'time' is older than the oldest
+// recorded step)
+uint8_t kalman_history_update(
+        kalman_history_t * history,
+        const position_t * measurement,
+        uint32_t time,
+        robot_pos_t * dest);
+
+// kalman_history_update with the covariance of this measurement, see
+// kalman_update_with_covariance. it is kept with the step for the replays,
+// NULL uses the measurement covariance of the filter
+uint8_t kalman_history_update_with_covariance(
+        kalman_history_t * history,
+        const position_t * measurement,
+        const position_covariance_t * covariance,
+        uint32_t time,
+        robot_pos_t * dest);
+
+#endif
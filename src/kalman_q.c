@@ -0,0 +1,222 @@
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "kalman_q.h"
+#include "beacon_config.h"
+
+// public function prototypes
+uint8_t kalman_q_init(
+        kalman_q_robot_handle_t * handle,
+        const robot_pos_q_t * initial_config);
+uint8_t kalman_q_update(
+        kalman_q_robot_handle_t * handle,
+        const position_q_t * measurement,
+        q8_24_t delta_t,
+        robot_pos_q_t * dest);
+uint8_t kalman_q_update_measurement_covariance(
+        kalman_q_robot_handle_t * handle,
+        q8_24_t var_x,
+        q8_24_t var_y,
+        q8_24_t cov_xy);
+
+// private function prototypes
+static void predict(kalman_q_robot_handle_t * handle, q8_24_t delta_t);
+static void update(
+        kalman_q_robot_handle_t * handle,
+        const position_q_t * measurement);
+
+
+// public function implementations
+
+uint8_t kalman_q_init(
+        kalman_q_robot_handle_t * handle,
+        const robot_pos_q_t * initial_config)
+{
+    // verify input
+    if(handle == NULL || initial_config == NULL) {
+        return 0;
+    }
+
+    os_mutex_init(&(handle->_mutex));
+
+    os_mutex_take(&(handle->_mutex));
+
+    // set initial state, robot is assumed to stand still
+    handle->_x = initial_config->x;
+    handle->_y = initial_config->y;
+    handle->_v_x = 0;
+    handle->_v_y = 0;
+
+    // set initial state covariance
+    handle->_cov_a_xx = initial_config->var_x;
+    handle->_cov_a_xy = initial_config->cov_xy;
+    handle->_cov_a_yy = initial_config->var_y;
+    handle->_cov_b_xx = 0;
+    handle->_cov_b_xy = 0;
+    handle->_cov_b_yx = 0;
+    handle->_cov_b_yy = 0;
+    handle->_cov_d_xx = 0;
+    handle->_cov_d_xy = 0;
+    handle->_cov_d_yy = 0;
+
+    handle->_meas_var_x = Q8_24_FROM_FLOAT(MEAS_VAR_X);
+    handle->_meas_var_y = Q8_24_FROM_FLOAT(MEAS_VAR_Y);
+    handle->_meas_cov_xy = Q8_24_FROM_FLOAT(MEAS_COV_XY);
+    handle->_max_acc = Q8_24_FROM_FLOAT(MAX_ACC);
+    handle->_process_noise_proportionality = Q8_24_FROM_FLOAT(PROC_NOISE_PROP);
+
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_q_update(
+        kalman_q_robot_handle_t * handle,
+        const position_q_t * measurement,
+        q8_24_t delta_t,
+        robot_pos_q_t * dest)
+{
+    if(handle == NULL || dest == NULL || delta_t < 0) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+
+    predict(handle, delta_t);
+
+    if(measurement != NULL) {
+        update(handle, measurement);
+    }
+
+    // write resulting position (and associated variances) to dest
+    dest->x = handle->_x;
+    dest->y = handle->_y;
+    dest->var_x = handle->_cov_a_xx;
+    dest->var_y = handle->_cov_a_yy;
+    dest->cov_xy = handle->_cov_a_xy;
+
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+uint8_t kalman_q_update_measurement_covariance(
+        kalman_q_robot_handle_t * handle,
+        q8_24_t var_x,
+        q8_24_t var_y,
+        q8_24_t cov_xy)
+{
+    if(handle == NULL) {
+        return 0;
+    }
+
+    os_mutex_take(&(handle->_mutex));
+    handle->_meas_var_x = var_x;
+    handle->_meas_var_y = var_y;
+    handle->_meas_cov_xy = cov_xy;
+    os_mutex_release(&(handle->_mutex));
+
+    return 1;
+}
+
+// private function implementations
+
+// x = F*x, P = F*P*F^T + Q, see predict_covariance in kalman.c
+static void predict(kalman_q_robot_handle_t * handle, q8_24_t delta_t)
+{
+    kalman_q_robot_handle_t * h = handle;
+    q8_24_t dt = delta_t;
+    q8_24_t dt2 = q8_24_mul(dt, dt);
+
+    h->_x += q8_24_mul(dt, h->_v_x);
+    h->_y += q8_24_mul(dt, h->_v_y);
+
+    // A = A + dt*(B + B^T) + dt*dt*D
+    h->_cov_a_xx += 2 * q8_24_mul(dt, h->_cov_b_xx) + q8_24_mul(dt2, h->_cov_d_xx);
+    h->_cov_a_xy += q8_24_mul(dt, h->_cov_b_xy + h->_cov_b_yx)
+        + q8_24_mul(dt2, h->_cov_d_xy);
+    h->_cov_a_yy += 2 * q8_24_mul(dt, h->_cov_b_yy) + q8_24_mul(dt2, h->_cov_d_yy);
+
+    // B = B + dt*D
+    h->_cov_b_xx += q8_24_mul(dt, h->_cov_d_xx);
+    h->_cov_b_xy += q8_24_mul(dt, h->_cov_d_xy);
+    h->_cov_b_yx += q8_24_mul(dt, h->_cov_d_xy);
+    h->_cov_b_yy += q8_24_mul(dt, h->_cov_d_yy);
+
+    // process noise, every block of Q is a multiple of the identity
+    q8_24_t base_factor =
+        q8_24_mul(h->_process_noise_proportionality, h->_max_acc);
+    q8_24_t q_d = q8_24_mul(dt2, base_factor);
+    q8_24_t q_b = q8_24_mul(dt, q_d) / 2;
+    q8_24_t q_a = q8_24_mul(dt2, q_d) / 4;
+
+    h->_cov_a_xx += q_a;
+    h->_cov_a_yy += q_a;
+    h->_cov_b_xx += q_b;
+    h->_cov_b_yy += q_b;
+    h->_cov_d_xx += q_d;
+    h->_cov_d_yy += q_d;
+}
+
+// K1 = A*S^-1, K2 = B^T*S^-1 with S = A + R, then
+// x = x + K*(z - x), A -= K1*A, B -= K1*B, D -= K2*B
+//
+// S^-1 is never formed, the gain is adj(S)*... / det(S) with the
+// numerators and the determinant kept exactly on 64 bits (48 fractional
+// bits), this keeps the precision for small covariances
+static void update(
+        kalman_q_robot_handle_t * handle,
+        const position_q_t * measurement)
+{
+    kalman_q_robot_handle_t * h = handle;
+
+    int64_t s_a = h->_cov_a_xx + h->_meas_var_x;
+    int64_t s_b = h->_cov_a_xy + h->_meas_cov_xy;
+    int64_t s_d = h->_cov_a_yy + h->_meas_var_y;
+    int64_t det = s_a * s_d - s_b * s_b;
+
+    // the measurement carries no usable information, don't update
+    if(det <= 0) {
+        return;
+    }
+
+    int64_t a_xx = h->_cov_a_xx;
+    int64_t a_xy = h->_cov_a_xy;
+    int64_t a_yy = h->_cov_a_yy;
+    int64_t b_xx = h->_cov_b_xx;
+    int64_t b_xy = h->_cov_b_xy;
+    int64_t b_yx = h->_cov_b_yx;
+    int64_t b_yy = h->_cov_b_yy;
+
+    q8_24_t k1_a = q8_24_ratio(a_xx * s_d - a_xy * s_b, det);
+    q8_24_t k1_b = q8_24_ratio(a_xy * s_a - a_xx * s_b, det);
+    q8_24_t k1_c = q8_24_ratio(a_xy * s_d - a_yy * s_b, det);
+    q8_24_t k1_d = q8_24_ratio(a_yy * s_a - a_xy * s_b, det);
+    q8_24_t k2_a = q8_24_ratio(b_xx * s_d - b_yx * s_b, det);
+    q8_24_t k2_b = q8_24_ratio(b_yx * s_a - b_xx * s_b, det);
+    q8_24_t k2_c = q8_24_ratio(b_xy * s_d - b_yy * s_b, det);
+    q8_24_t k2_d = q8_24_ratio(b_yy * s_a - b_xy * s_b, det);
+
+    // update state
+    q8_24_t r_x = measurement->x - h->_x;
+    q8_24_t r_y = measurement->y - h->_y;
+    h->_x += q8_24_mul(k1_a, r_x) + q8_24_mul(k1_b, r_y);
+    h->_y += q8_24_mul(k1_c, r_x) + q8_24_mul(k1_d, r_y);
+    h->_v_x += q8_24_mul(k2_a, r_x) + q8_24_mul(k2_b, r_y);
+    h->_v_y += q8_24_mul(k2_c, r_x) + q8_24_mul(k2_d, r_y);
+
+    // update covariance, upper triangle only
+    h->_cov_a_xx -= q8_24_mul(k1_a, a_xx) + q8_24_mul(k1_b, a_xy);
+    h->_cov_a_xy -= q8_24_mul(k1_a, a_xy) + q8_24_mul(k1_b, a_yy);
+    h->_cov_a_yy -= q8_24_mul(k1_c, a_xy) + q8_24_mul(k1_d, a_yy);
+
+    h->_cov_b_xx -= q8_24_mul(k1_a, b_xx) + q8_24_mul(k1_b, b_yx);
+    h->_cov_b_xy -= q8_24_mul(k1_a, b_xy) + q8_24_mul(k1_b, b_yy);
+    h->_cov_b_yx -= q8_24_mul(k1_c, b_xx) + q8_24_mul(k1_d, b_yx);
+    h->_cov_b_yy -= q8_24_mul(k1_c, b_xy) + q8_24_mul(k1_d, b_yy);
+
+    h->_cov_d_xx -= q8_24_mul(k2_a, b_xx) + q8_24_mul(k2_b, b_yx);
+    h->_cov_d_xy -= q8_24_mul(k2_a, b_xy) + q8_24_mul(k2_b, b_yy);
+    h->_cov_d_yy -= q8_24_mul(k2_c, b_xy) + q8_24_mul(k2_d, b_yy);
+}
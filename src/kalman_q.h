@@ -0,0 +1,89 @@
+
+#ifndef BEACON_KALMAN_Q_H
+#define BEACON_KALMAN_Q_H
+
+#include <stdint.h>
+
+#include "fixed_point.h"
+#include "positioning_q.h"
+#include "platform-abstraction/mutex.h"
+
+// fixed-point counterpart of kalman.h, the same constant velocity filter
+// with a joint measurement update. every quantity is a q8_24_t (meters,
+// seconds, ...), products are computed on 64 bits.
+
+// position and associated covariances predicted by kalman filter
+//
+// also used for initialization of kalman filter
+typedef struct {
+    q8_24_t x;
+    q8_24_t y;
+    q8_24_t var_x;
+    q8_24_t var_y;
+    q8_24_t cov_xy;
+} robot_pos_q_t;
+
+// WARNING : this type should be opaque, its only here to
+// allow static allocation by user
+//
+// the state covariance is stored packed like covariance_t
+typedef struct {
+    mutex_t _mutex;
+    q8_24_t _x;
+    q8_24_t _y;
+    q8_24_t _v_x;
+    q8_24_t _v_y;
+    q8_24_t _cov_a_xx;
+    q8_24_t _cov_a_xy;
+    q8_24_t _cov_a_yy;
+    q8_24_t _cov_b_xx;
+    q8_24_t _cov_b_xy;
+    q8_24_t _cov_b_yx;
+    q8_24_t _cov_b_yy;
+    q8_24_t _cov_d_xx;
+    q8_24_t _cov_d_xy;
+    q8_24_t _cov_d_yy;
+    q8_24_t _meas_var_x;
+    q8_24_t _meas_var_y;
+    q8_24_t _meas_cov_xy;
+    q8_24_t _max_acc;
+    q8_24_t _process_noise_proportionality;
+} kalman_q_robot_handle_t;
+
+// intializes all fields of 'handle'
+// 'initial_config' holds starting position (and associated covariances)
+//
+// return 1 if initialization was successful
+// return 0 if initialization failed (input parameters NULL)
+uint8_t kalman_q_init(
+        kalman_q_robot_handle_t * handle,
+        const robot_pos_q_t * initial_config);
+
+// updates state estimates with information provided by 'measurement'
+// 'delta_t' should be the time since the last update
+//
+// writes update estimate of position (and associated covariance) to
+// memory pointed by 'dest'
+//
+// return 1 if everything went fine
+// return 0 on failure (handle or dest NULL, delta_t < 0)
+// if the measurement passed in is NULL it will skip the kalman update step
+// and only make a prediction
+uint8_t kalman_q_update(
+        kalman_q_robot_handle_t * handle,
+        const position_q_t * measurement,
+        q8_24_t delta_t,
+        robot_pos_q_t * dest);
+
+// update measurement covariance in case you don't want to use
+// the default provided in 'beacon_config.h'
+//
+// return 1 on success
+// return 0 on failure (handle is NULL)
+uint8_t kalman_q_update_measurement_covariance(
+        kalman_q_robot_handle_t * handle,
+        q8_24_t var_x,
+        q8_24_t var_y,
+        q8_24_t cov_xy);
+
+#endif
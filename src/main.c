@@ -4,19 +4,21 @@
 #include <libopencm3/stm32/usart.h>
 #include <libopencm3/stm32/f3/nvic.h>
 #include <libopencm3/stm32/exti.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <unistd.h>
 #include <string.h>
 
 
 #include <platform-abstraction/threading.h>
-#include <platform-abstraction/semaphore.h>
-#include <platform-abstraction/mutex.h>
 #include <platform-abstraction/timestamp.h>
 
 #include "beacon_angles.h"
-#include "positioning.h"
-#include "kalman.h"
+#include "edge_capture.h"
+#include "pipeline.h"
+#include "runtime.h"
 #include "beacon_config.h"
 
 
@@ -39,6 +41,9 @@ void uart2_init(void)
     usart_set_parity(USART2, USART_PARITY_NONE);
     usart_set_flow_control(USART2, USART_FLOWCONTROL_NONE);
     usart_enable(USART2);
+    // transmit and receive interrupts, see runtime.c
+    usart_enable_rx_interrupt(USART2);
+    nvic_enable_irq(NVIC_USART2_EXTI26_IRQ);
 }
 
 void uart1_init(void)
@@ -53,13 +58,16 @@ void uart1_init(void)
     gpio_set_af(GPIOC, GPIO_AF7, GPIO5);
 
     rcc_periph_clock_enable(RCC_USART1);
-    usart_set_baudrate(USART1, 2*9600);
+    usart_set_baudrate(USART1, UART1_BAUDRATE);
     usart_set_databits(USART1, 8);
     usart_set_stopbits(USART1, USART_STOPBITS_1);
     usart_set_mode(USART1, USART_MODE_TX_RX);
     usart_set_parity(USART1, USART_PARITY_NONE);
     usart_set_flow_control(USART1, USART_FLOWCONTROL_NONE);
     usart_enable(USART1);
+    // transmit and receive interrupts, see runtime.c
+    usart_enable_rx_interrupt(USART1);
+    nvic_enable_irq(NVIC_USART1_EXTI25_IRQ);
 }
 
 void exti_irq_init(void)
@@ -67,22 +75,8 @@ void exti_irq_init(void)
     // SYSCFG clock is needed for EXTI
     rcc_periph_clock_enable(RCC_SYSCFG);
 
-    // Setup for PF0
-    exti_enable_request(EXTI0);
-    exti_set_trigger(EXTI0, EXTI_TRIGGER_RISING);
-    exti_select_source(EXTI0, GPIOF);
-    nvic_enable_irq(NVIC_EXTI0_IRQ);
-    // Setup for PF1
-    exti_enable_request(EXTI1);
-    exti_set_trigger(EXTI1, EXTI_TRIGGER_RISING);
-    exti_select_source(EXTI1, GPIOF);
-    nvic_enable_irq(NVIC_EXTI1_IRQ);
-    // Setup for PD2
-    exti_enable_request(EXTI2);
-    exti_set_trigger(EXTI2, EXTI_TRIGGER_RISING);
-    exti_select_source(EXTI2, GPIOD);
-    nvic_enable_irq(NVIC_EXTI2_TSC_IRQ);
-    /*
+    // laser one is on the timer input captures, see capture_init
+
     // Setup for PB8 & PB9
     exti_enable_request(EXTI8);
     exti_set_trigger(EXTI8, EXTI_TRIGGER_RISING);
@@ -91,12 +85,14 @@ void exti_irq_init(void)
     exti_set_trigger(EXTI9, EXTI_TRIGGER_RISING);
     exti_select_source(EXTI9, GPIOB);
     nvic_enable_irq(NVIC_EXTI9_5_IRQ);
-    // Setup for PA10
+    // Setup for PA10, EXTI10 is free since beacon C of laser one (PB10)
+    // is on TIM2_CH3
+    rcc_periph_clock_enable(RCC_GPIOA);
+    gpio_mode_setup(GPIOA, GPIO_MODE_INPUT, GPIO_PUPD_NONE, GPIO10);
     exti_enable_request(EXTI10);
     exti_set_trigger(EXTI10, EXTI_TRIGGER_RISING);
-    exti_select_source(EXTI10, GPIOD);
+    exti_select_source(EXTI10, GPIOA);
     nvic_enable_irq(NVIC_EXTI15_10_IRQ);
-    */
 
     // We'll also need to read the state of PB8 & PB9
     rcc_periph_clock_enable(RCC_GPIOB);
@@ -105,6 +101,92 @@ void exti_irq_init(void)
 }
 
 
+volatile uint32_t laser_one_edges[3][BEACON_CAPTURE_BUFFER_SIZE];
+
+// DMA1 channel copying the captures of every beacon of laser one
+static const uint8_t laser_one_dma_channel[3] = {
+    DMA_CHANNEL5,   // A, TIM2_CH1
+    DMA_CHANNEL7,   // B, TIM2_CH2
+    DMA_CHANNEL1,   // C, TIM2_CH3
+};
+
+static uint32_t laser_one_write_index(void *context, enum beacon_nb beacon)
+{
+    (void) context;
+    uint8_t channel = laser_one_dma_channel[beacon];
+
+    return BEACON_CAPTURE_BUFFER_SIZE - DMA_CNDTR(DMA1, channel);
+}
+
+// laser one edges latched by TIM2 and moved to laser_one_edges by DMA,
+// only the captures of beacon A raise an interrupt (see tim2_isr)
+void capture_init(void)
+{
+    static const enum tim_ic_id ic[3] = {TIM_IC1, TIM_IC2, TIM_IC3};
+    static const enum tim_ic_input ic_input[3] = {
+        TIM_IC_IN_TI1, TIM_IC_IN_TI2, TIM_IC_IN_TI3};
+    static const volatile uint32_t * ccr[3] = {
+        &TIM2_CCR1, &TIM2_CCR2, &TIM2_CCR3};
+    static const uint32_t dma_request[3] = {
+        TIM_DIER_CC1DE, TIM_DIER_CC2DE, TIM_DIER_CC3DE};
+    int i;
+
+    // Beacon A: PA0 (TIM2_CH1), Beacon B: PA1 (TIM2_CH2)
+    rcc_periph_clock_enable(RCC_GPIOA);
+    gpio_mode_setup(GPIOA, GPIO_MODE_AF, GPIO_PUPD_NONE, GPIO0 | GPIO1);
+    gpio_set_af(GPIOA, GPIO_AF1, GPIO0 | GPIO1);
+    // Beacon C: PB10 (TIM2_CH3)
+    rcc_periph_clock_enable(RCC_GPIOB);
+    gpio_mode_setup(GPIOB, GPIO_MODE_AF, GPIO_PUPD_NONE, GPIO10);
+    gpio_set_af(GPIOB, GPIO_AF1, GPIO10);
+
+    rcc_periph_clock_enable(RCC_DMA1);
+    for(i = 0; i < 3; i++){
+        uint8_t channel = laser_one_dma_channel[i];
+        dma_channel_reset(DMA1, channel);
+        dma_set_peripheral_address(DMA1, channel, (uint32_t)ccr[i]);
+        dma_set_memory_address(DMA1, channel, (uint32_t)laser_one_edges[i]);
+        dma_set_number_of_data(DMA1, channel, BEACON_CAPTURE_BUFFER_SIZE);
+        dma_set_read_from_peripheral(DMA1, channel);
+        dma_set_peripheral_size(DMA1, channel, DMA_CCR_PSIZE_32BIT);
+        dma_set_memory_size(DMA1, channel, DMA_CCR_MSIZE_32BIT);
+        dma_enable_memory_increment_mode(DMA1, channel);
+        dma_enable_circular_mode(DMA1, channel);
+        dma_set_priority(DMA1, channel, DMA_CCR_PL_VERY_HIGH);
+        dma_enable_channel(DMA1, channel);
+    }
+
+    // TIM2 is a 32 bit free running counter, its clock is twice the APB1
+    // clock since APB1 is prescaled
+    rcc_periph_clock_enable(RCC_TIM2);
+    timer_reset(TIM2);
+    timer_set_mode(TIM2, TIM_CR1_CKD_CK_INT, TIM_CR1_CMS_EDGE, TIM_CR1_DIR_UP);
+    timer_set_prescaler(TIM2, 2 * rcc_apb1_frequency / BEACON_CAPTURE_FREQ - 1);
+    timer_set_period(TIM2, 0xffffffff);
+
+    for(i = 0; i < 3; i++){
+        timer_ic_set_input(TIM2, ic[i], ic_input[i]);
+        timer_ic_set_polarity(TIM2, ic[i], TIM_IC_RISING);
+        timer_ic_set_prescaler(TIM2, ic[i], TIM_IC_PSC_OFF);
+        timer_ic_set_filter(TIM2, ic[i], TIM_IC_OFF);
+        timer_ic_enable(TIM2, ic[i]);
+        timer_enable_irq(TIM2, dma_request[i]);
+    }
+    timer_enable_irq(TIM2, TIM_DIER_CC1IE);
+    nvic_enable_irq(NVIC_TIM2_IRQ);
+
+    timer_enable_counter(TIM2);
+}
+
+
+// converts a capture timestamp of the recent past to os_timestamp_get time
+uint32_t capture_to_os_time(uint32_t capture)
+{
+    uint32_t age = timer_get_counter(TIM2) - capture;
+    return os_timestamp_get() - age / (BEACON_CAPTURE_FREQ / 1000000);
+}
+
+
 #define FPCCR (*((volatile uint32_t *)0xE000EF34))
 #define CPACR (*((volatile uint32_t *)0xE000ED88))
 
@@ -130,122 +212,25 @@ void fpu_config(void)
 
 
 beacon_angles_t laser_one;
+edge_capture_t laser_one_capture;
 beacon_angles_t laser_two;
 
-position_t beacon_a = BEACON_POS_A;
-position_t beacon_b = BEACON_POS_B;
-position_t beacon_c = BEACON_POS_C;
-reference_triangle_t table;
-
-robot_pos_t robot_one_pos;
-mutex_t robot_one_pos_access;
-
-position_t laser_one_pos;
-mutex_t laser_one_pos_access;
-semaphore_t laser_one_pos_ready;
-
-os_thread_t laser_one_thread;
-THREAD_STACK laser_one_stack[1024];
-
-#define DEG(X) (X * 180 / 3.14159)
-
-void laser_one_main(void *context)
+// laser two is timestamped with os_timestamp_get
+uint32_t laser_two_to_os_time(uint32_t timestamp)
 {
-    (void) context;
-
-
-    while (1) {
-
-        os_semaphore_wait(&laser_one.measurement_ready);
-        if(beacon_angles_calculate(&laser_one)){
-            os_mutex_take(&laser_one_pos_access);
-            os_mutex_take(&laser_one.access);
-            while(os_semaphore_try(&laser_one_pos_ready));
-            if(positioning_from_angles(
-                        laser_one.alpha,
-                        laser_one.gamma,
-                        laser_one.beta,
-                        &table, &laser_one_pos)){
-                gpio_toggle(GPIOB, GPIO13);
-                os_mutex_release(&laser_one_pos_access);
-                os_mutex_release(&laser_one.access);
-                os_semaphore_signal(&laser_one_pos_ready);
-                //printf("x: %f, y: %f\n\r", laser_one_pos.x, laser_one_pos.y);
-            } else{
-                os_mutex_release(&laser_one_pos_access);
-                os_mutex_release(&laser_one.access);
-            }
-
-        }
-    }
+    return timestamp;
 }
 
-
-os_thread_t kalman_thread;
-THREAD_STACK kalman_stack[1024];
-
-void kalman_main(void *context)
+// toggles the user LED
+void pipeline_fix_hook(void)
 {
-    uint32_t timestamp;
-    uint32_t timestamp_diff;
-    uint32_t period;
-    uint32_t wait_time_us;
-    float delta_t;
-    robot_pos_t init_pos;
-    kalman_robot_handle_t handle;
-
-    init_pos.x = KALMAN_INIT_POS_X;
-    init_pos.y = KALMAN_INIT_POS_Y;
-    init_pos.var_x = KALMAN_INIT_POS_VAR;
-    init_pos.var_y = KALMAN_INIT_POS_VAR;
-    init_pos.cov_xy = 0.0f;
-
-    kalman_init(&handle, &init_pos);
-
-    period = 1000000 / KALMAN_TRANS_FREQ;
-
-    timestamp = os_timestamp_get();
-
-    // update loop
-    while(42){
-
-        timestamp_diff = os_timestamp_diff_and_update(&timestamp);
-        wait_time_us = period - timestamp_diff;
-        if(wait_time_us > 0){
-            os_thread_sleep_least_us(wait_time_us);
-        }
-
-        timestamp_diff += os_timestamp_diff_and_update(&timestamp);
-        delta_t = timestamp_diff / 1000000.0f;
-
-        os_mutex_take(&robot_one_pos_access);
-        if(os_semaphore_try(&laser_one_pos_ready)){
-            kalman_update(&handle, &laser_one_pos, delta_t, &robot_one_pos);
-        } else{
-            kalman_update(&handle, NULL, delta_t, &robot_one_pos);
-        }
-        os_mutex_release(&robot_one_pos_access);
-    }
+    gpio_toggle(GPIOB, GPIO13);
 }
 
-
-os_thread_t communication_thread;
-THREAD_STACK communication_stack[1024];
-
-void communication_main(void *context)
+// the telemetry goes out on stdout, USART1
+uint32_t pipeline_output_dropped(void)
 {
-    robot_pos_t robot_one_pos_copy;
-    while(42){
-        os_thread_sleep_least_us(1000000 / OUTPUT_FREQ);
-        os_mutex_take(&robot_one_pos_access);
-        memcpy(&robot_one_pos_copy, &robot_one_pos, sizeof(robot_pos_t));
-        os_mutex_release(&robot_one_pos_access);
-        printf("%1.3f %1.3f %1.3f %1.3f %1.3f\n",
-                robot_one_pos_copy.x, robot_one_pos_copy.y,
-                robot_one_pos_copy.var_x, robot_one_pos_copy.var_y,
-                robot_one_pos_copy.cov_xy);
-    }
-
+    return uart_tx_dropped(USART1);
 }
 
 int main(void)
@@ -259,33 +244,39 @@ int main(void)
 
     beacon_angles_init(&laser_one);
     beacon_angles_init(&laser_two);
-    beacon_angles_set_minimal_period(&laser_one, 50000);
+    // 50 [ms]
+    beacon_angles_set_minimal_period(&laser_one, BEACON_CAPTURE_FREQ / 20);
     beacon_angles_set_minimal_period(&laser_two, 50000);
 
-    positioning_reference_triangle_from_points(&beacon_a, &beacon_b, &beacon_c, &table);
-
-
     exti_irq_init();
+    // before the capture interrupt can signal it, the DMA starts writing
+    // at slot 0 which is where the consumer starts as well
+    edge_capture_init(&laser_one_capture,
+                      laser_one_edges[A], laser_one_edges[B], laser_one_edges[C],
+                      BEACON_CAPTURE_BUFFER_SIZE, laser_one_write_index, NULL);
+    capture_init();
 
     // User LED
     rcc_periph_clock_enable(RCC_GPIOB);
     gpio_mode_setup(GPIOB, GPIO_MODE_OUTPUT, GPIO_PUPD_NONE, GPIO13);
 
 
-    os_mutex_init(&robot_one_pos_access);
+    pipeline_init();
+
+    lasers[0].angles = &laser_one;
+    lasers[0].capture = &laser_one_capture;
+    lasers[0].timestamp_freq = BEACON_CAPTURE_FREQ;
+    lasers[0].to_os_time = capture_to_os_time;
 
-    os_mutex_init(&laser_one_pos_access);
-    os_semaphore_init(&laser_one_pos_ready, 0);
+    lasers[1].angles = &laser_two;
+    lasers[1].capture = NULL;
+    lasers[1].timestamp_freq = 1000000;
+    lasers[1].to_os_time = laser_two_to_os_time;
 
 
     os_init();
 
-    os_thread_create(&laser_one_thread, laser_one_main, laser_one_stack,
-            sizeof(laser_one_stack), "L1", 0, NULL);
-    os_thread_create(&kalman_thread, kalman_main, kalman_stack,
-            sizeof(kalman_stack), "Kalman", 0, NULL);
-    os_thread_create(&communication_thread, communication_main, communication_stack,
-            sizeof(communication_stack), "Communication", 2, NULL);
+    pipeline_start();
 
     os_run();
 
@@ -293,30 +284,6 @@ int main(void)
 }
 
 
-// Beacon A, laser 1
-// PF0 (connected to pin 6 on JP5)
-void exti0_isr(void)
-{
-    exti_reset_request(EXTI0);
-    beacon_angles_update_timestamp(&laser_one, A, os_timestamp_get());
-}
-
-// Beacon B, laser 1
-// PF1 (connected to pin 10 on JP5)
-void exti1_isr(void)
-{
-    exti_reset_request(EXTI1);
-    beacon_angles_update_timestamp(&laser_one, B, os_timestamp_get());
-}
-
-// Beacon C, laser 1
-// PD2 (connected to pin 12 on JP5)
-void exti2_tsc_isr(void)
-{
-    exti_reset_request(EXTI2);
-    beacon_angles_update_timestamp(&laser_one, C, os_timestamp_get());
-}
-
 // Beacon A and B, laser 2
 // PB8 (connected to pin 5 on JP5) & PB9 (connected to pin 9 on JP5)
 void exti9_5_isr(void)
@@ -342,3 +309,11 @@ void exti15_10_isr(void)
     beacon_angles_update_timestamp(&laser_two, C, os_timestamp_get());
 }
 
+// Beacon A, laser 1
+// the DMA already holds the timestamp, the laser one thread drains it
+void tim2_isr(void)
+{
+    // the DMA reading TIM2_CCR1 may have cleared it already
+    timer_clear_flag(TIM2, TIM_SR_CC1IF);
+    edge_capture_signal(&laser_one_capture);
+}
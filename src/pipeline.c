@@ -0,0 +1,682 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <platform-abstraction/threading.h>
+#include <platform-abstraction/semaphore.h>
+#include <platform-abstraction/mutex.h>
+#include <platform-abstraction/timestamp.h>
+
+#include "pipeline.h"
+#include "telemetry.h"
+#include "edge_trace.h"
+#include "float_math.h"
+
+#if KALMAN_USE_EKF && BEACON_FIXED_POINT
+#error "the EKF has no fixed-point implementation"
+#endif
+
+#if KALMAN_USE_EKF && LASER_FUSION_MODE == LASER_FUSION_JOINT
+#error "the EKF tracks the rotation speed of a single laser"
+#endif
+
+// 10 bits per byte on the UART
+#if OUTPUT_FREQ * (TELEMETRY_ROBOT_STATE_SIZE + TELEMETRY_FRAME_OVERHEAD) * 10 \
+    > UART1_BAUDRATE
+#error "the telemetry doesn't fit in UART1, lower OUTPUT_FREQ"
+#endif
+
+
+position_t beacon_a = BEACON_POS_A;
+position_t beacon_b = BEACON_POS_B;
+position_t beacon_c = BEACON_POS_C;
+reference_triangle_t table;
+
+#if BEACON_FIXED_POINT
+position_q_t beacon_a_q;
+position_q_t beacon_b_q;
+position_q_t beacon_c_q;
+reference_triangle_q_t table_q;
+#endif
+
+robot_t robots[NB_ROBOTS];
+laser_t lasers[NB_LASERS];
+semaphore_t laser_fix_ready;
+
+// written by the command thread, the communication thread starts or stops
+// the trace when it sees them change
+volatile uint8_t trace_enable = 0;
+volatile uint32_t trace_config_count = 0;
+
+#if MEAS_COV_FROM_GEOMETRY
+// added to the covariance of every fix, set by the cov command
+position_covariance_t meas_cov_min = {MEAS_VAR_MIN, MEAS_VAR_MIN, 0.0f};
+mutex_t meas_cov_min_mutex;
+#endif
+
+
+os_thread_t laser_one_thread;
+THREAD_STACK laser_one_stack[256];
+os_thread_t laser_two_thread;
+THREAD_STACK laser_two_stack[256];
+
+bool laser_fix(const laser_t *laser, laser_fix_t *fix)
+{
+    const beacon_angles_t *angles = laser->angles;
+
+    fix->time = laser->to_os_time(angles->timestamp);
+
+#if KALMAN_USE_EKF
+    // the EKF doesn't need a triangulated fix, pass the raw time
+    // deltas (in the order positioning_from_angles would use them)
+    fix->meas.dt_alpha = angles->delta_alpha / (float)laser->timestamp_freq;
+    fix->meas.dt_beta = angles->delta_gamma / (float)laser->timestamp_freq;
+    fix->meas.dt_gamma = angles->delta_beta / (float)laser->timestamp_freq;
+
+    return true;
+#elif BEACON_FIXED_POINT
+    // angles straight from the timer ticks, no float involved
+    uint32_t period = angles->delta_alpha + angles->delta_beta
+        + angles->delta_gamma;
+
+    return positioning_q_from_angles(
+            positioning_q_angle_from_ticks(angles->delta_alpha, period),
+            positioning_q_angle_from_ticks(angles->delta_gamma, period),
+            positioning_q_angle_from_ticks(angles->delta_beta, period),
+            &table_q, &fix->pos_q);
+#elif MEAS_COV_FROM_GEOMETRY
+    // an edge off by dt turns the bearing of its beacon by 2 Pi dt / period
+    uint32_t period = angles->delta_alpha + angles->delta_beta
+        + angles->delta_gamma;
+    float rad_per_s = FLOAT_2_PI * (float)laser->timestamp_freq
+        / (float)period;
+
+    if(!positioning_from_angles_with_covariance(
+                angles->alpha,
+                angles->gamma,
+                angles->beta,
+                rad_per_s * rad_per_s * MEAS_VAR_EDGE_TIME,
+                &table, &fix->pos, &fix->cov)){
+        return false;
+    }
+    os_mutex_take(&meas_cov_min_mutex);
+    fix->cov.var_x += meas_cov_min.var_x;
+    fix->cov.var_y += meas_cov_min.var_y;
+    fix->cov.cov_xy += meas_cov_min.cov_xy;
+    os_mutex_release(&meas_cov_min_mutex);
+
+    // too close to the circle of the beacons to tell the filter anything
+    return fix->cov.var_x + fix->cov.var_y < MEAS_VAR_MAX;
+#else
+    return positioning_from_angles(
+            angles->alpha,
+            angles->gamma,
+            angles->beta,
+            &table, &fix->pos);
+#endif
+}
+
+void laser_main(void *context)
+{
+    laser_t *laser = (laser_t *)context;
+
+    while (1) {
+
+        if(laser->capture != NULL){
+            // woken up by the capture of beacon A, which closes a rotation.
+            // the timeout drains the edges of B and C while A is hidden
+            if(!os_semaphore_try(&laser->angles->measurement_ready)){
+                edge_capture_wait(laser->capture, BEACON_CAPTURE_POLL_PERIOD);
+                edge_capture_drain(laser->capture, laser->angles);
+                continue;
+            }
+        } else{
+            os_semaphore_wait(&laser->angles->measurement_ready);
+        }
+        // the angles are only written by beacon_angles_calculate in this
+        // thread, a fix the kalman thread didn't fuse yet is replaced
+        if(beacon_angles_calculate(laser->angles)
+                && laser_fix(laser, triple_buffer_write_buffer(&laser->fix))){
+            triple_buffer_publish(&laser->fix);
+            pipeline_fix_hook();
+            os_semaphore_signal(&laser_fix_ready);
+        }
+    }
+}
+
+
+os_thread_t kalman_thread;
+THREAD_STACK kalman_stack[512];
+
+void filter_init(filter_handle_t *handle, uint32_t time)
+{
+#if BEACON_FIXED_POINT
+    robot_pos_q_t init_pos;
+
+    init_pos.x = Q8_24_FROM_FLOAT(KALMAN_INIT_POS_X);
+    init_pos.y = Q8_24_FROM_FLOAT(KALMAN_INIT_POS_Y);
+    init_pos.var_x = Q8_24_FROM_FLOAT(KALMAN_INIT_POS_VAR);
+    init_pos.var_y = Q8_24_FROM_FLOAT(KALMAN_INIT_POS_VAR);
+    init_pos.cov_xy = 0;
+
+    kalman_q_init(&handle->filter, &init_pos);
+#else
+    robot_pos_t init_pos;
+
+    init_pos.x = KALMAN_INIT_POS_X;
+    init_pos.y = KALMAN_INIT_POS_Y;
+    init_pos.var_x = KALMAN_INIT_POS_VAR;
+    init_pos.var_y = KALMAN_INIT_POS_VAR;
+    init_pos.cov_xy = 0.0f;
+
+#if KALMAN_USE_EKF
+    ekf_init(&handle->filter, &init_pos, EKF_INIT_OMEGA, &table);
+#else
+    kalman_init(&handle->filter, &init_pos);
+    kalman_history_init(&handle->history, &handle->filter, time);
+#endif
+#endif
+
+    handle->time = time;
+}
+
+// advances the filter of 'robot' to 'time', fuses 'fix' unless it is NULL
+// and publishes the estimate
+//
+// the kalman filter replays its recent steps to fuse a fix older than its
+// state, the other filters can't go back in time and fuse it at the filter
+// time
+void filter_update(robot_t *robot, uint32_t time, const laser_fix_t *fix)
+{
+    filter_handle_t *handle = &robot->filter;
+    robot_estimate_t *estimate = triple_buffer_write_buffer(&robot->estimate);
+    uint8_t updated;
+
+#if BEACON_FIXED_POINT || KALMAN_USE_EKF
+    uint32_t delta_t_us = 0;
+
+    if((int32_t)(time - handle->time) > 0){
+        delta_t_us = time - handle->time;
+        handle->time = time;
+    }
+#endif
+
+#if BEACON_FIXED_POINT
+    // [us] to [s]
+    q8_24_t delta_t = (q8_24_t)(((uint64_t)delta_t_us << 24) / 1000000);
+
+    updated = kalman_q_update(&handle->filter,
+            fix != NULL ? &fix->pos_q : NULL, delta_t, &estimate->pos);
+#elif KALMAN_USE_EKF
+    updated = ekf_update(&handle->filter, fix != NULL ? &fix->meas : NULL,
+            delta_t_us / 1000000.0f, &estimate->pos);
+#else
+    // recent odometry drives the prediction, replays of older steps use it
+    // too
+    triple_buffer_update(&robot->odometry);
+    const odometry_input_t *odometry = triple_buffer_read(&robot->odometry);
+    if(odometry->valid
+            && (int32_t)(time - odometry->time) < ODOMETRY_TIMEOUT){
+        kalman_set_odometry(&handle->filter, &odometry->odometry);
+    } else{
+        kalman_set_odometry(&handle->filter, NULL);
+    }
+
+#if MEAS_COV_FROM_GEOMETRY
+    updated = kalman_history_update_with_covariance(&handle->history,
+            fix != NULL ? &fix->pos : NULL, fix != NULL ? &fix->cov : NULL,
+            time, &estimate->pos);
+#else
+    updated = kalman_history_update(&handle->history,
+            fix != NULL ? &fix->pos : NULL, time, &estimate->pos);
+#endif
+    if(updated && (int32_t)(time - handle->time) > 0){
+        handle->time = time;
+    }
+#endif
+
+    if(updated){
+        if(fix != NULL){
+            robot->fix_time = fix->time;
+        }
+        estimate->time = handle->time;
+        estimate->fix_time = robot->fix_time;
+        triple_buffer_publish(&robot->estimate);
+    }
+}
+
+void kalman_main(void *context)
+{
+    uint32_t period = 1000000 / KALMAN_TRANS_FREQ;
+    uint32_t now = os_timestamp_get();
+    uint32_t oldest;
+    int i;
+
+    for(i = 0; i < NB_ROBOTS; i++){
+        filter_init(&robots[i].filter, now);
+    }
+
+    // update loop
+    while(42){
+        // a prediction is due 'period' after the robot updated the
+        // longest ago
+        oldest = robots[0].filter.time;
+        for(i = 1; i < NB_ROBOTS; i++){
+            if((int32_t)(robots[i].filter.time - oldest) < 0){
+                oldest = robots[i].filter.time;
+            }
+        }
+
+#if KALMAN_EVENT_DRIVEN
+        // a fix is fused as soon as it arrives, without one a prediction
+        // keeps the output going every 'period'
+        int32_t wait_time_us = (int32_t)(oldest + period - os_timestamp_get());
+        if(wait_time_us > 0){
+            os_semaphore_wait_timeout(&laser_fix_ready, wait_time_us);
+        }
+#else
+        uint32_t elapsed = os_timestamp_get() - oldest;
+        if(elapsed < period){
+            os_thread_sleep_least_us(period - elapsed);
+        }
+#endif
+
+        // fixes are stamped with the time of their last edge
+        for(i = 0; i < NB_LASERS; i++){
+            if(triple_buffer_update(&lasers[i].fix)){
+                const laser_fix_t *fix = triple_buffer_read(&lasers[i].fix);
+                filter_update(lasers[i].robot, fix->time, fix);
+            }
+        }
+
+        now = os_timestamp_get();
+        for(i = 0; i < NB_ROBOTS; i++){
+            if(now - robots[i].filter.time >= period){
+                filter_update(&robots[i], now, NULL);
+            }
+        }
+    }
+}
+
+
+os_thread_t communication_thread;
+THREAD_STACK communication_stack[512];
+
+// records of the trace waiting for a full frame, only used by the
+// communication thread
+uint8_t trace_records[TELEMETRY_EDGE_TRACE_MAX_SIZE];
+size_t trace_length = 0;
+
+void trace_flush(void)
+{
+    uint8_t frame[TELEMETRY_FRAME_MAX_SIZE];
+    size_t length;
+
+    if(trace_length > 0){
+        length = telemetry_encode_edge_trace(trace_records, trace_length,
+                frame);
+        write(STDOUT_FILENO, frame, length);
+        trace_length = 0;
+    }
+}
+
+void trace_append(uint8_t laser, edge_trace_kind_t kind,
+        uint32_t arg0, uint32_t arg1)
+{
+    edge_trace_record_t record;
+
+    record.laser = laser;
+    record.kind = kind;
+    record.args[0] = arg0;
+    record.args[1] = arg1;
+
+    if(trace_length + edge_trace_record_size(kind)
+            > TELEMETRY_EDGE_TRACE_MAX_SIZE){
+        trace_flush();
+    }
+    trace_length += edge_trace_encode(&record, &trace_records[trace_length]);
+}
+
+// moves the edges traced by 'laser' to the trace records, with the os time
+// of the first one every TRACE_SYNC_PERIOD, see edge_trace.h
+void trace_laser(uint8_t laser, uint32_t *dropped, uint32_t *sync_time)
+{
+    timestamp_ring_t *trace = &lasers[laser].trace;
+    timestamp_event_t event;
+
+    if(timestamp_ring_dropped(trace) != *dropped){
+        trace_append(laser, EDGE_TRACE_DROPPED,
+                timestamp_ring_dropped(trace) - *dropped, 0);
+        *dropped = timestamp_ring_dropped(trace);
+    }
+
+    while(timestamp_ring_pop(trace, &event)){
+        uint32_t now = os_timestamp_get();
+
+        if(now - *sync_time >= TRACE_SYNC_PERIOD){
+            trace_append(laser, EDGE_TRACE_SYNC,
+                    lasers[laser].to_os_time(event.time), 0);
+            *sync_time = now;
+        }
+        trace_append(laser, (edge_trace_kind_t)event.beacon, event.time, 0);
+    }
+}
+
+// sends the telemetry frame of a robot every 1 / OUTPUT_FREQ, the robots
+// in turn, see telemetry.h
+//
+// while the trace is on it sends the traced edges instead, in frames as
+// full as possible, the link is too slow to carry both
+void communication_main(void *context)
+{
+    uint8_t frame[TELEMETRY_FRAME_MAX_SIZE];
+    telemetry_robot_state_t state;
+    uint32_t fix_time[NB_ROBOTS];
+    uint32_t tx_dropped = 0;
+    uint8_t tracing = 0;
+    uint32_t config_count = 0;
+    uint32_t trace_dropped[NB_LASERS];
+    uint32_t sync_time[NB_LASERS];
+    size_t length;
+    int robot = 0;
+    int i;
+
+    for(i = 0; i < NB_ROBOTS; i++){
+        fix_time[i] = 0;
+    }
+
+    while(42){
+        os_thread_sleep_least_us(1000000 / OUTPUT_FREQ);
+
+        if(trace_enable != tracing){
+            tracing = trace_enable;
+            for(i = 0; i < NB_LASERS; i++){
+                if(tracing){
+                    // the laser doesn't push to the ring before set_trace
+                    timestamp_ring_init(&lasers[i].trace);
+                    trace_dropped[i] = 0;
+                    sync_time[i] = os_timestamp_get() - TRACE_SYNC_PERIOD;
+                    beacon_angles_set_trace(lasers[i].angles,
+                            &lasers[i].trace);
+                } else{
+                    beacon_angles_set_trace(lasers[i].angles, NULL);
+                }
+            }
+            // the configuration opens the trace, the last records close it
+            config_count = trace_config_count - 1;
+            trace_flush();
+        }
+
+        if(tracing){
+            for(i = 0; i < NB_LASERS; i++){
+                if(config_count != trace_config_count){
+                    trace_append(i, EDGE_TRACE_CONFIG,
+                            lasers[i].timestamp_freq,
+                            beacon_angles_get_minimal_period(
+                                lasers[i].angles));
+                }
+            }
+            config_count = trace_config_count;
+            for(i = 0; i < NB_LASERS; i++){
+                trace_laser(i, &trace_dropped[i], &sync_time[i]);
+            }
+            continue;
+        }
+
+        // one robot per period, the link carries OUTPUT_FREQ frames per
+        // second whatever the number of robots. the kalman thread never
+        // waits on this lower priority thread
+        i = robot;
+        robot = (robot + 1) % NB_ROBOTS;
+
+        triple_buffer_update(&robots[i].estimate);
+        const robot_estimate_t *estimate =
+            triple_buffer_read(&robots[i].estimate);
+
+        state.robot = i;
+        state.flags = 0;
+        if(estimate->fix_time != fix_time[i]){
+            state.flags |= TELEMETRY_FLAG_FIX;
+            fix_time[i] = estimate->fix_time;
+        }
+        if(os_timestamp_get() - estimate->fix_time > OUTPUT_LOST_TIME){
+            state.flags |= TELEMETRY_FLAG_LOST;
+        }
+        if(pipeline_output_dropped() != tx_dropped){
+            state.flags |= TELEMETRY_FLAG_TX_DROPPED;
+            tx_dropped = pipeline_output_dropped();
+        }
+        state.time = estimate->time;
+#if BEACON_FIXED_POINT
+        state.x = Q8_24_TO_FLOAT(estimate->pos.x);
+        state.y = Q8_24_TO_FLOAT(estimate->pos.y);
+        state.var_x = Q8_24_TO_FLOAT(estimate->pos.var_x);
+        state.var_y = Q8_24_TO_FLOAT(estimate->pos.var_y);
+        state.cov_xy = Q8_24_TO_FLOAT(estimate->pos.cov_xy);
+#else
+        state.x = estimate->pos.x;
+        state.y = estimate->pos.y;
+        state.var_x = estimate->pos.var_x;
+        state.var_y = estimate->pos.var_y;
+        state.cov_xy = estimate->pos.cov_xy;
+#endif
+
+        length = telemetry_encode_robot_state(&state, frame);
+        write(STDOUT_FILENO, frame, length);
+    }
+
+}
+
+os_thread_t command_thread;
+THREAD_STACK command_stack[256];
+
+uint8_t command_apply(const command_t *command)
+{
+    uint8_t ok = 1;
+    int i;
+
+    switch(command->id){
+        case COMMAND_MEAS_COV:
+            // a covariance that isn't positive definite wrecks the filter
+            if(!(command->args[0] > 0.0f) || !(command->args[1] > 0.0f)
+                    || !(command->args[2] * command->args[2]
+                        < command->args[0] * command->args[1])){
+                return 0;
+            }
+#if MEAS_COV_FROM_GEOMETRY && !BEACON_FIXED_POINT && !KALMAN_USE_EKF
+            // every fix carries its own covariance, this sets the part the
+            // geometry doesn't cover
+            os_mutex_take(&meas_cov_min_mutex);
+            meas_cov_min.var_x = command->args[0];
+            meas_cov_min.var_y = command->args[1];
+            meas_cov_min.cov_xy = command->args[2];
+            os_mutex_release(&meas_cov_min_mutex);
+            return 1;
+#endif
+            for(i = 0; i < NB_ROBOTS; i++){
+#if BEACON_FIXED_POINT
+                ok &= kalman_q_update_measurement_covariance(
+                        &robots[i].filter.filter,
+                        Q8_24_FROM_FLOAT(command->args[0]),
+                        Q8_24_FROM_FLOAT(command->args[1]),
+                        Q8_24_FROM_FLOAT(command->args[2]));
+#elif KALMAN_USE_EKF
+                // the EKF measures time deltas, not positions
+                ok = 0;
+#else
+                ok &= kalman_update_measurement_covariance(
+                        &robots[i].filter.filter,
+                        command->args[0], command->args[1], command->args[2]);
+#endif
+            }
+            return ok;
+
+        case COMMAND_MAX_ACC:
+            for(i = 0; i < NB_ROBOTS; i++){
+#if BEACON_FIXED_POINT
+                ok = 0;
+#elif KALMAN_USE_EKF
+                ok &= ekf_set_max_acc(&robots[i].filter.filter,
+                        command->args[0]);
+#else
+                ok &= kalman_set_max_acc(&robots[i].filter.filter,
+                        command->args[0]);
+#endif
+            }
+            return ok;
+
+        case COMMAND_PROC_NOISE:
+            for(i = 0; i < NB_ROBOTS; i++){
+#if BEACON_FIXED_POINT || KALMAN_USE_EKF
+                ok = 0;
+#else
+                ok &= kalman_set_proc_noise_proportionality(
+                        &robots[i].filter.filter, command->args[0]);
+#endif
+            }
+            return ok;
+
+        case COMMAND_MIN_PERIOD:
+            if(command->args[0] != 1.0f && command->args[0] != 2.0f){
+                return 0;
+            }
+            if(command->args[1] < 0.0f || command->args[1] > 1000000.0f){
+                return 0;
+            }
+            i = (int)command->args[0] - 1;
+            // [us] to the unit of the edge timestamps
+            beacon_angles_set_minimal_period(lasers[i].angles,
+                    (uint32_t)((uint64_t)command->args[1]
+                        * lasers[i].timestamp_freq / 1000000));
+            // a running trace records the new period
+            trace_config_count++;
+            return 1;
+
+        case COMMAND_ODOMETRY:
+#if BEACON_FIXED_POINT || KALMAN_USE_EKF
+            return 0;
+#else
+            i = (int)command->args[0];
+            if(i < 0 || i >= NB_ROBOTS || command->args[0] != (float)i){
+                return 0;
+            }
+            // older odometry would be dropped by the kalman thread anyway
+            if(command->args[1] < 0.0f || command->args[1] > ODOMETRY_TIMEOUT){
+                return 0;
+            }
+            odometry_input_t *input =
+                triple_buffer_write_buffer(&robots[i].odometry);
+            input->valid = 1;
+            input->time = os_timestamp_get() - (uint32_t)command->args[1];
+            input->odometry.v_x = command->args[2];
+            input->odometry.v_y = command->args[3];
+            input->odometry.var = ODOMETRY_VAR;
+            triple_buffer_publish(&robots[i].odometry);
+            return 1;
+#endif
+
+        case COMMAND_TRACE:
+            if(command->args[0] != 0.0f && command->args[0] != 1.0f){
+                return 0;
+            }
+            trace_enable = (uint8_t)command->args[0];
+            return 1;
+    }
+
+    return 0;
+}
+
+// applies the commands received on stdin (see command.h), answers each
+// line with "ok" or "error" on stderr since stdout carries the telemetry
+void command_main(void *context)
+{
+    command_reader_t reader;
+    command_t command;
+    char buffer[16];
+    int length;
+    int i;
+
+    command_reader_init(&reader);
+
+    while(42){
+        length = read(STDIN_FILENO, buffer, sizeof(buffer));
+        // only the input of a host ends, the UART never does
+        if(length <= 0){
+            return;
+        }
+        for(i = 0; i < length; i++){
+            const char *line = command_reader_feed(&reader, buffer[i]);
+            if(line == NULL){
+                continue;
+            }
+            if(command_parse(line, &command) && command_apply(&command)){
+                write(STDERR_FILENO, "ok\n", 3);
+            } else{
+                write(STDERR_FILENO, "error\n", 6);
+            }
+        }
+    }
+}
+
+void pipeline_init(void)
+{
+    int i;
+
+    positioning_reference_triangle_from_points(&beacon_a, &beacon_b, &beacon_c, &table);
+#if BEACON_FIXED_POINT
+    beacon_a_q.x = Q8_24_FROM_FLOAT(beacon_a.x);
+    beacon_a_q.y = Q8_24_FROM_FLOAT(beacon_a.y);
+    beacon_b_q.x = Q8_24_FROM_FLOAT(beacon_b.x);
+    beacon_b_q.y = Q8_24_FROM_FLOAT(beacon_b.y);
+    beacon_c_q.x = Q8_24_FROM_FLOAT(beacon_c.x);
+    beacon_c_q.y = Q8_24_FROM_FLOAT(beacon_c.y);
+    positioning_q_reference_triangle_from_points(
+            &beacon_a_q, &beacon_b_q, &beacon_c_q, &table_q);
+#endif
+
+    for(i = 0; i < NB_ROBOTS; i++){
+        robots[i].fix_time = 0;
+        triple_buffer_init(&robots[i].estimate, robots[i].estimate_buffers,
+                sizeof(robot_estimate_t));
+        triple_buffer_init(&robots[i].odometry, robots[i].odometry_buffers,
+                sizeof(odometry_input_t));
+    }
+
+    lasers[0].robot = &robots[0];
+    lasers[1].robot = &robots[NB_ROBOTS - 1];
+
+    for(i = 0; i < NB_LASERS; i++){
+        triple_buffer_init(&lasers[i].fix, lasers[i].fix_buffers,
+                sizeof(laser_fix_t));
+    }
+    os_semaphore_init(&laser_fix_ready, 0);
+#if MEAS_COV_FROM_GEOMETRY
+    os_mutex_init(&meas_cov_min_mutex);
+#endif
+}
+
+void pipeline_start(void)
+{
+    os_thread_create(&laser_one_thread, laser_main, laser_one_stack,
+            sizeof(laser_one_stack), "L1", 0, &lasers[0]);
+    os_thread_create(&laser_two_thread, laser_main, laser_two_stack,
+            sizeof(laser_two_stack), "L2", 0, &lasers[1]);
+    os_thread_create(&kalman_thread, kalman_main, kalman_stack,
+            sizeof(kalman_stack), "Kalman", 0, NULL);
+    os_thread_create(&communication_thread, communication_main, communication_stack,
+            sizeof(communication_stack), "Communication", 2, NULL);
+    os_thread_create(&command_thread, command_main, command_stack,
+            sizeof(command_stack), "Command", 3, NULL);
+}
+
+#ifdef STM32F3
+// a negative array size if the static data of the pipeline outgrows its
+// share of the RAM, see PIPELINE_RAM_BUDGET
+typedef char pipeline_ram_budget_check[
+    sizeof(robots) + sizeof(lasers) + sizeof(laser_one_stack)
+        + sizeof(laser_two_stack) + sizeof(kalman_stack)
+        + sizeof(communication_stack) + sizeof(command_stack)
+        <= PIPELINE_RAM_BUDGET ? 1 : -1];
+#endif
@@ -0,0 +1,179 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+/*
+ * The beacon pipeline without the hardware around it: a thread per laser
+ * turns the edges of its beacons into fixes, the kalman thread fuses them,
+ * the communication thread sends the telemetry and the command thread
+ * applies the commands received. main.c runs it on the board with edges
+ * from the timer captures and interrupts, simulator/ runs it on a host
+ * with edges from a simulated laser.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <platform-abstraction/semaphore.h>
+
+#include "beacon_angles.h"
+#include "edge_capture.h"
+#include "positioning.h"
+#include "kalman.h"
+#include "kalman_history.h"
+#include "ekf.h"
+#include "positioning_q.h"
+#include "kalman_q.h"
+#include "triple_buffer.h"
+#include "command.h"
+#include "beacon_config.h"
+
+typedef struct {
+#if BEACON_FIXED_POINT
+    kalman_q_robot_handle_t filter;
+#elif KALMAN_USE_EKF
+    ekf_robot_handle_t filter;
+#else
+    kalman_robot_handle_t filter;
+    kalman_history_t history;
+#endif
+    // time [us] the filter state refers to
+    uint32_t time;
+} filter_handle_t;
+
+typedef struct {
+    // time [us] the estimate refers to
+    uint32_t time;
+    // time [us] of the last fix fused
+    uint32_t fix_time;
+#if BEACON_FIXED_POINT
+    robot_pos_q_t pos;
+#else
+    robot_pos_t pos;
+#endif
+} robot_estimate_t;
+
+typedef struct {
+    // zero until the first odom command
+    uint8_t valid;
+    // time [us] the velocity was measured at
+    uint32_t time;
+    robot_odometry_t odometry;
+} odometry_input_t;
+
+// a tracked robot, its filter is only touched by the kalman thread which
+// publishes every estimate through 'estimate'. the command thread passes
+// the odometry of the robot through 'odometry'
+typedef struct {
+    filter_handle_t filter;
+    uint32_t fix_time;
+    triple_buffer_t estimate;
+    robot_estimate_t estimate_buffers[3];
+    triple_buffer_t odometry;
+    odometry_input_t odometry_buffers[3];
+} robot_t;
+
+typedef struct {
+    // time [us] of the beacon A edge closing the rotation of the fix
+    uint32_t time;
+#if BEACON_FIXED_POINT
+    position_q_t pos_q;
+#elif KALMAN_USE_EKF
+    ekf_measurement_t meas;
+#else
+    position_t pos;
+    // with MEAS_COV_FROM_GEOMETRY
+    position_covariance_t cov;
+#endif
+} laser_fix_t;
+
+// one laser pipeline, from the edges of its beacons to a fix
+typedef struct {
+    beacon_angles_t *angles;
+    // laser one collects its edges from the DMA buffers, laser two gets
+    // them from its interrupt handlers (NULL)
+    edge_capture_t *capture;
+    // frequency [Hz] of the edge timestamps
+    uint32_t timestamp_freq;
+    // converts an edge timestamp of the recent past to os_timestamp_get time
+    uint32_t (*to_os_time)(uint32_t timestamp);
+    // robot the fixes of this laser update
+    robot_t *robot;
+
+    // the laser thread publishes every valid fix, the kalman thread fuses
+    // each of them once
+    triple_buffer_t fix;
+    laser_fix_t fix_buffers[3];
+
+    // edges recorded for the trace command, drained by the communication
+    // thread
+    timestamp_ring_t trace;
+} laser_t;
+
+#if LASER_FUSION_MODE == LASER_FUSION_SEPARATE
+#define NB_ROBOTS   (2)
+#else
+#define NB_ROBOTS   (1)
+#endif
+#define NB_LASERS   (2)
+
+// the filters are statically allocated so the thread stacks only hold call
+// frames. a robot takes 1.1 [KB] (its filter with KALMAN_HISTORY_SIZE
+// steps), the thread stacks 7 [KB]. the static data of the firmware is then
+// 11.6 [KB] with LASER_FUSION_JOINT and 12.7 [KB] with
+// LASER_FUSION_SEPARATE, 13.0 [KB] before the second laser, which leaves
+// the rest of the 16 [KB] of RAM to uC/OS and newlib. pipeline.c checks
+// its robots, lasers and stacks against PIPELINE_RAM_BUDGET
+#define PIPELINE_RAM_BUDGET (10 * 1024 + 512)   // [B]
+
+extern robot_t robots[NB_ROBOTS];
+extern laser_t lasers[NB_LASERS];
+
+// signaled with every fix of either laser
+extern semaphore_t laser_fix_ready;
+
+// initializes the robots and the publication of the fixes, assigns the
+// lasers to the robots. the target sets the angles, capture, timestamp_freq
+// and to_os_time of every laser before pipeline_start
+void pipeline_init(void);
+
+// creates the threads, call between os_init and os_run
+void pipeline_start(void);
+
+// the steps of the threads, simulator/replay.c calls them to replay a trace
+
+// computes the fix of the rotation in laser->angles into 'fix'
+//
+// return true if the fix is valid
+bool laser_fix(const laser_t *laser, laser_fix_t *fix);
+
+// initializes the filter of a robot at 'time' [us]
+void filter_init(filter_handle_t *handle, uint32_t time);
+
+// advances the filter of 'robot' to 'time' [us], fuses 'fix' unless it is
+// NULL and publishes the estimate
+void filter_update(robot_t *robot, uint32_t time, const laser_fix_t *fix);
+
+// applies 'command' to the filters of every robot, to the edge detection
+// of a laser, passes odometry to the kalman thread or starts the trace
+//
+// return 1 on success, 0 if the filter has no such setting or an argument
+// is out of range
+uint8_t command_apply(const command_t *command);
+
+// provided by the target
+
+// called by the laser threads for every valid fix
+void pipeline_fix_hook(void);
+
+// number of telemetry bytes the output dropped so far, see
+// TELEMETRY_FLAG_TX_DROPPED
+uint32_t pipeline_output_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
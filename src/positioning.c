@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "positioning.h"
+#include "float_math.h"
 
 // public function prototypes
 uint8_t positioning_from_angles(
@@ -17,6 +18,23 @@ uint8_t positioning_reference_triangle_from_points(
         const position_t * b,
         const position_t * c,
         reference_triangle_t * output);
+uint8_t positioning_from_angles_with_covariance(
+        float alpha,
+        float beta,
+        float gamma,
+        float var_bearing,
+        const reference_triangle_t * t,
+        position_t * output,
+        position_covariance_t * covariance);
+uint32_t positioning_from_angles_batch(
+        const float * alpha,
+        const float * beta,
+        const float * gamma,
+        uint32_t count,
+        const reference_triangle_t * t,
+        float * x,
+        float * y,
+        uint32_t * valid);
 // private function prototypes
 static uint8_t feq(float a, float b);
 static float orientation(
@@ -30,6 +48,16 @@ static float cotangent_from_points(
 static float dot_product(const position_t * a, const position_t * b);
 static float cross_product(const position_t * a, const position_t * b);
 static float cot(float alpha);
+static float cot_poly(float alpha);
+static void batch_kernel(
+        const float * restrict alpha,
+        const float * restrict beta,
+        const float * restrict gamma,
+        uint32_t count,
+        const float * restrict triangle,
+        float * restrict x,
+        float * restrict y,
+        int32_t * restrict valid);
 
 
 /*
@@ -75,7 +103,7 @@ uint8_t positioning_from_angles(
         position_t * output)
 {
     // output is not valid if input is not valid
-    if (output == NULL || t == NULL || !feq(alpha + beta + gamma, 2 * M_PI)) {
+    if (output == NULL || t == NULL || !feq(alpha + beta + gamma, FLOAT_2_PI)) {
         return 0;
     }
 
@@ -122,21 +150,211 @@ uint8_t positioning_from_angles(
     return is_valid;
 }
 
+uint8_t positioning_from_angles_with_covariance(
+        float alpha,
+        float beta,
+        float gamma,
+        float var_bearing,
+        const reference_triangle_t * t,
+        position_t * output,
+        position_covariance_t * covariance)
+{
+    // output is not valid if input is not valid
+    if (output == NULL || covariance == NULL || t == NULL ||
+        var_bearing < 0.0f || !feq(alpha + beta + gamma, FLOAT_2_PI))
+    {
+        return 0;
+    }
+
+    float cot_alpha = cot(alpha);
+    float cot_beta = cot(beta);
+    float cot_gamma = cot(gamma);
+
+    // barycentric coordinates, not normalized
+    float k_a = 1.0f / (t->cotangent_at_a - cot_alpha);
+    float k_b = 1.0f / (t->cotangent_at_b - cot_beta);
+    float k_c = 1.0f / (t->cotangent_at_c - cot_gamma);
+    float magnitude = k_a + k_b + k_c;
+
+    float x = (k_a * t->point_a->x + k_b * t->point_b->x +
+        k_c * t->point_c->x) / magnitude;
+    float y = (k_a * t->point_a->y + k_b * t->point_b->y +
+        k_c * t->point_c->y) / magnitude;
+
+    // the position moves by dk_i * (P_i - P) / magnitude when k_i changes,
+    // and dk_a / dalpha = -k_a^2 * (1 + cot(alpha)^2)
+    float g_a = -k_a * k_a * (1.0f + cot_alpha * cot_alpha) / magnitude;
+    float g_b = -k_b * k_b * (1.0f + cot_beta * cot_beta) / magnitude;
+    float g_c = -k_c * k_c * (1.0f + cot_gamma * cot_gamma) / magnitude;
+    float u_a_x = g_a * (t->point_a->x - x);
+    float u_a_y = g_a * (t->point_a->y - y);
+    float u_b_x = g_b * (t->point_b->x - x);
+    float u_b_y = g_b * (t->point_b->y - y);
+    float u_c_x = g_c * (t->point_c->x - x);
+    float u_c_y = g_c * (t->point_c->y - y);
+
+    // alpha = bearing C - bearing B, beta = A - C, gamma = B - A: the
+    // position moves by u_b - u_c with the bearing of A, u_c - u_a with
+    // the one of B and u_a - u_b with the one of C
+    float j_a_x = u_b_x - u_c_x;
+    float j_a_y = u_b_y - u_c_y;
+    float j_b_x = u_c_x - u_a_x;
+    float j_b_y = u_c_y - u_a_y;
+    float j_c_x = u_a_x - u_b_x;
+    float j_c_y = u_a_y - u_b_y;
+
+    position_covariance_t cov = {
+        var_bearing * (j_a_x * j_a_x + j_b_x * j_b_x + j_c_x * j_c_x),
+        var_bearing * (j_a_y * j_a_y + j_b_y * j_b_y + j_c_y * j_c_y),
+        var_bearing * (j_a_x * j_a_y + j_b_x * j_b_y + j_c_x * j_c_y)};
+
+    // on the circumcircle the magnitude is 0
+    if (!isfinite(x) || !isfinite(y) || !isfinite(cov.var_x) ||
+        !isfinite(cov.var_y) || !isfinite(cov.cov_xy))
+    {
+        return 0;
+    }
+
+    position_t pos = {x, y};
+
+    // copy result to output
+    memcpy(output, &pos, sizeof(position_t));
+    memcpy(covariance, &cov, sizeof(position_covariance_t));
+
+    return 1;
+}
+
+uint32_t positioning_from_angles_batch(
+        const float * alpha,
+        const float * beta,
+        const float * gamma,
+        uint32_t count,
+        const reference_triangle_t * t,
+        float * x,
+        float * y,
+        uint32_t * valid)
+{
+    // results of a block, one word of 'valid'
+    int32_t block_valid[32];
+    uint32_t nb_valid = 0;
+    uint32_t start, i;
+
+    if (alpha == NULL || beta == NULL || gamma == NULL || t == NULL ||
+        x == NULL || y == NULL || valid == NULL)
+    {
+        return 0;
+    }
+
+    // copied so the kernel knows they don't alias its outputs
+    const float triangle[9] = {
+        t->cotangent_at_a, t->cotangent_at_b, t->cotangent_at_c,
+        t->point_a->x, t->point_b->x, t->point_c->x,
+        t->point_a->y, t->point_b->y, t->point_c->y};
+
+    for (start = 0; start < count; start += 32) {
+        uint32_t n = count - start < 32 ? count - start : 32;
+        uint32_t word = 0;
+
+        batch_kernel(&alpha[start], &beta[start], &gamma[start], n, triangle,
+                &x[start], &y[start], block_valid);
+
+        for (i = 0; i < n; i++) {
+            word |= (uint32_t)block_valid[i] << i;
+            nb_valid += block_valid[i];
+        }
+        valid[start / 32] = word;
+    }
+
+    return nb_valid;
+}
+
 /*
  * implementation of private functions
  */
 
+// positioning_from_angles without its pointer checks, 'triangle' holds the
+// cotangents at a, b, c then the x and the y of a, b, c
+static void batch_kernel(
+        const float * restrict alpha,
+        const float * restrict beta,
+        const float * restrict gamma,
+        uint32_t count,
+        const float * restrict triangle,
+        float * restrict x,
+        float * restrict y,
+        int32_t * restrict valid)
+{
+    static const float EPSILON = 0.1f;
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        float cot_alpha = cot_poly(alpha[i]);
+        float cot_beta = cot_poly(beta[i]);
+        float cot_gamma = cot_poly(gamma[i]);
+
+        float barycentric_a = 1.0f / (triangle[0] - cot_alpha);
+        float barycentric_b = 1.0f / (triangle[1] - cot_beta);
+        float barycentric_c = 1.0f / (triangle[2] - cot_gamma);
+        float magnitude = barycentric_a + barycentric_b + barycentric_c;
+        barycentric_a /= magnitude;
+        barycentric_b /= magnitude;
+        barycentric_c /= magnitude;
+
+        x[i] = barycentric_a * triangle[3] + barycentric_b * triangle[4] +
+            barycentric_c * triangle[5];
+        y[i] = barycentric_a * triangle[6] + barycentric_b * triangle[7] +
+            barycentric_c * triangle[8];
+
+        // the tests of feq, as masks
+        valid[i] =
+            (fabsf(alpha[i] + beta[i] + gamma[i] - FLOAT_2_PI) < EPSILON) &
+            (fabsf(cot_alpha - triangle[0]) >= EPSILON) &
+            (fabsf(cot_beta - triangle[1]) >= EPSILON) &
+            (fabsf(cot_gamma - triangle[2]) >= EPSILON);
+    }
+}
+
+// cotangent of 'alpha' in [0, 2 Pi] without a call or a branch: reduced to
+// r in [-Pi/4, Pi/4] from the closest multiple q of Pi/2, the sine and the
+// cosine of r are polynomials (cephes sinf/cosf). cot = cos(r) / sin(r) for
+// an even q, -sin(r) / cos(r) for an odd one
+static inline float cot_poly(float alpha)
+{
+    // Pi/2 in three parts, q * PIO2_1 is exact
+    static const float PIO2_1 = 1.5703125f;
+    static const float PIO2_2 = 4.837512969970703125e-4f;
+    static const float PIO2_3 = 7.54978995489188216e-8f;
+    static const float TWO_OVER_PI = 0.636619772f;
+
+    int32_t q = (int32_t)(alpha * TWO_OVER_PI + 0.5f);
+    float fq = (float)q;
+    float r = ((alpha - fq * PIO2_1) - fq * PIO2_2) - fq * PIO2_3;
+    float r2 = r * r;
+
+    float sine = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f +
+            r2 * -1.9515295891e-4f));
+    float cosine = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f +
+            r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+    // select before dividing, a division in each branch keeps the loop from
+    // being vectorized
+    float num = (q & 1) ? -sine : cosine;
+    float den = (q & 1) ? cosine : sine;
+
+    return num / den;
+}
+
 //see: http://stackoverflow.com/questions/3738384/stable-cotangent
 static inline float cot(float alpha)
 {
-    return tan(M_PI_2 - alpha);
+    return tanf(FLOAT_PI_2 - alpha);
 }
 
 // helper function to compare floats for approximate equality
 static uint8_t feq(float a, float b)
 {
     static const float EPSILON = 0.1f;
-    return fabs(a - b) < EPSILON;
+    return fabsf(a - b) < EPSILON;
 }
 
 // standard dot product function
@@ -178,14 +396,14 @@ static float cotangent_from_points(
     // dot product of BA and BC
     float dot_ba_bc = dot_product(&ba, &bc);
     // length of BA
-    float len_ba = sqrt(dot_product(&ba, &ba));
+    float len_ba = sqrtf(dot_product(&ba, &ba));
     // length of BC
-    float len_bc = sqrt(dot_product(&bc, &bc));
+    float len_bc = sqrtf(dot_product(&bc, &bc));
 
     // cosine between BA and BC
     float cosine = dot_ba_bc / (len_ba * len_bc);
     // sine between BA and BC
-    float sine = sqrt(1 - (cosine * cosine));
+    float sine = sqrtf(1.0f - (cosine * cosine));
 
     // cot = cos/sin
     return cosine / sine;
@@ -45,5 +45,63 @@ uint8_t positioning_from_angles(
         const reference_triangle_t * t,
         position_t * output);
 
+// covariance of a position [m^2]
+typedef struct {
+    float var_x;
+    float var_y;
+    float cov_xy;
+} position_covariance_t;
+
+// positioning_from_angles which also tells how far the position can be
+// trusted instead of rejecting it near the circumcircle
+//
+// the bearing of every beacon is taken as independently noisy with
+// variance 'var_bearing' [rad^2], e.g. (2 Pi / period)^2 times the variance
+// of an edge time. the noise goes through the barycentric formula to the
+// position (first order), its covariance is copied to 'covariance'. it
+// grows without bound as the position nears the circumcircle (geometric
+// dilution of precision), the caller decides which fixes are too poor.
+//
+// returns 1 if the position and its covariance could be computed
+// returns 0 if either input params are invalid (angles don't sum to 2 Pi,
+// pointers are NULL, 'var_bearing' < 0) or the position lies exactly on the
+// circumcircle, 'output' and 'covariance' are then left untouched
+uint8_t positioning_from_angles_with_covariance(
+        float alpha,
+        float beta,
+        float gamma,
+        float var_bearing,
+        const reference_triangle_t * t,
+        position_t * output,
+        position_covariance_t * covariance);
+
+// greatest difference of the positions computed by
+// positioning_from_angles_batch and positioning_from_angles for results to
+// be trusted, on the 3 x 2 [m] table [m]
+#define POSITIONING_BATCH_TOLERANCE (1e-4f)
+
+// positioning_from_angles on 'count' triples of angles at once, for offline
+// work on many fixes (replays, error maps), the angles are in [0, 2 Pi]
+//
+// structure of arrays: the i-th result comes from alpha[i], beta[i] and
+// gamma[i], its position goes to x[i] and y[i] and bit (i % 32) of
+// valid[i / 32] tells if it is to be trusted, the unused bits of the last
+// word are cleared. the loop has no branch and no call so the compiler can
+// vectorize it (SSE/AVX on a host), the cotangents come from a polynomial
+// instead of tanf. the positions differ from positioning_from_angles by
+// less than POSITIONING_BATCH_TOLERANCE and the validity only differs for
+// results at the edge of the circumcircle band
+//
+// return the number of results to be trusted, 0 if a pointer is NULL
+uint32_t positioning_from_angles_batch(
+        const float * alpha,
+        const float * beta,
+        const float * gamma,
+        uint32_t count,
+        const reference_triangle_t * t,
+        float * x,
+        float * y,
+        uint32_t * valid);
+
 #endif
 
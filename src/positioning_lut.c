@@ -0,0 +1,395 @@
+
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "positioning_lut.h"
+#include "float_math.h"
+
+// public function prototypes
+uint8_t positioning_lut_init(
+        positioning_lut_t * lut,
+        const reference_triangle_t * t,
+        const position_t * area_min,
+        const position_t * area_max,
+        positioning_lut_entry_t * entries,
+        positioning_lut_trig_t * trig,
+        uint16_t resolution);
+uint8_t positioning_lut_attach(
+        positioning_lut_t * lut,
+        const reference_triangle_t * t,
+        const positioning_lut_range_t * range,
+        const positioning_lut_entry_t * entries,
+        positioning_lut_trig_t * trig,
+        uint16_t resolution);
+const positioning_lut_range_t * positioning_lut_get_range(
+        const positioning_lut_t * lut);
+uint8_t positioning_lut_from_angles(
+        const positioning_lut_t * lut,
+        float alpha,
+        float beta,
+        float gamma,
+        position_t * output);
+// private function prototypes
+static uint8_t feq(float a, float b);
+static int16_t to_mm(float meters);
+static float directed_angle(const position_t * from, const position_t * to);
+static float angle_residual(
+        const position_t * from,
+        const position_t * to,
+        float sin_angle,
+        float cos_angle);
+static void sin_cos_add(
+        float sin_angle,
+        float cos_angle,
+        float delta,
+        float * sin_sum,
+        float * cos_sum);
+static uint8_t refine(
+        const positioning_lut_t * lut,
+        float u,
+        float v,
+        position_t * output);
+static void range_add(
+        const reference_triangle_t * t,
+        float x,
+        float y,
+        positioning_lut_range_t * range);
+
+
+/*
+ * implementation of public functions
+ */
+
+uint8_t positioning_lut_init(
+        positioning_lut_t * lut,
+        const reference_triangle_t * t,
+        const position_t * area_min,
+        const position_t * area_max,
+        positioning_lut_entry_t * entries,
+        positioning_lut_trig_t * trig,
+        uint16_t resolution)
+{
+    // points per side of the area the range is taken from
+    static const uint16_t NB_BOUNDARY_POINTS = 256;
+    positioning_lut_range_t range = {FLOAT_2_PI, 0.0f, FLOAT_2_PI, 0.0f};
+    uint16_t i, j;
+
+    // verify input
+    if (t == NULL || area_min == NULL || area_max == NULL ||
+        area_min->x >= area_max->x || area_min->y >= area_max->y)
+    {
+        return 0;
+    }
+
+    // the angles are harmonic functions of the position, their extremes
+    // over the area are on its boundary. the points are taken between the
+    // corners in case a beacon is on one
+    for (i = 0; i < NB_BOUNDARY_POINTS; i++) {
+        float f = (i + 0.5f) / NB_BOUNDARY_POINTS;
+        float x = area_min->x + f * (area_max->x - area_min->x);
+        float y = area_min->y + f * (area_max->y - area_min->y);
+
+        range_add(t, x, area_min->y, &range);
+        range_add(t, x, area_max->y, &range);
+        range_add(t, area_min->x, y, &range);
+        range_add(t, area_max->x, y, &range);
+    }
+
+    if (entries == NULL ||
+        !positioning_lut_attach(lut, t, &range, entries, trig, resolution))
+    {
+        return 0;
+    }
+
+    for (i = 0; i <= resolution; i++) {
+        for (j = 0; j <= resolution; j++) {
+            positioning_lut_entry_t * entry = &entries[i * (resolution + 1) + j];
+            float alpha = range.alpha_min + i / lut->_scale_alpha;
+            float beta = range.beta_min + j / lut->_scale_beta;
+            float gamma = FLOAT_2_PI - alpha - beta;
+            position_t pos = {0.0f, 0.0f};
+
+            entry->x = POSITIONING_LUT_INVALID;
+            entry->y = POSITIONING_LUT_INVALID;
+
+            // no point sees a negative angle. the trust of the node doesn't
+            // matter, the guesses newton can't refine fall back to the
+            // closed form
+            if (gamma < 0.0f) {
+                continue;
+            }
+            positioning_from_angles(alpha, beta, gamma, t, &pos);
+
+            int16_t x = to_mm(pos.x);
+            int16_t y = to_mm(pos.y);
+            if (x != POSITIONING_LUT_INVALID && y != POSITIONING_LUT_INVALID) {
+                entry->x = x;
+                entry->y = y;
+            }
+        }
+    }
+
+    return 1;
+}
+
+uint8_t positioning_lut_attach(
+        positioning_lut_t * lut,
+        const reference_triangle_t * t,
+        const positioning_lut_range_t * range,
+        const positioning_lut_entry_t * entries,
+        positioning_lut_trig_t * trig,
+        uint16_t resolution)
+{
+    uint16_t i;
+
+    // verify input
+    if (lut == NULL || t == NULL || range == NULL || entries == NULL ||
+        trig == NULL || resolution == 0 ||
+        !(range->alpha_min < range->alpha_max) ||
+        !(range->beta_min < range->beta_max))
+    {
+        return 0;
+    }
+
+    lut->_t = t;
+    lut->_entries = entries;
+    lut->_trig = trig;
+    lut->_resolution = resolution;
+    memcpy(&lut->_range, range, sizeof(positioning_lut_range_t));
+    lut->_scale_alpha = resolution / (range->alpha_max - range->alpha_min);
+    lut->_scale_beta = resolution / (range->beta_max - range->beta_min);
+
+    for (i = 0; i <= resolution; i++) {
+        float alpha = range->alpha_min + i / lut->_scale_alpha;
+        float beta = range->beta_min + i / lut->_scale_beta;
+
+        trig[i].sin_alpha = sinf(alpha);
+        trig[i].cos_alpha = cosf(alpha);
+        trig[i].sin_beta = sinf(beta);
+        trig[i].cos_beta = cosf(beta);
+    }
+
+    return 1;
+}
+
+const positioning_lut_range_t * positioning_lut_get_range(
+        const positioning_lut_t * lut)
+{
+    return &lut->_range;
+}
+
+uint8_t positioning_lut_from_angles(
+        const positioning_lut_t * lut,
+        float alpha,
+        float beta,
+        float gamma,
+        position_t * output)
+{
+    // output is not valid if input is not valid
+    if (lut == NULL || output == NULL ||
+        !feq(alpha + beta + gamma, FLOAT_2_PI))
+    {
+        return 0;
+    }
+
+    // cell of the angles
+    float u = (alpha - lut->_range.alpha_min) * lut->_scale_alpha;
+    float v = (beta - lut->_range.beta_min) * lut->_scale_beta;
+    uint8_t in_range = u >= 0.0f && v >= 0.0f &&
+        u <= lut->_resolution && v <= lut->_resolution;
+    position_t pos = {0.0f, 0.0f};
+
+    // the closed form outside the table and for the cells newton can't
+    // handle
+    if (!(in_range && refine(lut, u, v, &pos)) &&
+        !positioning_from_angles(alpha, beta, gamma, lut->_t, &pos))
+    {
+        return 0;
+    }
+
+    // copy result to output
+    memcpy(output, &pos, sizeof(position_t));
+
+    return 1;
+}
+
+/*
+ * implementation of private functions
+ */
+
+// helper function to compare floats for approximate equality, the same as
+// positioning.c
+static uint8_t feq(float a, float b)
+{
+    static const float EPSILON = 0.1f;
+    return fabsf(a - b) < EPSILON;
+}
+
+// [m] to [mm], POSITIONING_LUT_INVALID if it doesn't fit
+static int16_t to_mm(float meters)
+{
+    float mm = meters * 1000.0f;
+
+    if (!(mm > INT16_MIN + 1.0f && mm < INT16_MAX)) {
+        return POSITIONING_LUT_INVALID;
+    }
+
+    return (int16_t)lrintf(mm);
+}
+
+// directed angle from vector 'from' to vector 'to', in [0, 2 Pi)
+static float directed_angle(const position_t * from, const position_t * to)
+{
+    float angle = atan2f(
+            from->x * to->y - from->y * to->x,
+            from->x * to->x + from->y * to->y);
+
+    return angle < 0.0f ? angle + FLOAT_2_PI : angle;
+}
+
+// widens 'range' to the angles seen from (x, y)
+static void range_add(
+        const reference_triangle_t * t,
+        float x,
+        float y,
+        positioning_lut_range_t * range)
+{
+    position_t a = {t->point_a->x - x, t->point_a->y - y};
+    position_t b = {t->point_b->x - x, t->point_b->y - y};
+    position_t c = {t->point_c->x - x, t->point_c->y - y};
+    float alpha = directed_angle(&b, &c);
+    float beta = directed_angle(&c, &a);
+
+    range->alpha_min = alpha < range->alpha_min ? alpha : range->alpha_min;
+    range->alpha_max = alpha > range->alpha_max ? alpha : range->alpha_max;
+    range->beta_min = beta < range->beta_min ? beta : range->beta_min;
+    range->beta_max = beta > range->beta_max ? beta : range->beta_max;
+}
+
+// tangent of 'angle' minus the directed angle from vector 'from' to vector
+// 'to', given the sine and cosine of 'angle'
+static float angle_residual(
+        const position_t * from,
+        const position_t * to,
+        float sin_angle,
+        float cos_angle)
+{
+    float cross = from->x * to->y - from->y * to->x;
+    float dot = from->x * to->x + from->y * to->y;
+
+    return (sin_angle * dot - cos_angle * cross) /
+        (cos_angle * dot + sin_angle * cross);
+}
+
+// sine and cosine of 'angle' + 'delta' from those of 'angle', 'delta' is
+// at most a cell wide [rad]
+static void sin_cos_add(
+        float sin_angle,
+        float cos_angle,
+        float delta,
+        float * sin_sum,
+        float * cos_sum)
+{
+    float delta2 = delta * delta;
+    float sin_delta = delta * (1.0f - delta2 * (1.0f / 6.0f));
+    float cos_delta = 1.0f - 0.5f * delta2 * (1.0f - delta2 * (1.0f / 12.0f));
+
+    *sin_sum = sin_angle * cos_delta + cos_angle * sin_delta;
+    *cos_sum = cos_angle * cos_delta - sin_angle * sin_delta;
+}
+
+// position of the angles at (u, v) in the grid of 'lut',
+// from the bilinear guess of the nodes around them refined by newton
+//
+// return 1 on success
+// return 0 if a node isn't trusted or newton hasn't converged
+static uint8_t refine(
+        const positioning_lut_t * lut,
+        float u,
+        float v,
+        position_t * output)
+{
+    const reference_triangle_t * t = lut->_t;
+    uint16_t stride = lut->_resolution + 1;
+
+    // the last cell takes the upper bound of the range
+    uint16_t i = (uint16_t)u < lut->_resolution ? (uint16_t)u : lut->_resolution - 1;
+    uint16_t j = (uint16_t)v < lut->_resolution ? (uint16_t)v : lut->_resolution - 1;
+    float fu = u - i;
+    float fv = v - j;
+
+    const positioning_lut_entry_t * e00 = &lut->_entries[i * stride + j];
+    const positioning_lut_entry_t * e01 = e00 + 1;
+    const positioning_lut_entry_t * e10 = e00 + stride;
+    const positioning_lut_entry_t * e11 = e10 + 1;
+
+    if (e00->x == POSITIONING_LUT_INVALID || e01->x == POSITIONING_LUT_INVALID ||
+        e10->x == POSITIONING_LUT_INVALID || e11->x == POSITIONING_LUT_INVALID)
+    {
+        return 0;
+    }
+
+    // bilinear guess [m]
+    float x = 0.001f * ((1.0f - fu) * ((1.0f - fv) * e00->x + fv * e01->x) +
+        fu * ((1.0f - fv) * e10->x + fv * e11->x));
+    float y = 0.001f * ((1.0f - fu) * ((1.0f - fv) * e00->y + fv * e01->y) +
+        fu * ((1.0f - fv) * e10->y + fv * e11->y));
+    float step = 0.0f;
+    uint8_t k;
+
+    // the angles seen from the guess are compared to the measured ones
+    // through sines and cosines, those of the grid lines of the cell turned
+    // by the offset of the angles in it
+    float sin_alpha, cos_alpha, sin_beta, cos_beta;
+    sin_cos_add(lut->_trig[i].sin_alpha, lut->_trig[i].cos_alpha,
+            fu / lut->_scale_alpha, &sin_alpha, &cos_alpha);
+    sin_cos_add(lut->_trig[j].sin_beta, lut->_trig[j].cos_beta,
+            fv / lut->_scale_beta, &sin_beta, &cos_beta);
+
+    for (k = 0; k < POSITIONING_LUT_NEWTON_STEPS; k++) {
+        // vectors from the guess to the beacons
+        position_t a = {t->point_a->x - x, t->point_a->y - y};
+        position_t b = {t->point_b->x - x, t->point_b->y - y};
+        position_t c = {t->point_c->x - x, t->point_c->y - y};
+        float inv_a = 1.0f / (a.x * a.x + a.y * a.y);
+        float inv_b = 1.0f / (b.x * b.x + b.y * b.y);
+        float inv_c = 1.0f / (c.x * c.x + c.y * c.y);
+
+        // measured angles minus the ones seen from the guess, tan(r) from
+        // the cross and dot products is r itself this close
+        float r_alpha = angle_residual(&b, &c, sin_alpha, cos_alpha);
+        float r_beta = angle_residual(&c, &a, sin_beta, cos_beta);
+
+        // jacobian of (alpha, beta) at the guess, the bearing of a beacon k
+        // changes by (y_k, -x_k) / |k|^2 when the guess moves
+        float j00 = c.y * inv_c - b.y * inv_b;
+        float j01 = -c.x * inv_c + b.x * inv_b;
+        float j10 = a.y * inv_a - c.y * inv_c;
+        float j11 = -a.x * inv_a + c.x * inv_c;
+        float det = j00 * j11 - j01 * j10;
+
+        float dx = (r_alpha * j11 - r_beta * j01) / det;
+        float dy = (j00 * r_beta - j10 * r_alpha) / det;
+        x += dx;
+        y += dy;
+        step = fabsf(dx) + fabsf(dy);
+        if (step < POSITIONING_LUT_MAX_STEP) {
+            break;
+        }
+    }
+
+    // far from the solution, or on the circle where the jacobian vanishes,
+    // newton hasn't converged (or gives NaN)
+    if (!(step < POSITIONING_LUT_MAX_STEP)) {
+        return 0;
+    }
+
+    position_t pos = {x, y};
+
+    // copy result to output
+    memcpy(output, &pos, sizeof(position_t));
+
+    return 1;
+}
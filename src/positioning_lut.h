@@ -0,0 +1,131 @@
+
+#ifndef POSITIONING_LUT_H
+#define POSITIONING_LUT_H
+
+#include <stdint.h>
+
+#include "positioning.h"
+
+// positioning from angles through a lookup table, for a reference triangle
+// which doesn't change for a whole match
+//
+// the table holds the position of every node of a regular grid over
+// (alpha, beta), on the range of angles seen from a rectangular area (the
+// playing field). a fix interpolates the four nodes around its angles
+// (bilinear) and refines the guess with a Newton step on the angles seen
+// from the guess. the sines and cosines of the measured angles come from
+// those of the grid lines below them, corrected by the offset in the cell,
+// so a fix has no trigonometric call, only a 2x2 solve per step. the few
+// fixes newton doesn't refine (cells across the circle of the reference
+// triangle) and those outside the range fall back to
+// positioning_from_angles
+//
+// the table is filled at boot (positioning_lut_init) or generated on a
+// host into a const array which stays in flash (positioning_lut_attach),
+// benchmark/lut_benchmark prints one and reports the size, accuracy and
+// time of every resolution
+
+// a node of the table, [mm], POSITIONING_LUT_INVALID if no point sees its
+// angles or it is more than 32 [m] away
+typedef struct {
+    int16_t x;
+    int16_t y;
+} positioning_lut_entry_t;
+
+#define POSITIONING_LUT_INVALID (INT16_MIN)
+
+// number of entries of a table of 'resolution' cells per angle
+#define POSITIONING_LUT_SIZE(resolution) \
+    (((resolution) + 1) * ((resolution) + 1))
+
+// sines and cosines of the angles of the grid lines, number of them for
+// 'resolution' cells per angle
+typedef struct {
+    float sin_alpha;
+    float cos_alpha;
+    float sin_beta;
+    float cos_beta;
+} positioning_lut_trig_t;
+
+#define POSITIONING_LUT_TRIG_SIZE(resolution) ((resolution) + 1)
+
+// maximal number of newton steps from the bilinear guess
+#define POSITIONING_LUT_NEWTON_STEPS (2)
+
+// newton stops once a step moves the fix less than this (|dx| + |dy|) [m],
+// if none does the guess was too far (near the circle of the reference
+// triangle) and the fix falls back to positioning_from_angles
+#define POSITIONING_LUT_MAX_STEP (0.01f)
+
+// range of the angles covered by the grid [rad]
+typedef struct {
+    float alpha_min;
+    float alpha_max;
+    float beta_min;
+    float beta_max;
+} positioning_lut_range_t;
+
+// WARNING : this type should be opaque, its only here to
+// allow static allocation by user
+typedef struct {
+    const reference_triangle_t * _t;
+    const positioning_lut_entry_t * _entries;
+    const positioning_lut_trig_t * _trig;
+    uint16_t _resolution;
+    positioning_lut_range_t _range;
+    // cells per radian
+    float _scale_alpha;
+    float _scale_beta;
+} positioning_lut_t;
+
+// fills 'entries', POSITIONING_LUT_SIZE(resolution) of them, with the
+// positions of the grid of reference triangle 't' over the angles seen
+// from the rectangle from 'area_min' to 'area_max' and attaches them to
+// 'lut' with 'trig' (see positioning_lut_attach). 't' must stay valid as
+// long as 'lut' is used
+//
+// return 1 on success
+// return 0 if a pointer is NULL, 'resolution' is 0 or the area is empty
+uint8_t positioning_lut_init(
+        positioning_lut_t * lut,
+        const reference_triangle_t * t,
+        const position_t * area_min,
+        const position_t * area_max,
+        positioning_lut_entry_t * entries,
+        positioning_lut_trig_t * trig,
+        uint16_t resolution);
+
+// attaches 'entries' filled beforehand for 't' over 'range' to 'lut' and
+// fills 'trig', POSITIONING_LUT_TRIG_SIZE(resolution) of them, which
+// must stay valid as long as 'lut' is used
+//
+// return 1 on success
+// return 0 if a pointer is NULL, 'resolution' is 0 or 'range' is empty
+uint8_t positioning_lut_attach(
+        positioning_lut_t * lut,
+        const reference_triangle_t * t,
+        const positioning_lut_range_t * range,
+        const positioning_lut_entry_t * entries,
+        positioning_lut_trig_t * trig,
+        uint16_t resolution);
+
+// return the range of the angles of 'lut'
+const positioning_lut_range_t * positioning_lut_get_range(
+        const positioning_lut_t * lut);
+
+// computes cartesian coordinates from angles like positioning_from_angles
+// copies result to the memory location specified by 'output'
+//
+// returns 1 if the result is to be trusted and can safely be used
+// returns 0 if either input params are invalid (angles don't sum to 2 Pi,
+// pointers are NULL) or positioning_from_angles doesn't trust the fix it
+// falls back to (angles outside the range of the table, newton not
+// converging), 'output' is then left untouched
+uint8_t positioning_lut_from_angles(
+        const positioning_lut_t * lut,
+        float alpha,
+        float beta,
+        float gamma,
+        position_t * output);
+
+#endif
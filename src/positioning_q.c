@@ -0,0 +1,228 @@
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "positioning_q.h"
+
+// 0.1 [rad], the tolerance of positioning_from_angles on the angle sum
+#define ANGLE_SUM_TOLERANCE     (68356528)
+
+// 0.1 [m^2] in 48 fractional bits, minimal orientation of the triangle
+#define MIN_ORIENTATION         ((int64_t)28147497671066)
+
+// public function prototypes
+uint8_t positioning_q_reference_triangle_from_points(
+        const position_q_t * a,
+        const position_q_t * b,
+        const position_q_t * c,
+        reference_triangle_q_t * output);
+uint8_t positioning_q_from_angles(
+        angle_q_t alpha,
+        angle_q_t beta,
+        angle_q_t gamma,
+        const reference_triangle_q_t * t,
+        position_q_t * output);
+angle_q_t positioning_q_angle_from_ticks(uint32_t delta, uint32_t period);
+
+// private function prototypes
+static int64_t orientation(
+        const position_q_t * a,
+        const position_q_t * b,
+        const position_q_t * c);
+static void sine_cosine_from_points(
+        const position_q_t * a,
+        const position_q_t * b,
+        const position_q_t * c,
+        q31_t * sine,
+        q31_t * cosine);
+static void normalize(int64_t * v0, int64_t * v1, int64_t * v2);
+static q31_t saturate(int64_t value);
+
+
+/*
+ * implementation of public functions
+ */
+
+uint8_t positioning_q_reference_triangle_from_points(
+        const position_q_t * a,
+        const position_q_t * b,
+        const position_q_t * c,
+        reference_triangle_q_t * output)
+{
+    // verify input
+    if (output == NULL || a == NULL || b == NULL || c == NULL) {
+        return 0;
+    }
+
+    // test if a,b,c are not positively oriented or colinear
+    if (orientation(a, b, c) < MIN_ORIENTATION) {
+        return 0;
+    }
+
+    output->point_a = a;
+    output->point_b = b;
+    output->point_c = c;
+
+    // compute sine and cosine of angle inside triangle at every point
+    sine_cosine_from_points(b, a, c, &output->sin_at_a, &output->cos_at_a);
+    sine_cosine_from_points(a, b, c, &output->sin_at_b, &output->cos_at_b);
+    sine_cosine_from_points(b, c, a, &output->sin_at_c, &output->cos_at_c);
+
+    // success
+    return 1;
+}
+
+uint8_t positioning_q_from_angles(
+        angle_q_t alpha,
+        angle_q_t beta,
+        angle_q_t gamma,
+        const reference_triangle_q_t * t,
+        position_q_t * output)
+{
+    // the angles wrap around, a valid sum is close to 0
+    int32_t sum = (int32_t)(alpha + beta + gamma);
+
+    // output is not valid if input is not valid
+    if (output == NULL || t == NULL ||
+            sum >= ANGLE_SUM_TOLERANCE || sum <= -ANGLE_SUM_TOLERANCE) {
+        return 0;
+    }
+
+    q31_t sin_alpha = q31_sin(alpha);
+    q31_t cos_alpha = q31_cos(alpha);
+    q31_t sin_beta = q31_sin(beta);
+    q31_t cos_beta = q31_cos(beta);
+    q31_t sin_gamma = q31_sin(gamma);
+    q31_t cos_gamma = q31_cos(gamma);
+
+    // cot(A) - cot(alpha) = sin(alpha - A) / (sin(A) * sin(alpha)), the
+    // barycentric coordinate for A is s_a / d_a with
+    // s_a = sin(A) * sin(alpha), d_a = sin(alpha - A)
+    int64_t s_a = q31_mul(t->sin_at_a, sin_alpha);
+    int64_t s_b = q31_mul(t->sin_at_b, sin_beta);
+    int64_t s_c = q31_mul(t->sin_at_c, sin_gamma);
+    int64_t d_a = ((int64_t)sin_alpha * t->cos_at_a
+            - (int64_t)cos_alpha * t->sin_at_a) >> 31;
+    int64_t d_b = ((int64_t)sin_beta * t->cos_at_b
+            - (int64_t)cos_beta * t->sin_at_b) >> 31;
+    int64_t d_c = ((int64_t)sin_gamma * t->cos_at_c
+            - (int64_t)cos_gamma * t->sin_at_c) >> 31;
+
+    // same test as the float version, |cot(A) - cot(alpha)| < 0.1
+    uint8_t is_valid = 1;
+    if (
+        10 * llabs(d_a) < llabs(s_a) ||
+        10 * llabs(d_b) < llabs(s_b) ||
+        10 * llabs(d_c) < llabs(s_c))
+    {
+        is_valid = 0;
+    }
+
+    // barycentric coordinates over a common denominator,
+    // (s_a*d_b*d_c, s_b*d_a*d_c, s_c*d_a*d_b), scaled down to 30 bits
+    // after every multiplication
+    int64_t n_a = s_a * d_b;
+    int64_t n_b = s_b * d_a;
+    int64_t n_c = s_c * d_a;
+    normalize(&n_a, &n_b, &n_c);
+    n_a *= d_c;
+    n_b *= d_c;
+    n_c *= d_b;
+    normalize(&n_a, &n_b, &n_c);
+
+    int64_t magnitude = n_a + n_b + n_c;
+
+    // all barycentric coordinates infinite, nothing sensible to output
+    if (magnitude == 0) {
+        return 0;
+    }
+
+    // convert to cartesian coordinates
+    output->x = (q8_24_t)((n_a * t->point_a->x + n_b * t->point_b->x +
+                n_c * t->point_c->x) / magnitude);
+    output->y = (q8_24_t)((n_a * t->point_a->y + n_b * t->point_b->y +
+                n_c * t->point_c->y) / magnitude);
+
+    return is_valid;
+}
+
+angle_q_t positioning_q_angle_from_ticks(uint32_t delta, uint32_t period)
+{
+    if (period == 0) {
+        return 0;
+    }
+
+    return (angle_q_t)(((uint64_t)delta << 32) / period);
+}
+
+/*
+ * implementation of private functions
+ */
+
+// return orientation of points a, b, c, 48 fractional bits
+static int64_t orientation(
+        const position_q_t * a,
+        const position_q_t * b,
+        const position_q_t * c)
+{
+    int64_t ab_x = b->x - a->x;
+    int64_t ab_y = b->y - a->y;
+    int64_t ac_x = c->x - a->x;
+    int64_t ac_y = c->y - a->y;
+
+    return ab_x * ac_y - ac_x * ab_y;
+}
+
+// compute the sine and cosine of the angle ABC (angle at B), the angle is
+// assumed to be inside a triangle, in (0, Pi)
+static void sine_cosine_from_points(
+        const position_q_t * a,
+        const position_q_t * b,
+        const position_q_t * c,
+        q31_t * sine,
+        q31_t * cosine)
+{
+    // vectors from point b to points a and c
+    int64_t ba_x = a->x - b->x;
+    int64_t ba_y = a->y - b->y;
+    int64_t bc_x = c->x - b->x;
+    int64_t bc_y = c->y - b->y;
+
+    int64_t len_ba = fixed_isqrt64(ba_x * ba_x + ba_y * ba_y);
+    int64_t len_bc = fixed_isqrt64(bc_x * bc_x + bc_y * bc_y);
+
+    // unit vectors with 30 fractional bits
+    int64_t u_x = ba_x * ((int64_t)1 << 30) / len_ba;
+    int64_t u_y = ba_y * ((int64_t)1 << 30) / len_ba;
+    int64_t v_x = bc_x * ((int64_t)1 << 30) / len_bc;
+    int64_t v_y = bc_y * ((int64_t)1 << 30) / len_bc;
+
+    *cosine = saturate((u_x * v_x + u_y * v_y) >> 29);
+    *sine = saturate(llabs(u_x * v_y - u_y * v_x) >> 29);
+}
+
+// shift all values right by the same amount until they fit in 30 bits
+static void normalize(int64_t * v0, int64_t * v1, int64_t * v2)
+{
+    uint64_t magnitude = llabs(*v0) | llabs(*v1) | llabs(*v2);
+    int shift = 0;
+
+    while ((magnitude >> shift) >= ((uint64_t)1 << 30)) {
+        shift++;
+    }
+
+    *v0 >>= shift;
+    *v1 >>= shift;
+    *v2 >>= shift;
+}
+
+static q31_t saturate(int64_t value)
+{
+    if (value > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (q31_t)value;
+}
@@ -0,0 +1,60 @@
+
+#ifndef POSITIONING_Q_H
+#define POSITIONING_Q_H
+
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+// fixed-point counterpart of positioning.h, no floating point operation
+// is used. the cotangents of the float version are replaced by the sine
+// and cosine of the angles so that every intermediate value is bounded.
+
+typedef struct {
+    q8_24_t x;
+    q8_24_t y;
+} position_q_t;
+
+typedef struct {
+    const position_q_t * point_a;
+    const position_q_t * point_b;
+    const position_q_t * point_c;
+    q31_t sin_at_a;
+    q31_t cos_at_a;
+    q31_t sin_at_b;
+    q31_t cos_at_b;
+    q31_t sin_at_c;
+    q31_t cos_at_c;
+} reference_triangle_q_t;
+
+// initializes a reference_triangle_q_t from points a, b and c
+// computes sine and cosine of angles at each point
+//
+// return 1 on correct initialization
+// doesn't do anything and return 0 if any of the input parameters are NULL
+// or points a, b, c are not oriented positively
+uint8_t positioning_q_reference_triangle_from_points(
+        const position_q_t * a,
+        const position_q_t * b,
+        const position_q_t * c,
+        reference_triangle_q_t * output);
+
+// computes cartesian coordinates from angles with respect to
+// a reference triangle, same as positioning_from_angles
+//
+// returns 1 if the result is to be trusted and can safely be used
+// returns 0 if either input params are invalid (angles don't sum to a
+// whole turn, pointers are NULL) or result lies on/near the circumcircle
+// of the reference triangle
+uint8_t positioning_q_from_angles(
+        angle_q_t alpha,
+        angle_q_t beta,
+        angle_q_t gamma,
+        const reference_triangle_q_t * t,
+        position_q_t * output);
+
+// angle swept during 'delta' timer ticks if a whole turn takes 'period'
+// ticks
+angle_q_t positioning_q_angle_from_ticks(uint32_t delta, uint32_t period);
+
+#endif
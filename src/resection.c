@@ -0,0 +1,244 @@
+
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "resection.h"
+#include "float_math.h"
+
+// public function prototypes
+uint8_t resection_init(
+        resection_t * resection,
+        const position_t * beacons,
+        uint8_t nb_beacons);
+uint8_t resection_from_bearings(
+        const resection_t * resection,
+        const float * bearings,
+        uint8_t visible,
+        float var_bearing,
+        const position_t * guess,
+        position_t * output,
+        position_covariance_t * covariance);
+// private function prototypes
+static uint8_t triangle_from_bearings(
+        const resection_t * resection,
+        const float * bearings,
+        float var_bearing,
+        position_t * output,
+        position_covariance_t * covariance);
+static float wrap_two_pi(float angle);
+static float wrap_pi(float angle);
+
+
+/*
+ * implementation of public functions
+ */
+
+uint8_t resection_init(
+        resection_t * resection,
+        const position_t * beacons,
+        uint8_t nb_beacons)
+{
+    // verify input
+    if (resection == NULL || beacons == NULL || nb_beacons < 3 ||
+        nb_beacons > RESECTION_MAX_BEACONS)
+    {
+        return 0;
+    }
+
+    resection->_beacons = beacons;
+    resection->_nb_beacons = nb_beacons;
+
+    // the closed form needs a, b, c oriented positively
+    resection->_has_triangle = nb_beacons == 3 &&
+        positioning_reference_triangle_from_points(
+                &beacons[0], &beacons[1], &beacons[2], &resection->_triangle);
+
+    return 1;
+}
+
+uint8_t resection_from_bearings(
+        const resection_t * resection,
+        const float * bearings,
+        uint8_t visible,
+        float var_bearing,
+        const position_t * guess,
+        position_t * output,
+        position_covariance_t * covariance)
+{
+    // output is not valid if input is not valid
+    if (resection == NULL || bearings == NULL || output == NULL ||
+        covariance == NULL || var_bearing < 0.0f)
+    {
+        return 0;
+    }
+
+    const position_t * beacons = resection->_beacons;
+    uint8_t nb_visible = 0;
+    uint8_t first = 0;
+    float sum_x = 0.0f, sum_y = 0.0f;
+    uint8_t i;
+
+    for (i = 0; i < resection->_nb_beacons; i++) {
+        if (visible & (1u << i)) {
+            if (nb_visible == 0) {
+                first = i;
+            }
+            nb_visible++;
+            sum_x += beacons[i].x;
+            sum_y += beacons[i].y;
+        }
+    }
+
+    // three unknowns
+    if (nb_visible < 3) {
+        return 0;
+    }
+
+    // the fast case, it can't tell more than the least squares with three
+    // beacons
+    if (resection->_has_triangle &&
+        triangle_from_bearings(resection, bearings, var_bearing, output,
+            covariance))
+    {
+        return 1;
+    }
+
+    float x = guess != NULL ? guess->x : sum_x / nb_visible;
+    float y = guess != NULL ? guess->y : sum_y / nb_visible;
+
+    // origin of the bearings, seen from the guess
+    float origin = atan2f(beacons[first].y - y, beacons[first].x - x) -
+        bearings[first];
+
+    // normal equations J^T * J (symmetric, upper triangle) and J^T * r of
+    // the bearings predicted from (x, y, origin)
+    float n_xx = 0.0f, n_xy = 0.0f, n_xo = 0.0f;
+    float n_yy = 0.0f, n_yo = 0.0f, n_oo = 0.0f;
+    float step = 0.0f;
+    uint8_t k;
+
+    for (k = 0; k < RESECTION_MAX_ITERATIONS; k++) {
+        float g_x = 0.0f, g_y = 0.0f, g_o = 0.0f;
+
+        n_xx = n_xy = n_xo = n_yy = n_yo = n_oo = 0.0f;
+
+        for (i = 0; i < resection->_nb_beacons; i++) {
+            if (!(visible & (1u << i))) {
+                continue;
+            }
+
+            float dx = beacons[i].x - x;
+            float dy = beacons[i].y - y;
+            float inv_sq = 1.0f / (dx * dx + dy * dy);
+
+            // the predicted bearing atan2(dy, dx) - origin moves by
+            // (dy, -dx) / |d|^2 with the position and by -1 with the origin
+            float j_x = dy * inv_sq;
+            float j_y = -dx * inv_sq;
+            float r = wrap_pi(bearings[i] - (atan2f(dy, dx) - origin));
+
+            n_xx += j_x * j_x;
+            n_xy += j_x * j_y;
+            n_xo -= j_x;
+            n_yy += j_y * j_y;
+            n_yo -= j_y;
+            n_oo += 1.0f;
+            g_x += j_x * r;
+            g_y += j_y * r;
+            g_o -= r;
+        }
+
+        // cofactors of the normal equations
+        float c_xx = n_yy * n_oo - n_yo * n_yo;
+        float c_xy = n_xo * n_yo - n_xy * n_oo;
+        float c_xo = n_xy * n_yo - n_yy * n_xo;
+        float c_yy = n_xx * n_oo - n_xo * n_xo;
+        float c_yo = n_xy * n_xo - n_xx * n_yo;
+        float c_oo = n_xx * n_yy - n_xy * n_xy;
+        float det = n_xx * c_xx + n_xy * c_xy + n_xo * c_xo;
+
+        // the beacons and the guess are on one circle
+        if (!(det > 0.0f)) {
+            return 0;
+        }
+
+        float d_x = (c_xx * g_x + c_xy * g_y + c_xo * g_o) / det;
+        float d_y = (c_xy * g_x + c_yy * g_y + c_yo * g_o) / det;
+        float d_o = (c_xo * g_x + c_yo * g_y + c_oo * g_o) / det;
+
+        // far from the solution the bearings aren't linear enough for a full
+        // step, it is shortened to RESECTION_MAX_STEP
+        step = fabsf(d_x) + fabsf(d_y);
+        if (step > RESECTION_MAX_STEP) {
+            float scale = RESECTION_MAX_STEP / step;
+            d_x *= scale;
+            d_y *= scale;
+            d_o *= scale;
+        }
+        x += d_x;
+        y += d_y;
+        origin += d_o;
+
+        if (step < RESECTION_TOLERANCE) {
+            // var_bearing * (J^T * J)^-1, the block of the position
+            position_covariance_t cov = {
+                var_bearing * c_xx / det,
+                var_bearing * c_yy / det,
+                var_bearing * c_xy / det};
+
+            if (!isfinite(x) || !isfinite(y)) {
+                return 0;
+            }
+
+            position_t pos = {x, y};
+
+            // copy result to output
+            memcpy(output, &pos, sizeof(position_t));
+            memcpy(covariance, &cov, sizeof(position_covariance_t));
+
+            return 1;
+        }
+    }
+
+    // didn't converge, or NaN
+    return 0;
+}
+
+/*
+ * implementation of private functions
+ */
+
+// the three beacons of the set are visible, alpha is the angle from b to c
+// seen from the position, beta from c to a and gamma from a to b
+static uint8_t triangle_from_bearings(
+        const resection_t * resection,
+        const float * bearings,
+        float var_bearing,
+        position_t * output,
+        position_covariance_t * covariance)
+{
+    return positioning_from_angles_with_covariance(
+            wrap_two_pi(bearings[2] - bearings[1]),
+            wrap_two_pi(bearings[0] - bearings[2]),
+            wrap_two_pi(bearings[1] - bearings[0]),
+            var_bearing,
+            &resection->_triangle,
+            output,
+            covariance);
+}
+
+// 'angle' in [0, 2 Pi)
+static float wrap_two_pi(float angle)
+{
+    angle -= FLOAT_2_PI * floorf(angle / FLOAT_2_PI);
+
+    return angle < FLOAT_2_PI ? angle : 0.0f;
+}
+
+// 'angle' in [-Pi, Pi)
+static float wrap_pi(float angle)
+{
+    return wrap_two_pi(angle + FLOAT_PI) - FLOAT_PI;
+}
@@ -0,0 +1,86 @@
+
+#ifndef RESECTION_H
+#define RESECTION_H
+
+#include <stdint.h>
+
+#include "positioning.h"
+
+// positioning from the bearings of a set of up to RESECTION_MAX_BEACONS
+// beacons, by least squares
+//
+// the unknowns are the position and the bearing the laser measures its
+// angles from. every visible beacon adds its row to the normal equations
+// of a Gauss-Newton step (3x3, accumulated one beacon at a time), so an
+// iteration costs one atan2f per beacon and a 3x3 solve: linear in the
+// number of beacons. with more than three beacons there is no circle on
+// which the position can't be told, and a hidden beacon only removes its
+// row.
+//
+// three beacons seen out of a set of three go through
+// positioning_from_angles_with_covariance instead, the closed form
+
+// most beacons of a set
+#define RESECTION_MAX_BEACONS (8)
+
+// gauss-newton iterations at most per fix, from the center of the beacons
+// of a 3 x 2 [m] table every position converges in less than 20. from the
+// last estimate of the robot it takes a few
+#define RESECTION_MAX_ITERATIONS (20)
+
+// longest step of an iteration (|dx| + |dy|) [m]
+#define RESECTION_MAX_STEP (0.3f)
+
+// the iterations stop once a step moves the position by less than this
+// (|dx| + |dy|) [m], a fix whose last step is longer isn't trusted
+#define RESECTION_TOLERANCE (1e-5f)
+
+// WARNING : this type should be opaque, its only here to
+// allow static allocation by user
+typedef struct {
+    const position_t * _beacons;
+    uint8_t _nb_beacons;
+    // the closed form for a set of three positively oriented beacons
+    uint8_t _has_triangle;
+    reference_triangle_t _triangle;
+} resection_t;
+
+// initializes 'resection' for the 'nb_beacons' beacons at 'beacons', which
+// must stay valid as long as 'resection' is used
+//
+// return 1 on success
+// return 0 if a pointer is NULL or there are less than 3 or more than
+// RESECTION_MAX_BEACONS beacons
+uint8_t resection_init(
+        resection_t * resection,
+        const position_t * beacons,
+        uint8_t nb_beacons);
+
+// computes the position the beacons are seen from
+//
+// 'bearings[i]' [rad] is the bearing of beacon i, measured counter
+// clockwise from any origin common to all beacons (e.g. 2 Pi times the
+// time since the edge of beacon 0 over the period of the laser). bit i of
+// 'visible' tells if beacon i was seen, the bearings of the others are
+// ignored. the bearings are taken as independently noisy with variance
+// 'var_bearing' [rad^2] and the covariance of the position is copied to
+// 'covariance', like positioning_from_angles_with_covariance
+//
+// the iterations start from 'guess', e.g. the last estimate of the robot,
+// or from the center of the visible beacons if it is NULL
+//
+// returns 1 if the position and its covariance could be computed
+// returns 0 if either input params are invalid (pointers are NULL,
+// 'var_bearing' < 0), less than 3 beacons are visible, the visible beacons
+// don't tell the position (all on one circle with it) or the iterations
+// didn't converge, 'output' and 'covariance' are then left untouched
+uint8_t resection_from_bearings(
+        const resection_t * resection,
+        const float * bearings,
+        uint8_t visible,
+        float var_bearing,
+        const position_t * guess,
+        position_t * output,
+        position_covariance_t * covariance);
+
+#endif
@@ -3,9 +3,14 @@
 #include <string.h>
 #include <platform-abstraction/criticalsection.h>
 #include <platform-abstraction/panic.h>
+#include <platform-abstraction/threading.h>
 #include <libopencm3/stm32/usart.h>
 #include <os.h>
 
+#include "byte_ring.h"
+#include "runtime.h"
+#include "beacon_config.h"
+
 typedef struct {
     void *(*open) (void *file, const char *path, int flags, int mode);
     int (*close)  (void *file);
@@ -15,14 +20,27 @@ typedef struct {
 
 extern const file_ops_t uart_ops; // defined below
 
+// writes are queued in 'tx' and sent by the transmit interrupt, 'policy'
+// tells what happens to what doesn't fit, see byte_ring.h. the receive
+// interrupt queues every byte in 'rx' for the reads
+typedef struct {
+    uint32_t usart;
+    int policy;
+    byte_ring_t tx;
+    byte_ring_t rx;
+} uart_file_t;
+
+static uart_file_t uart1_file = {.usart = USART1, .policy = UART1_TX_POLICY};
+static uart_file_t uart2_file = {.usart = USART2, .policy = UART2_TX_POLICY};
+
 #define FILE_DESC_TABLE_SIZE 10
 struct {
     const file_ops_t *ops;
     void *file;
 } fd_list[FILE_DESC_TABLE_SIZE] = {
-    {.ops = &uart_ops, .file = (void *)USART1}, // stdin
-    {.ops = &uart_ops, .file = (void *)USART1}, // stdout
-    {.ops = &uart_ops, .file = (void *)USART2}  // stderr
+    {.ops = &uart_ops, .file = &uart1_file}, // stdin
+    {.ops = &uart_ops, .file = &uart1_file}, // stdout
+    {.ops = &uart_ops, .file = &uart2_file}  // stderr
 };
 
 
@@ -40,16 +58,93 @@ static int uart_op_close (void *file)
 
 static int uart_op_write (void *file, const char *buf, int len)
 {
-    int32_t  i;
-    for (i = 0; i < len; i++) {
-        usart_send_blocking((uint32_t)file, buf[i]);
+    uart_file_t *uart = file;
+    int done = 0;
+
+    while (1) {
+        done += byte_ring_write(&uart->tx, buf + done, len - done, uart->policy);
+        // the interrupt disables itself once the ring is empty
+        usart_enable_tx_interrupt(uart->usart);
+        if (done == len) {
+            return len;
+        }
+        // BYTE_RING_BLOCK, wait for the interrupt to make room
+        os_thread_sleep_us(UART_TX_BLOCK_POLL_PERIOD);
+    }
+}
+
+static void uart_isr(uart_file_t *uart)
+{
+    uint8_t byte;
+
+    if (usart_get_flag(uart->usart, USART_ISR_RXNE)) {
+        byte = usart_recv(uart->usart);
+        byte_ring_write(&uart->rx, &byte, 1, BYTE_RING_DROP_NEW);
+    }
+    // a byte was lost before RXNE got serviced, the flag has to be cleared
+    // or the interrupt fires again and again
+    if (usart_get_flag(uart->usart, USART_ISR_ORE)) {
+        USART_ICR(uart->usart) = USART_ICR_ORECF;
+    }
+
+    if (usart_get_flag(uart->usart, USART_ISR_TXE)
+            && (USART_CR1(uart->usart) & USART_CR1_TXEIE)) {
+        if (byte_ring_pop(&uart->tx, &byte)) {
+            usart_send(uart->usart, byte);
+        } else {
+            usart_disable_tx_interrupt(uart->usart);
+        }
+    }
+}
+
+void usart1_exti25_isr(void)
+{
+    uart_isr(&uart1_file);
+}
+
+void usart2_exti26_isr(void)
+{
+    uart_isr(&uart2_file);
+}
+
+static uart_file_t *uart_file(uint32_t usart)
+{
+    if (usart == USART1) {
+        return &uart1_file;
     }
-    return len;
+    if (usart == USART2) {
+        return &uart2_file;
+    }
+    return NULL;
+}
+
+uint32_t uart_tx_dropped(uint32_t usart)
+{
+    uart_file_t *uart = uart_file(usart);
+    return uart != NULL ? byte_ring_dropped(&uart->tx) : 0;
+}
+
+uint32_t uart_rx_dropped(uint32_t usart)
+{
+    uart_file_t *uart = uart_file(usart);
+    return uart != NULL ? byte_ring_dropped(&uart->rx) : 0;
 }
 
+// returns what was received, waits for at least one byte
 static int uart_op_read (void *file, char *buf, int len)
 {
-    return 0; // TODO!
+    uart_file_t *uart = file;
+    int count = 0;
+
+    while (1) {
+        while (count < len && byte_ring_pop(&uart->rx, (uint8_t *)&buf[count])) {
+            count++;
+        }
+        if (count > 0 || len <= 0) {
+            return count;
+        }
+        os_thread_sleep_us(UART_RX_POLL_PERIOD);
+    }
 }
 
 const file_ops_t uart_ops = {
@@ -68,8 +163,8 @@ typedef struct {
 } dev_file_ops_t;
 
 const dev_file_ops_t dev_fd_tab[] = {
-    {.devicename = "st-link", .ops = &uart_ops, .dev = (void *)USART2},
-    {.devicename = "uart1", .ops = &uart_ops, .dev = (void *)USART1},
+    {.devicename = "st-link", .ops = &uart_ops, .dev = &uart2_file},
+    {.devicename = "uart1", .ops = &uart_ops, .dev = &uart1_file},
 };
 #define NB_DEV_FD (sizeof(dev_fd_tab)/sizeof(dev_file_ops_t))
 
@@ -0,0 +1,14 @@
+#ifndef RUNTIME_H_
+#define RUNTIME_H_
+
+#include <stdint.h>
+
+// bytes written to 'usart' (USART1 or USART2) that were dropped because its
+// transmit ring was full
+uint32_t uart_tx_dropped(uint32_t usart);
+
+// bytes received on 'usart' that were dropped because its receive ring was
+// full, bytes lost to an overrun aren't counted
+uint32_t uart_rx_dropped(uint32_t usart);
+
+#endif
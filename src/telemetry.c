@@ -0,0 +1,155 @@
+#include <string.h>
+
+#include "telemetry.h"
+
+static uint8_t *put_u32(uint8_t *dest, uint32_t value);
+static uint8_t *put_float(uint8_t *dest, float value);
+
+size_t telemetry_encode_robot_state(
+        const telemetry_robot_state_t *state,
+        uint8_t *frame)
+{
+    uint8_t payload[TELEMETRY_ROBOT_STATE_SIZE + 2];
+    uint8_t *p = payload;
+
+    *p++ = TELEMETRY_ROBOT_STATE;
+    *p++ = state->robot;
+    *p++ = state->flags;
+    p = put_u32(p, state->time);
+    p = put_float(p, state->x);
+    p = put_float(p, state->y);
+    p = put_float(p, state->var_x);
+    p = put_float(p, state->var_y);
+    p = put_float(p, state->cov_xy);
+
+    uint16_t crc = telemetry_crc16(payload, TELEMETRY_ROBOT_STATE_SIZE);
+    *p++ = crc & 0xff;
+    *p++ = crc >> 8;
+
+    size_t length = telemetry_cobs_encode(payload, sizeof(payload), frame);
+    frame[length++] = 0;
+
+    return length;
+}
+
+size_t telemetry_encode_edge_trace(
+        const uint8_t *records,
+        size_t length,
+        uint8_t *frame)
+{
+    uint8_t payload[1 + TELEMETRY_EDGE_TRACE_MAX_SIZE + 2];
+
+    if(length > TELEMETRY_EDGE_TRACE_MAX_SIZE){
+        return 0;
+    }
+
+    payload[0] = TELEMETRY_EDGE_TRACE;
+    memcpy(&payload[1], records, length);
+
+    uint16_t crc = telemetry_crc16(payload, 1 + length);
+    payload[1 + length] = crc & 0xff;
+    payload[2 + length] = crc >> 8;
+
+    length = telemetry_cobs_encode(payload, 3 + length, frame);
+    frame[length++] = 0;
+
+    return length;
+}
+
+uint16_t telemetry_crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xffff;
+    size_t i;
+    int bit;
+
+    for(i = 0; i < length; i++){
+        crc ^= (uint16_t)data[i] << 8;
+        for(bit = 0; bit < 8; bit++){
+            if(crc & 0x8000){
+                crc = (crc << 1) ^ 0x1021;
+            } else{
+                crc <<= 1;
+            }
+        }
+    }
+
+    return crc;
+}
+
+size_t telemetry_cobs_encode(const uint8_t *data, size_t length, uint8_t *dest)
+{
+    // every block starts with the offset to the next zero (or to the end
+    // of a 254 bytes block)
+    size_t code_index = 0;
+    size_t out = 1;
+    uint8_t code = 1;
+    size_t i;
+
+    for(i = 0; i < length; i++){
+        if(data[i] == 0){
+            dest[code_index] = code;
+            code_index = out++;
+            code = 1;
+            continue;
+        }
+
+        dest[out++] = data[i];
+        code++;
+        if(code == 0xff){
+            dest[code_index] = code;
+            code_index = out++;
+            code = 1;
+        }
+    }
+    dest[code_index] = code;
+
+    return out;
+}
+
+size_t telemetry_cobs_decode(const uint8_t *data, size_t length, uint8_t *dest)
+{
+    size_t in = 0;
+    size_t out = 0;
+
+    while(in < length){
+        uint8_t code = data[in++];
+
+        if(code == 0 || in + code - 1 > length){
+            return 0;
+        }
+
+        uint8_t i;
+        for(i = 1; i < code; i++){
+            if(data[in] == 0){
+                return 0;
+            }
+            dest[out++] = data[in++];
+        }
+
+        // a block shorter than 254 bytes stands for a zero, except the last
+        if(code != 0xff && in < length){
+            dest[out++] = 0;
+        }
+    }
+
+    return out;
+}
+
+static uint8_t *put_u32(uint8_t *dest, uint32_t value)
+{
+    dest[0] = value & 0xff;
+    dest[1] = (value >> 8) & 0xff;
+    dest[2] = (value >> 16) & 0xff;
+    dest[3] = value >> 24;
+
+    return dest + 4;
+}
+
+static uint8_t *put_float(uint8_t *dest, float value)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return put_u32(dest, bits);
+}
@@ -0,0 +1,96 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+/*
+ * Binary telemetry frames. A frame is a little-endian payload followed by
+ * its CRC-16/CCITT-FALSE (little-endian as well), COBS encoded and
+ * terminated by a 0 byte, so a receiver resynchronizes on the next 0 after
+ * any lost or corrupted byte. visualizer/viserial.py decodes them.
+ *
+ * robot state payload (TELEMETRY_ROBOT_STATE_SIZE bytes):
+ *   uint8_t  type       TELEMETRY_ROBOT_STATE
+ *   uint8_t  robot      index of the robot
+ *   uint8_t  flags      TELEMETRY_FLAG_*
+ *   uint32_t time       [us], time the state refers to
+ *   float    x, y       [m]
+ *   float    var_x, var_y, cov_xy   [m^2]
+ *
+ * edge trace payload (1 + up to TELEMETRY_EDGE_TRACE_MAX_SIZE bytes):
+ *   uint8_t  type       TELEMETRY_EDGE_TRACE
+ *   uint8_t  records[]  edge trace records, see edge_trace.h
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_ROBOT_STATE       (1)
+#define TELEMETRY_ROBOT_STATE_SIZE  (27)
+#define TELEMETRY_EDGE_TRACE        (2)
+// bytes of records in an edge trace frame
+#define TELEMETRY_EDGE_TRACE_MAX_SIZE   (60)
+
+// a fix was fused since the previous frame of this robot
+#define TELEMETRY_FLAG_FIX          (1 << 0)
+// the robot didn't get a fix for a while, the state is only predicted
+#define TELEMETRY_FLAG_LOST         (1 << 1)
+// the link dropped bytes since the previous frame, frames may be missing
+#define TELEMETRY_FLAG_TX_DROPPED   (1 << 2)
+
+// size of the CRC and of the COBS overhead (one byte up to 254 bytes)
+// plus the delimiter
+#define TELEMETRY_FRAME_OVERHEAD    (4)
+#define TELEMETRY_FRAME_MAX_SIZE \
+    (1 + TELEMETRY_EDGE_TRACE_MAX_SIZE + TELEMETRY_FRAME_OVERHEAD)
+
+typedef struct {
+    uint8_t robot;
+    uint8_t flags;
+    uint32_t time;
+    float x;
+    float y;
+    float var_x;
+    float var_y;
+    float cov_xy;
+} telemetry_robot_state_t;
+
+// writes the frame of 'state' to 'frame', which holds at least
+// TELEMETRY_FRAME_MAX_SIZE bytes
+//
+// return the length of the frame, delimiter included
+size_t telemetry_encode_robot_state(
+        const telemetry_robot_state_t *state,
+        uint8_t *frame);
+
+// writes the frame of the 'length' bytes of edge trace 'records' to 'frame',
+// which holds at least TELEMETRY_FRAME_MAX_SIZE bytes
+//
+// return the length of the frame, delimiter included, 0 if 'length' is
+// above TELEMETRY_EDGE_TRACE_MAX_SIZE
+size_t telemetry_encode_edge_trace(
+        const uint8_t *records,
+        size_t length,
+        uint8_t *frame);
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xffff) of 'data'
+uint16_t telemetry_crc16(const uint8_t *data, size_t length);
+
+// COBS encodes 'length' bytes of 'data' to 'dest', which holds at least
+// length + length / 254 + 1 bytes, no delimiter is appended
+//
+// return the encoded length
+size_t telemetry_cobs_encode(const uint8_t *data, size_t length, uint8_t *dest);
+
+// decodes the COBS encoded 'length' bytes of 'data' (without delimiter)
+// to 'dest', which holds at least 'length' bytes
+//
+// return the decoded length, 0 if 'data' isn't valid COBS
+size_t telemetry_cobs_decode(const uint8_t *data, size_t length, uint8_t *dest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
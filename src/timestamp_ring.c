@@ -0,0 +1,58 @@
+#include "timestamp_ring.h"
+
+// orders the accesses to the event slots and to the counters, a DMB on the
+// Cortex-M4 which is enough between an interrupt and a thread
+#define MEMORY_BARRIER() __sync_synchronize()
+
+void timestamp_ring_init(timestamp_ring_t *ring)
+{
+    ring->_head = 0;
+    ring->_tail = 0;
+    ring->_dropped = 0;
+}
+
+uint8_t timestamp_ring_push(timestamp_ring_t *ring,
+                            uint8_t beacon,
+                            uint32_t time)
+{
+    uint32_t head = ring->_head;
+
+    if(head - ring->_tail >= TIMESTAMP_RING_SIZE){
+        ring->_dropped++;
+        return 0;
+    }
+
+    timestamp_event_t *slot = &ring->_events[head & (TIMESTAMP_RING_SIZE - 1)];
+    slot->time = time;
+    slot->beacon = beacon;
+
+    // the event must be complete before the consumer can see it
+    MEMORY_BARRIER();
+    ring->_head = head + 1;
+
+    return 1;
+}
+
+uint8_t timestamp_ring_pop(timestamp_ring_t *ring, timestamp_event_t *event)
+{
+    uint32_t tail = ring->_tail;
+
+    if(ring->_head == tail){
+        return 0;
+    }
+
+    // don't read the slot before having seen the producer's _head
+    MEMORY_BARRIER();
+    *event = ring->_events[tail & (TIMESTAMP_RING_SIZE - 1)];
+
+    // the slot must be read before the producer can reuse it
+    MEMORY_BARRIER();
+    ring->_tail = tail + 1;
+
+    return 1;
+}
+
+uint32_t timestamp_ring_dropped(const timestamp_ring_t *ring)
+{
+    return ring->_dropped;
+}
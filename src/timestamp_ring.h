@@ -0,0 +1,53 @@
+#ifndef TIMESTAMP_RING_H_
+#define TIMESTAMP_RING_H_
+/*
+ * Lock-free single-producer/single-consumer ring of laser edge timestamps.
+ * The producer is an interrupt handler, the consumer a thread, neither of
+ * them ever disables interrupts.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// number of events the ring can hold, must be a power of 2
+#define TIMESTAMP_RING_SIZE (32)
+
+typedef struct {
+    uint32_t time;
+    uint8_t beacon;
+} timestamp_event_t;
+
+typedef struct {
+    timestamp_event_t _events[TIMESTAMP_RING_SIZE];
+
+    // free running counters, _head is only written by the producer and
+    // _tail only by the consumer
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
+
+    // events the producer had to drop because the ring was full
+    volatile uint32_t _dropped;
+} timestamp_ring_t;
+
+void timestamp_ring_init(timestamp_ring_t *ring);
+
+// producer side, return 1 on success, 0 if the ring is full in which case
+// the event is dropped and counted
+uint8_t timestamp_ring_push(timestamp_ring_t *ring,
+                            uint8_t beacon,
+                            uint32_t time);
+
+// consumer side, return 1 if the oldest event was moved to 'event',
+// 0 if the ring is empty
+uint8_t timestamp_ring_pop(timestamp_ring_t *ring, timestamp_event_t *event);
+
+uint32_t timestamp_ring_dropped(const timestamp_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+#include <string.h>
+
+#include "triple_buffer.h"
+
+// set in _middle when it holds a value the reader didn't take yet
+#define TRIPLE_BUFFER_FRESH (4)
+#define TRIPLE_BUFFER_INDEX (3)
+
+void triple_buffer_init(triple_buffer_t *buffer, void *storage, size_t size)
+{
+    buffer->_storage = storage;
+    buffer->_size = size;
+    buffer->_front = 0;
+    buffer->_middle = 1;
+    buffer->_back = 2;
+
+    memset(storage, 0, 3 * size);
+}
+
+void *triple_buffer_write_buffer(triple_buffer_t *buffer)
+{
+    return &buffer->_storage[buffer->_back * buffer->_size];
+}
+
+void triple_buffer_publish(triple_buffer_t *buffer)
+{
+    // the release orders the writes to the buffer before the swap, a DMB
+    // and a LDREX/STREX loop on the Cortex-M4
+    uint32_t middle = __atomic_exchange_n(&buffer->_middle,
+            buffer->_back | TRIPLE_BUFFER_FRESH, __ATOMIC_ACQ_REL);
+
+    buffer->_back = middle & TRIPLE_BUFFER_INDEX;
+}
+
+uint8_t triple_buffer_update(triple_buffer_t *buffer)
+{
+    // only the writer sets the flag, nothing to take if it's clear
+    if(!(__atomic_load_n(&buffer->_middle, __ATOMIC_RELAXED)
+                & TRIPLE_BUFFER_FRESH)){
+        return 0;
+    }
+
+    uint32_t middle = __atomic_exchange_n(&buffer->_middle,
+            buffer->_front, __ATOMIC_ACQ_REL);
+
+    buffer->_front = middle & TRIPLE_BUFFER_INDEX;
+
+    return 1;
+}
+
+const void *triple_buffer_read(const triple_buffer_t *buffer)
+{
+    return &buffer->_storage[buffer->_front * buffer->_size];
+}
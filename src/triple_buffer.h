@@ -0,0 +1,58 @@
+#ifndef TRIPLE_BUFFER_H_
+#define TRIPLE_BUFFER_H_
+/*
+ * Wait-free single-writer/single-reader publication of a value through
+ * three buffers. The writer fills a buffer of its own and publishes it by
+ * swapping it with the middle one, the reader takes the middle one the same
+ * way. Neither side ever blocks or copies the value and the reader always
+ * gets a value the writer published as a whole.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// WARNING : this type should be opaque, its only here to
+// allow static allocation by user
+typedef struct {
+    uint8_t *_storage;
+    size_t _size;
+
+    // buffer owned by the writer, respectively the reader
+    uint32_t _back;
+    uint32_t _front;
+
+    // buffer in between, with TRIPLE_BUFFER_FRESH set as long as the
+    // reader didn't take what the writer published, only accessed
+    // atomically
+    uint32_t _middle;
+} triple_buffer_t;
+
+// 'storage' holds the three buffers of 'size' bytes each, it is zeroed so
+// the reader gets zeros until the first publication
+void triple_buffer_init(triple_buffer_t *buffer, void *storage, size_t size);
+
+// writer side, buffer to fill with the next value, the same one until it
+// is published
+void *triple_buffer_write_buffer(triple_buffer_t *buffer);
+
+// writer side, makes the content of the write buffer the latest value
+void triple_buffer_publish(triple_buffer_t *buffer);
+
+// reader side, moves to the latest published value
+//
+// return 1 if a value was published since the last call, 0 otherwise
+uint8_t triple_buffer_update(triple_buffer_t *buffer);
+
+// reader side, the value taken by the last triple_buffer_update, the writer
+// doesn't touch it until the next one
+const void *triple_buffer_read(const triple_buffer_t *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,13 +22,14 @@ TEST(BeaconAnglesTestGroup, CanInitToZero)
     CHECK_EQUAL(0, angles._time_a);
     CHECK_EQUAL(0, angles._time_b);
     CHECK_EQUAL(0, angles._time_c);
-    CHECK_EQUAL(0, angles._time_a_old);
-    CHECK_EQUAL(0, angles._time_b_old);
-    CHECK_EQUAL(0, angles._time_c_old);
     CHECK_EQUAL(0, angles._minimal_period);
     CHECK_EQUAL(0, angles.alpha);
     CHECK_EQUAL(0, angles.beta);
     CHECK_EQUAL(0, angles.gamma);
+    CHECK_EQUAL(0, angles.delta_alpha);
+    CHECK_EQUAL(0, angles.delta_beta);
+    CHECK_EQUAL(0, angles.delta_gamma);
+    CHECK_EQUAL(0, angles.timestamp);
     CHECK_FALSE(os_semaphore_try(&angles.measurement_ready));
 }
 
@@ -37,27 +38,22 @@ TEST(BeaconAnglesTestGroup, CanSetMinimalPeriod)
     uint32_t minimal_period = 50000;
     beacon_angles_set_minimal_period(&angles, minimal_period);
     CHECK_EQUAL(minimal_period, angles._minimal_period);
+    CHECK_EQUAL(minimal_period, beacon_angles_get_minimal_period(&angles));
 }
 
 TEST(BeaconAnglesTestGroup, CanUpdateTimestamp)
 {
     uint32_t new_timestamp_a = 20000;
-    uint32_t old_timestamp_a = angles._time_a;
     beacon_angles_update_timestamp(&angles, A, new_timestamp_a);
     CHECK_EQUAL(new_timestamp_a, angles._time_a);
-    CHECK_EQUAL(old_timestamp_a, angles._time_a_old);
 
     uint32_t new_timestamp_b = 20000;
-    uint32_t old_timestamp_b = angles._time_b;
     beacon_angles_update_timestamp(&angles, B, new_timestamp_b);
     CHECK_EQUAL(new_timestamp_b, angles._time_b);
-    CHECK_EQUAL(old_timestamp_b, angles._time_b_old);
 
     uint32_t new_timestamp_c = 20000;
-    uint32_t old_timestamp_c = angles._time_c;
     beacon_angles_update_timestamp(&angles, C, new_timestamp_c);
     CHECK_EQUAL(new_timestamp_c, angles._time_c);
-    CHECK_EQUAL(old_timestamp_c, angles._time_c_old);
 }
 
 TEST(BeaconAnglesTestGroup, CanDetectBadEdge)
@@ -114,6 +110,12 @@ TEST(BeaconAnglesTestGroup, CanCalculateAngles)
     DOUBLES_EQUAL(alpha, angles.alpha, M_PI / 1800);
     DOUBLES_EQUAL(beta, angles.beta, M_PI / 1800);
     DOUBLES_EQUAL(gamma, angles.gamma, M_PI / 1800);
+
+    DOUBLES_EQUAL(period / 3, angles.delta_alpha, 1);
+    DOUBLES_EQUAL(period / 3, angles.delta_beta, 1);
+    DOUBLES_EQUAL(period / 3, angles.delta_gamma, 1);
+
+    CHECK_EQUAL(time_offset + period, angles.timestamp);
 }
 
 TEST(BeaconAnglesTestGroup, CanDetectMissingBeacon)
@@ -127,3 +129,62 @@ TEST(BeaconAnglesTestGroup, CanDetectMissingBeacon)
     CHECK_TRUE(os_semaphore_try(&angles.measurement_ready));
     CHECK_FALSE(beacon_angles_calculate(&angles));
 }
+
+TEST(BeaconAnglesTestGroup, KeepsRotationsQueuedWhileLagging)
+{
+    uint32_t period = 60000;
+    uint32_t t = 20000;
+    int i;
+
+    beacon_angles_update_timestamp(&angles, B, t - period / 3);
+    beacon_angles_update_timestamp(&angles, C, t - period / 6);
+    beacon_angles_update_timestamp(&angles, A, t);
+
+    // two rotations, the second one with different angles
+    beacon_angles_update_timestamp(&angles, B, t + period / 3);
+    beacon_angles_update_timestamp(&angles, C, t + 2 * period / 3);
+    beacon_angles_update_timestamp(&angles, A, t + period);
+    beacon_angles_update_timestamp(&angles, B, t + period + period / 2);
+    beacon_angles_update_timestamp(&angles, C, t + period + 3 * period / 4);
+    beacon_angles_update_timestamp(&angles, A, t + 2 * period);
+
+    // the calculating thread only wakes up now
+    for(i = 0; i < 3; i++){
+        CHECK_TRUE(os_semaphore_try(&angles.measurement_ready));
+    }
+
+    CHECK_TRUE(beacon_angles_calculate(&angles));
+    DOUBLES_EQUAL(period / 3, angles.delta_gamma, 1);
+    DOUBLES_EQUAL(period / 3, angles.delta_alpha, 1);
+    DOUBLES_EQUAL(period / 3, angles.delta_beta, 1);
+
+    CHECK_TRUE(beacon_angles_calculate(&angles));
+    DOUBLES_EQUAL(period / 2, angles.delta_gamma, 1);
+    DOUBLES_EQUAL(period / 4, angles.delta_alpha, 1);
+    DOUBLES_EQUAL(period / 4, angles.delta_beta, 1);
+
+    CHECK_FALSE(beacon_angles_calculate(&angles));
+}
+
+TEST(BeaconAnglesTestGroup, TracesEdgesBeforeFiltering)
+{
+    timestamp_ring_t trace;
+    timestamp_event_t event;
+
+    timestamp_ring_init(&trace);
+    beacon_angles_set_minimal_period(&angles, 20000);
+    beacon_angles_set_trace(&angles, &trace);
+
+    beacon_angles_update_timestamp(&angles, A, 30000);
+    beacon_angles_update_timestamp(&angles, A, 30001);
+    beacon_angles_set_trace(&angles, NULL);
+    beacon_angles_update_timestamp(&angles, B, 40000);
+
+    CHECK_TRUE(timestamp_ring_pop(&trace, &event));
+    CHECK_EQUAL(A, event.beacon);
+    CHECK_EQUAL(30000, event.time);
+    CHECK_TRUE(timestamp_ring_pop(&trace, &event));
+    CHECK_EQUAL(30001, event.time);
+    CHECK_FALSE(timestamp_ring_pop(&trace, &event));
+    CHECK_EQUAL(30000, angles._time_a);
+}
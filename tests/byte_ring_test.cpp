@@ -0,0 +1,119 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/byte_ring.h"
+}
+
+
+TEST_GROUP(ByteRingTestGroup)
+{
+    byte_ring_t ring;
+    uint8_t data[BYTE_RING_SIZE + 16];
+
+    void setup(void)
+    {
+        size_t i;
+
+        byte_ring_init(&ring);
+        for(i = 0; i < sizeof(data); i++){
+            data[i] = (uint8_t)i;
+        }
+    }
+
+    size_t pop_all(uint8_t *dest)
+    {
+        size_t count = 0;
+        while(byte_ring_pop(&ring, &dest[count])){
+            count++;
+        }
+        return count;
+    }
+};
+
+TEST(ByteRingTestGroup, IsEmptyAfterInit)
+{
+    uint8_t byte;
+
+    CHECK_FALSE(byte_ring_pop(&ring, &byte));
+    CHECK_EQUAL(0, byte_ring_dropped(&ring));
+}
+
+TEST(ByteRingTestGroup, PopsInWriteOrder)
+{
+    uint8_t out[8];
+
+    CHECK_EQUAL(3, byte_ring_write(&ring, data, 3, BYTE_RING_DROP_NEW));
+    CHECK_EQUAL(2, byte_ring_write(&ring, &data[10], 2, BYTE_RING_DROP_NEW));
+
+    CHECK_EQUAL(5, pop_all(out));
+    CHECK_EQUAL(0, out[0]);
+    CHECK_EQUAL(2, out[2]);
+    CHECK_EQUAL(10, out[3]);
+    CHECK_EQUAL(11, out[4]);
+}
+
+TEST(ByteRingTestGroup, DropNewKeepsQueuedBytes)
+{
+    uint8_t out[BYTE_RING_SIZE];
+
+    byte_ring_write(&ring, data, BYTE_RING_SIZE - 4, BYTE_RING_DROP_NEW);
+    CHECK_EQUAL(10, byte_ring_write(&ring, &data[100], 10, BYTE_RING_DROP_NEW));
+
+    CHECK_EQUAL(6, byte_ring_dropped(&ring));
+    CHECK_EQUAL(BYTE_RING_SIZE, pop_all(out));
+    CHECK_EQUAL(0, out[0]);
+    CHECK_EQUAL(103, out[BYTE_RING_SIZE - 1]);
+}
+
+TEST(ByteRingTestGroup, DropOldestKeepsNewBytes)
+{
+    uint8_t out[BYTE_RING_SIZE];
+
+    byte_ring_write(&ring, data, BYTE_RING_SIZE - 4, BYTE_RING_DROP_OLDEST);
+    CHECK_EQUAL(10, byte_ring_write(&ring, &data[100], 10, BYTE_RING_DROP_OLDEST));
+
+    CHECK_EQUAL(6, byte_ring_dropped(&ring));
+    CHECK_EQUAL(BYTE_RING_SIZE, pop_all(out));
+    CHECK_EQUAL(6, out[0]);
+    CHECK_EQUAL(109, out[BYTE_RING_SIZE - 1]);
+}
+
+TEST(ByteRingTestGroup, DropOldestKeepsEndOfLongWrite)
+{
+    uint8_t out[BYTE_RING_SIZE];
+
+    byte_ring_write(&ring, data, 4, BYTE_RING_DROP_OLDEST);
+    CHECK_EQUAL(sizeof(data),
+                byte_ring_write(&ring, data, sizeof(data), BYTE_RING_DROP_OLDEST));
+
+    CHECK_EQUAL(4 + 16, byte_ring_dropped(&ring));
+    CHECK_EQUAL(BYTE_RING_SIZE, pop_all(out));
+    CHECK_EQUAL(16, out[0]);
+}
+
+TEST(ByteRingTestGroup, BlockReturnsWhatFits)
+{
+    uint8_t out[BYTE_RING_SIZE];
+
+    byte_ring_write(&ring, data, BYTE_RING_SIZE - 4, BYTE_RING_BLOCK);
+    CHECK_EQUAL(4, byte_ring_write(&ring, &data[100], 10, BYTE_RING_BLOCK));
+    CHECK_EQUAL(0, byte_ring_write(&ring, &data[104], 6, BYTE_RING_BLOCK));
+
+    CHECK_EQUAL(0, byte_ring_dropped(&ring));
+    CHECK_EQUAL(BYTE_RING_SIZE, pop_all(out));
+    CHECK_EQUAL(103, out[BYTE_RING_SIZE - 1]);
+
+    CHECK_EQUAL(6, byte_ring_write(&ring, &data[104], 6, BYTE_RING_BLOCK));
+}
+
+TEST(ByteRingTestGroup, CountersWrapAround)
+{
+    uint8_t out[4];
+
+    ring._head = ring._tail = 0xfffffffe;
+
+    byte_ring_write(&ring, data, 4, BYTE_RING_DROP_NEW);
+
+    CHECK_EQUAL(4, pop_all(out));
+    CHECK_EQUAL(3, out[3]);
+}
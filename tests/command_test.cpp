@@ -0,0 +1,117 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/command.h"
+#include <string.h>
+}
+
+
+TEST_GROUP(CommandTestGroup)
+{
+    command_t command;
+};
+
+TEST(CommandTestGroup, ParsesMeasurementCovariance)
+{
+    CHECK_TRUE(command_parse("cov 0.0025 2.5e-3 -1E-4", &command));
+
+    CHECK_EQUAL(COMMAND_MEAS_COV, command.id);
+    DOUBLES_EQUAL(0.0025, command.args[0], 1e-9);
+    DOUBLES_EQUAL(0.0025, command.args[1], 1e-9);
+    DOUBLES_EQUAL(-0.0001, command.args[2], 1e-10);
+}
+
+TEST(CommandTestGroup, ParsesSingleArgumentCommands)
+{
+    CHECK_TRUE(command_parse("acc 2", &command));
+    CHECK_EQUAL(COMMAND_MAX_ACC, command.id);
+    DOUBLES_EQUAL(2.0, command.args[0], 1e-9);
+
+    CHECK_TRUE(command_parse("  noise   .0625  ", &command));
+    CHECK_EQUAL(COMMAND_PROC_NOISE, command.id);
+    DOUBLES_EQUAL(0.0625, command.args[0], 1e-9);
+}
+
+TEST(CommandTestGroup, ParsesMinimalPeriod)
+{
+    CHECK_TRUE(command_parse("period 2 50000", &command));
+
+    CHECK_EQUAL(COMMAND_MIN_PERIOD, command.id);
+    DOUBLES_EQUAL(2.0, command.args[0], 1e-9);
+    DOUBLES_EQUAL(50000.0, command.args[1], 1e-9);
+}
+
+TEST(CommandTestGroup, ParsesOdometry)
+{
+    CHECK_TRUE(command_parse("odom 1 2500 0.35 -1.2", &command));
+
+    CHECK_EQUAL(COMMAND_ODOMETRY, command.id);
+    DOUBLES_EQUAL(1.0, command.args[0], 1e-9);
+    DOUBLES_EQUAL(2500.0, command.args[1], 1e-9);
+    DOUBLES_EQUAL(0.35, command.args[2], 1e-7);
+    DOUBLES_EQUAL(-1.2, command.args[3], 1e-7);
+
+    CHECK_FALSE(command_parse("odom 1 2500 0.35", &command));
+}
+
+TEST(CommandTestGroup, ParsesTrace)
+{
+    CHECK_TRUE(command_parse("trace 1", &command));
+
+    CHECK_EQUAL(COMMAND_TRACE, command.id);
+    DOUBLES_EQUAL(1.0, command.args[0], 1e-9);
+}
+
+TEST(CommandTestGroup, RejectsMalformedLines)
+{
+    CHECK_FALSE(command_parse("", &command));
+    CHECK_FALSE(command_parse("accel 1", &command));
+    CHECK_FALSE(command_parse("ac 1", &command));
+    CHECK_FALSE(command_parse("acc", &command));
+    CHECK_FALSE(command_parse("acc 1 2", &command));
+    CHECK_FALSE(command_parse("acc 1x", &command));
+    CHECK_FALSE(command_parse("acc .", &command));
+    CHECK_FALSE(command_parse("acc 1e", &command));
+    CHECK_FALSE(command_parse("cov 1 2", &command));
+    CHECK_FALSE(command_parse("acc 1e99", &command));
+    CHECK_FALSE(command_parse("acc -1e39", &command));
+    CHECK_FALSE(command_parse(NULL, &command));
+}
+
+TEST(CommandTestGroup, ReaderAssemblesLines)
+{
+    command_reader_t reader;
+    const char *input = "acc 1\r\nnoise 2\n";
+    const char *lines[2];
+    int nb_lines = 0;
+
+    command_reader_init(&reader);
+    for(; *input != '\0'; input++){
+        const char *line = command_reader_feed(&reader, *input);
+        if(line != NULL){
+            CHECK(nb_lines < 2);
+            lines[nb_lines++] = line;
+            if(nb_lines == 1){
+                STRCMP_EQUAL("acc 1", line);
+            }
+        }
+    }
+
+    CHECK_EQUAL(2, nb_lines);
+    STRCMP_EQUAL("noise 2", lines[1]);
+}
+
+TEST(CommandTestGroup, ReaderDiscardsLongLines)
+{
+    command_reader_t reader;
+    int i;
+
+    command_reader_init(&reader);
+    for(i = 0; i < COMMAND_LINE_SIZE + 10; i++){
+        POINTERS_EQUAL(NULL, command_reader_feed(&reader, 'a'));
+    }
+    POINTERS_EQUAL(NULL, command_reader_feed(&reader, '\n'));
+
+    command_reader_feed(&reader, 'x');
+    STRCMP_EQUAL("x", command_reader_feed(&reader, '\n'));
+}
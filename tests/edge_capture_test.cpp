@@ -0,0 +1,192 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/edge_capture.h"
+#include <string.h>
+#include <math.h>
+}
+
+#define FAKE_BUFFER_SIZE 8
+
+// stands in for the timer input capture and its DMA channels
+typedef struct {
+    volatile uint32_t buffers[3][FAKE_BUFFER_SIZE];
+    uint32_t write_index[3];
+} fake_capture_t;
+
+static uint32_t fake_write_index(void *context, enum beacon_nb beacon)
+{
+    fake_capture_t *fake = (fake_capture_t *)context;
+    return fake->write_index[beacon];
+}
+
+static void fake_edge(fake_capture_t *fake, enum beacon_nb beacon, uint32_t time)
+{
+    fake->buffers[beacon][fake->write_index[beacon]] = time;
+    fake->write_index[beacon] = (fake->write_index[beacon] + 1) % FAKE_BUFFER_SIZE;
+}
+
+TEST_GROUP(EdgeCaptureTestGroup)
+{
+    fake_capture_t fake;
+    edge_capture_t capture;
+    beacon_angles_t angles;
+
+    void setup(void)
+    {
+        memset(&fake, 0, sizeof(fake));
+        beacon_angles_init(&angles);
+        CHECK_TRUE(edge_capture_init(&capture,
+                          fake.buffers[A], fake.buffers[B], fake.buffers[C],
+                          FAKE_BUFFER_SIZE, fake_write_index, &fake));
+    }
+};
+
+TEST(EdgeCaptureTestGroup, InitRejectsBadArguments)
+{
+    edge_capture_t other;
+
+    CHECK_FALSE(edge_capture_init(NULL,
+                fake.buffers[A], fake.buffers[B], fake.buffers[C],
+                FAKE_BUFFER_SIZE, fake_write_index, &fake));
+    CHECK_FALSE(edge_capture_init(&other,
+                fake.buffers[A], NULL, fake.buffers[C],
+                FAKE_BUFFER_SIZE, fake_write_index, &fake));
+    CHECK_FALSE(edge_capture_init(&other,
+                fake.buffers[A], fake.buffers[B], fake.buffers[C],
+                0, fake_write_index, &fake));
+    CHECK_FALSE(edge_capture_init(&other,
+                fake.buffers[A], fake.buffers[B], fake.buffers[C],
+                FAKE_BUFFER_SIZE, NULL, &fake));
+}
+
+TEST(EdgeCaptureTestGroup, SignalWakesUpWait)
+{
+    CHECK_FALSE(edge_capture_wait(&capture, 0));
+    edge_capture_signal(&capture);
+    CHECK_TRUE(edge_capture_wait(&capture, 0));
+}
+
+TEST(EdgeCaptureTestGroup, NothingToDrainAfterInit)
+{
+    CHECK_EQUAL(0, edge_capture_drain(&capture, &angles));
+    CHECK_FALSE(os_semaphore_try(&angles.measurement_ready));
+}
+
+TEST(EdgeCaptureTestGroup, SkipsEdgesCapturedBeforeInit)
+{
+    fake_edge(&fake, A, 100);
+    edge_capture_init(&capture,
+                      fake.buffers[A], fake.buffers[B], fake.buffers[C],
+                      FAKE_BUFFER_SIZE, fake_write_index, &fake);
+
+    CHECK_EQUAL(0, edge_capture_drain(&capture, &angles));
+}
+
+TEST(EdgeCaptureTestGroup, MergesBeaconsInTimeOrder)
+{
+    timestamp_event_t event;
+
+    fake_edge(&fake, C, 300);
+    fake_edge(&fake, A, 100);
+    fake_edge(&fake, B, 200);
+    fake_edge(&fake, A, 400);
+
+    CHECK_EQUAL(4, edge_capture_drain(&capture, &angles));
+
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+    CHECK_EQUAL(A, event.beacon);
+    CHECK_EQUAL(100, event.time);
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+    CHECK_EQUAL(B, event.beacon);
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+    CHECK_EQUAL(C, event.beacon);
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+    CHECK_EQUAL(A, event.beacon);
+    CHECK_EQUAL(400, event.time);
+    CHECK_FALSE(timestamp_ring_pop(&angles._ring, &event));
+
+    // already drained
+    CHECK_EQUAL(0, edge_capture_drain(&capture, &angles));
+}
+
+TEST(EdgeCaptureTestGroup, HandlesTimerWrapAround)
+{
+    timestamp_event_t event;
+
+    fake_edge(&fake, A, UINT32_MAX - 10);
+    fake_edge(&fake, B, 5);
+
+    CHECK_EQUAL(2, edge_capture_drain(&capture, &angles));
+
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+    CHECK_EQUAL(A, event.beacon);
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+    CHECK_EQUAL(B, event.beacon);
+}
+
+TEST(EdgeCaptureTestGroup, FeedsAnglePipeline)
+{
+    uint32_t period = 480000;
+    uint32_t t = UINT32_MAX - period;
+    int i;
+
+    // three rotations, wrapping around the buffers and the timer
+    for(i = 0; i < 3; i++){
+        fake_edge(&fake, B, t + period / 3);
+        fake_edge(&fake, C, t + 2 * period / 3);
+        fake_edge(&fake, A, t + period);
+        t += period;
+    }
+
+    CHECK_EQUAL(9, edge_capture_drain(&capture, &angles));
+
+    CHECK_TRUE(beacon_angles_calculate(&angles));
+    DOUBLES_EQUAL(2 * M_PI / 3, angles.alpha, 1e-4);
+    DOUBLES_EQUAL(2 * M_PI / 3, angles.beta, 1e-4);
+    DOUBLES_EQUAL(2 * M_PI / 3, angles.gamma, 1e-4);
+    CHECK_TRUE(beacon_angles_calculate(&angles));
+    CHECK_FALSE(beacon_angles_calculate(&angles));
+}
+
+// the write index is back where it was, the buffer still holds every edge
+TEST(EdgeCaptureTestGroup, FullLapIsDrainedWhole)
+{
+    timestamp_event_t event;
+    uint32_t i;
+
+    for(i = 0; i < FAKE_BUFFER_SIZE; i++){
+        fake_edge(&fake, B, 100 * (i + 1));
+    }
+
+    CHECK_EQUAL(FAKE_BUFFER_SIZE, edge_capture_drain(&capture, &angles));
+    CHECK_EQUAL(0, edge_capture_dropped(&capture));
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+    CHECK_EQUAL(100, event.time);
+
+    CHECK_EQUAL(0, edge_capture_drain(&capture, &angles));
+}
+
+TEST(EdgeCaptureTestGroup, OverrunIsCounted)
+{
+    timestamp_event_t event;
+    uint32_t i;
+
+    fake_edge(&fake, C, 50);
+    CHECK_EQUAL(1, edge_capture_drain(&capture, &angles));
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+
+    // a glitch burst, the three oldest edges are overwritten
+    for(i = 0; i < FAKE_BUFFER_SIZE + 3; i++){
+        fake_edge(&fake, C, 100 * (i + 1));
+    }
+
+    CHECK_EQUAL(FAKE_BUFFER_SIZE, edge_capture_drain(&capture, &angles));
+    CHECK_EQUAL(3, edge_capture_dropped(&capture));
+    CHECK_TRUE(timestamp_ring_pop(&angles._ring, &event));
+    CHECK_EQUAL(400, event.time);
+
+    fake_edge(&fake, C, 5000);
+    CHECK_EQUAL(1, edge_capture_drain(&capture, &angles));
+    CHECK_EQUAL(3, edge_capture_dropped(&capture));
+}
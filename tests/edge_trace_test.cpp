@@ -0,0 +1,73 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/edge_trace.h"
+}
+
+
+TEST_GROUP(EdgeTraceTestGroup)
+{
+    uint8_t buffer[EDGE_TRACE_RECORD_MAX_SIZE];
+    edge_trace_record_t record;
+    edge_trace_record_t decoded;
+};
+
+TEST(EdgeTraceTestGroup, EncodesEdge)
+{
+    record.laser = 1;
+    record.kind = EDGE_TRACE_EDGE_C;
+    record.args[0] = 0x12345678;
+
+    CHECK_EQUAL(5, edge_trace_encode(&record, buffer));
+    CHECK_EQUAL(0x12, buffer[0]);
+    CHECK_EQUAL(0x78, buffer[1]);
+    CHECK_EQUAL(0x56, buffer[2]);
+    CHECK_EQUAL(0x34, buffer[3]);
+    CHECK_EQUAL(0x12, buffer[4]);
+}
+
+TEST(EdgeTraceTestGroup, DecodesWhatItEncodes)
+{
+    record.laser = 0;
+    record.kind = EDGE_TRACE_CONFIG;
+    record.args[0] = 8000000;
+    record.args[1] = 0xfedcba98;
+
+    size_t size = edge_trace_encode(&record, buffer);
+    CHECK_EQUAL(9, size);
+
+    CHECK_EQUAL(size, edge_trace_decode(buffer, size, &decoded));
+    CHECK_EQUAL(0, decoded.laser);
+    CHECK_EQUAL(EDGE_TRACE_CONFIG, decoded.kind);
+    CHECK_EQUAL(8000000, decoded.args[0]);
+    CHECK_EQUAL(0xfedcba98, decoded.args[1]);
+}
+
+TEST(EdgeTraceTestGroup, RejectsInvalidRecord)
+{
+    record.laser = 16;
+    record.kind = EDGE_TRACE_SYNC;
+    record.args[0] = 0;
+
+    CHECK_EQUAL(0, edge_trace_encode(&record, buffer));
+
+    record.laser = 0;
+    record.kind = (edge_trace_kind_t)7;
+    CHECK_EQUAL(0, edge_trace_encode(&record, buffer));
+
+    buffer[0] = 0x07;
+    CHECK_EQUAL(0, edge_trace_decode(buffer, sizeof(buffer), &decoded));
+}
+
+TEST(EdgeTraceTestGroup, RejectsTruncatedRecord)
+{
+    record.laser = 1;
+    record.kind = EDGE_TRACE_CONFIG;
+    record.args[0] = 1000000;
+    record.args[1] = 50000;
+
+    edge_trace_encode(&record, buffer);
+
+    CHECK_EQUAL(0, edge_trace_decode(buffer, 8, &decoded));
+    CHECK_EQUAL(0, edge_trace_decode(buffer, 0, &decoded));
+}
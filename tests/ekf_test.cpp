@@ -0,0 +1,191 @@
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/ekf.h"
+#include "../src/beacon_config.h"
+}
+
+#define FLOAT_COMPARE_TOLERANCE (0.0001f)
+
+#define POINT_A_X (3.0f)
+#define POINT_A_Y (1.0f)
+
+#define POINT_B_X (0.0f)
+#define POINT_B_Y (2.0f)
+
+#define POINT_C_X (0.0f)
+#define POINT_C_Y (0.0f)
+
+static position_t p_a = {POINT_A_X, POINT_A_Y};
+static position_t p_b = {POINT_B_X, POINT_B_Y};
+static position_t p_c = {POINT_C_X, POINT_C_Y};
+static reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+
+// directed angle at p from p->first to p->second, in [0, 2 Pi)
+static float directed_angle(
+        float p_x,
+        float p_y,
+        const position_t * first,
+        const position_t * second)
+{
+    float angle = std::atan2(second->y - p_y, second->x - p_x)
+        - std::atan2(first->y - p_y, first->x - p_x);
+
+    return angle < 0 ? angle + 2 * M_PI : angle;
+}
+
+// time deltas measured by a laser turning at omega at position (x, y)
+static ekf_measurement_t deltas_at(
+        float x,
+        float y,
+        float omega,
+        const reference_triangle_t * t)
+{
+    ekf_measurement_t m;
+    m.dt_alpha = directed_angle(x, y, t->point_b, t->point_c) / omega;
+    m.dt_beta = directed_angle(x, y, t->point_c, t->point_a) / omega;
+    m.dt_gamma = directed_angle(x, y, t->point_a, t->point_b) / omega;
+
+    return m;
+}
+
+TEST_GROUP(EkfTestGroup)
+{
+    robot_pos_t init_pos;
+    ekf_robot_handle_t handle;
+
+    void setup(void)
+    {
+        positioning_reference_triangle_from_points(&p_a, &p_b, &p_c, &t);
+
+        init_pos.x = 1.5f;
+        init_pos.y = 1.0f;
+        init_pos.var_x = 1.0f;
+        init_pos.var_y = 1.0f;
+        init_pos.cov_xy = 0.0f;
+    }
+
+    void teardown(void)
+    {
+
+    }
+};
+
+TEST(EkfTestGroup, initBadInput)
+{
+    CHECK(ekf_init(NULL, &init_pos, EKF_INIT_OMEGA, &t) == 0);
+    CHECK(ekf_init(&handle, NULL, EKF_INIT_OMEGA, &t) == 0);
+    CHECK(ekf_init(&handle, &init_pos, EKF_INIT_OMEGA, NULL) == 0);
+    CHECK(ekf_init(&handle, &init_pos, 0.0f, &t) == 0);
+}
+
+TEST(EkfTestGroup, init)
+{
+    CHECK(ekf_init(&handle, &init_pos, EKF_INIT_OMEGA, &t) == 1);
+
+    DOUBLES_EQUAL(init_pos.x, handle._state[0], FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(init_pos.y, handle._state[1], FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(0.0f, handle._state[2], FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(0.0f, handle._state[3], FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(EKF_INIT_OMEGA, handle._state[4], FLOAT_COMPARE_TOLERANCE);
+
+    DOUBLES_EQUAL(init_pos.var_x, handle._state_covariance[0][0], FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(init_pos.var_y, handle._state_covariance[1][1], FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(EKF_INIT_OMEGA_VAR, handle._state_covariance[4][4], FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(0.0f, handle._state_covariance[0][4], FLOAT_COMPARE_TOLERANCE);
+}
+
+TEST(EkfTestGroup, updateBadInput)
+{
+    ekf_init(&handle, &init_pos, EKF_INIT_OMEGA, &t);
+    ekf_measurement_t meas = deltas_at(1.0f, 1.0f, EKF_INIT_OMEGA, &t);
+    robot_pos_t dest;
+
+    CHECK(ekf_update(NULL, &meas, 0.1f, &dest) == 0);
+    CHECK(ekf_update(&handle, &meas, 0.1f, NULL) == 0);
+    CHECK(ekf_update(&handle, &meas, -0.1f, &dest) == 0);
+    CHECK(ekf_update(&handle, NULL, 0.1f, &dest) == 1);
+}
+
+TEST(EkfTestGroup, predictionOnlyGrowsCovariance)
+{
+    ekf_init(&handle, &init_pos, EKF_INIT_OMEGA, &t);
+    robot_pos_t dest;
+
+    ekf_update(&handle, NULL, 0.1f, &dest);
+
+    DOUBLES_EQUAL(init_pos.x, dest.x, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(init_pos.y, dest.y, FLOAT_COMPARE_TOLERANCE);
+    CHECK(dest.var_x > init_pos.var_x);
+    CHECK(dest.var_y > init_pos.var_y);
+}
+
+TEST(EkfTestGroup, convergesToPositionAndOmega)
+{
+    float true_x = 1.0f;
+    float true_y = 0.5f;
+    float true_omega = 2.0f * M_PI * 8.0f;
+
+    ekf_init(&handle, &init_pos, EKF_INIT_OMEGA, &t);
+    ekf_measurement_t meas = deltas_at(true_x, true_y, true_omega, &t);
+    robot_pos_t dest;
+
+    int i;
+    for(i = 0; i < 50; i++) {
+        CHECK(ekf_update(&handle, &meas, 2.0f * M_PI / true_omega, &dest));
+    }
+
+    float omega;
+    CHECK(ekf_get_omega(&handle, &omega));
+
+    DOUBLES_EQUAL(true_x, dest.x, 0.01);
+    DOUBLES_EQUAL(true_y, dest.y, 0.01);
+    DOUBLES_EQUAL(true_omega, omega, 0.01 * true_omega);
+    CHECK(dest.var_x < 0.01f * 0.01f);
+    CHECK(dest.var_y < 0.01f * 0.01f);
+}
+
+TEST(EkfTestGroup, keepsUpdatingOnCircumcircle)
+{
+    // circumcircle of the reference triangle
+    float center_x = 4.0f / 3.0f;
+    float center_y = 1.0f;
+    float radius = 5.0f / 3.0f;
+
+    float true_x = center_x + radius * std::cos(M_PI / 6);
+    float true_y = center_y + radius * std::sin(M_PI / 6);
+    float omega = EKF_INIT_OMEGA;
+
+    ekf_measurement_t meas = deltas_at(true_x, true_y, omega, &t);
+
+    // triangulation can't be trusted here
+    position_t triangulated = {0, 0};
+    CHECK(!positioning_from_angles(
+                meas.dt_alpha * omega,
+                meas.dt_beta * omega,
+                meas.dt_gamma * omega,
+                &t,
+                &triangulated));
+
+    // start 10cm off the circle
+    init_pos.x = center_x + (radius + 0.1f) * std::cos(M_PI / 6);
+    init_pos.y = center_y + (radius + 0.1f) * std::sin(M_PI / 6);
+    init_pos.var_x = 0.1f * 0.1f;
+    init_pos.var_y = 0.1f * 0.1f;
+    ekf_init(&handle, &init_pos, omega, &t);
+
+    robot_pos_t dest;
+    int i;
+    for(i = 0; i < 50; i++) {
+        CHECK(ekf_update(&handle, &meas, 2.0f * M_PI / omega, &dest));
+    }
+
+    // the distance to the circle is observable even though the position
+    // along the circle isn't
+    float dist = std::sqrt(
+            (dest.x - center_x) * (dest.x - center_x) +
+            (dest.y - center_y) * (dest.y - center_y));
+    DOUBLES_EQUAL(radius, dist, 0.01);
+}
@@ -0,0 +1,68 @@
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/fixed_point.h"
+}
+
+TEST_GROUP(FixedPoint)
+{
+    void setup(void)
+    {
+
+    }
+
+    void teardown(void)
+    {
+
+    }
+};
+
+TEST(FixedPoint, mul)
+{
+    q8_24_t a = Q8_24_FROM_FLOAT(1.5f);
+    q8_24_t b = Q8_24_FROM_FLOAT(-0.25f);
+
+    CHECK_EQUAL(Q8_24_FROM_FLOAT(-0.375f), q8_24_mul(a, b));
+    CHECK_EQUAL(1 << 29, q31_mul(1 << 30, 1 << 30));
+}
+
+TEST(FixedPoint, ratio)
+{
+    // same fractional bits on both sides, the result is in q8_24
+    CHECK_EQUAL(Q8_24_FROM_FLOAT(0.5f), q8_24_ratio(1, 2));
+    CHECK_EQUAL(Q8_24_FROM_FLOAT(-3.0f), q8_24_ratio(-3000000, 1000000));
+
+    // numerator too big to be shifted by 24 bits directly
+    int64_t big = (int64_t)1 << 50;
+    CHECK_EQUAL(Q8_24_FROM_FLOAT(0.25f), q8_24_ratio(big, 4 * big));
+    CHECK_EQUAL(Q8_24_FROM_FLOAT(100.0f), q8_24_ratio(100 * big, big));
+
+    CHECK_EQUAL(0, q8_24_ratio(1, 0));
+}
+
+TEST(FixedPoint, sinCos)
+{
+    int i;
+    for(i = 0; i < 1000; i++) {
+        double angle = 2 * M_PI * i / 1000.0;
+        angle_q_t a = (angle_q_t)((uint64_t)i * 4294967296ULL / 1000);
+
+        DOUBLES_EQUAL(std::sin(angle), Q31_TO_FLOAT(q31_sin(a)), 1e-5);
+        DOUBLES_EQUAL(std::cos(angle), Q31_TO_FLOAT(q31_cos(a)), 1e-5);
+    }
+
+    CHECK_EQUAL(0, q31_sin(0));
+    CHECK_EQUAL(Q31_ONE, q31_sin(0x40000000));
+    CHECK_EQUAL(-Q31_ONE, q31_sin(0xC0000000));
+}
+
+TEST(FixedPoint, isqrt)
+{
+    CHECK_EQUAL(0, fixed_isqrt64(0));
+    CHECK_EQUAL(1, fixed_isqrt64(3));
+    CHECK_EQUAL(2, fixed_isqrt64(4));
+    CHECK_EQUAL(1 << 24, fixed_isqrt64((uint64_t)1 << 48));
+    CHECK_EQUAL(0xFFFFFFFF, fixed_isqrt64(0xFFFFFFFFFFFFFFFFULL));
+}
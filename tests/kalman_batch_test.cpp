@@ -0,0 +1,180 @@
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/kalman_batch.h"
+#include "../src/beacon_config.h"
+}
+
+#define NB_TRACKS (37)
+
+TEST_GROUP(KalmanBatch)
+{
+    kalman_batch_t batch;
+    kalman_batch_block_t storage[KALMAN_BATCH_NB_BLOCKS(NB_TRACKS)];
+    robot_pos_t init_pos[NB_TRACKS];
+
+    void setup(void)
+    {
+        int i;
+        for(i = 0; i < NB_TRACKS; i++) {
+            init_pos[i].x = 0.1f * i;
+            init_pos[i].y = 2.0f - 0.1f * i;
+            init_pos[i].var_x = 1.0f;
+            init_pos[i].var_y = 0.5f;
+            init_pos[i].cov_xy = 0.1f;
+        }
+    }
+
+    void teardown(void)
+    {
+
+    }
+};
+
+TEST(KalmanBatch, initBadInput)
+{
+    CHECK(!kalman_batch_init(NULL, storage, NB_TRACKS, init_pos));
+    CHECK(!kalman_batch_init(&batch, NULL, NB_TRACKS, init_pos));
+    CHECK(!kalman_batch_init(&batch, storage, 0, init_pos));
+    CHECK(!kalman_batch_init(&batch, storage, NB_TRACKS, NULL));
+}
+
+TEST(KalmanBatch, updateBadInput)
+{
+    float meas[NB_TRACKS] = {0};
+    kalman_batch_init(&batch, storage, NB_TRACKS, init_pos);
+
+    CHECK(!kalman_batch_update(NULL, meas, meas, NULL, 0.1f));
+    CHECK(!kalman_batch_update(&batch, NULL, meas, NULL, 0.1f));
+    CHECK(!kalman_batch_update(&batch, meas, NULL, NULL, 0.1f));
+    CHECK(!kalman_batch_update(&batch, meas, meas, NULL, -0.1f));
+}
+
+TEST(KalmanBatch, getBadInput)
+{
+    robot_pos_t dest;
+    kalman_batch_init(&batch, storage, NB_TRACKS, init_pos);
+
+    CHECK(!kalman_batch_get(NULL, 0, &dest));
+    CHECK(!kalman_batch_get(&batch, 0, NULL));
+    CHECK(!kalman_batch_get(&batch, NB_TRACKS, &dest));
+}
+
+TEST(KalmanBatch, init)
+{
+    CHECK(kalman_batch_init(&batch, storage, NB_TRACKS, init_pos));
+
+    int i;
+    for(i = 0; i < NB_TRACKS; i++) {
+        robot_pos_t dest;
+        CHECK(kalman_batch_get(&batch, i, &dest));
+        DOUBLES_EQUAL(init_pos[i].x, dest.x, 0.0);
+        DOUBLES_EQUAL(init_pos[i].y, dest.y, 0.0);
+        DOUBLES_EQUAL(init_pos[i].var_x, dest.var_x, 0.0);
+        DOUBLES_EQUAL(init_pos[i].var_y, dest.var_y, 0.0);
+        DOUBLES_EQUAL(init_pos[i].cov_xy, dest.cov_xy, 0.0);
+    }
+}
+
+TEST(KalmanBatch, matchesKalmanUpdate)
+{
+    kalman_robot_handle_t handles[NB_TRACKS];
+    float meas_x[NB_TRACKS];
+    float meas_y[NB_TRACKS];
+    uint8_t meas_valid[NB_TRACKS];
+
+    kalman_batch_init(&batch, storage, NB_TRACKS, init_pos);
+    kalman_batch_update_measurement_covariance(&batch, 0.01f, 0.02f, 0.005f);
+
+    int i;
+    for(i = 0; i < NB_TRACKS; i++) {
+        kalman_init(&handles[i], &init_pos[i]);
+        kalman_update_measurement_covariance(&handles[i], 0.01f, 0.02f, 0.005f);
+    }
+
+    int step;
+    for(step = 0; step < 200; step++) {
+        float t = step * 0.02f;
+        for(i = 0; i < NB_TRACKS; i++) {
+            meas_x[i] = 1.5f + std::sin(t + i);
+            meas_y[i] = 1.0f + 0.5f * std::cos(2 * t - i);
+            meas_valid[i] = (step + i) % 4 != 0;
+        }
+
+        CHECK(kalman_batch_update(&batch, meas_x, meas_y, meas_valid, 0.02f));
+
+        for(i = 0; i < NB_TRACKS; i++) {
+            position_t meas = {meas_x[i], meas_y[i]};
+            robot_pos_t expected;
+            robot_pos_t result;
+            kalman_update(
+                    &handles[i],
+                    meas_valid[i] ? &meas : NULL,
+                    0.02f,
+                    &expected);
+            kalman_batch_get(&batch, i, &result);
+
+            DOUBLES_EQUAL(expected.x, result.x, 1e-5);
+            DOUBLES_EQUAL(expected.y, result.y, 1e-5);
+            DOUBLES_EQUAL(expected.var_x, result.var_x, 1e-6);
+            DOUBLES_EQUAL(expected.var_y, result.var_y, 1e-6);
+            DOUBLES_EQUAL(expected.cov_xy, result.cov_xy, 1e-6);
+        }
+    }
+}
+
+TEST(KalmanBatch, allValidWhenMaskNULL)
+{
+    float meas_x[NB_TRACKS];
+    float meas_y[NB_TRACKS];
+    kalman_batch_init(&batch, storage, NB_TRACKS, init_pos);
+
+    int i;
+    for(i = 0; i < NB_TRACKS; i++) {
+        meas_x[i] = init_pos[i].x + 0.1f;
+        meas_y[i] = init_pos[i].y + 0.1f;
+    }
+
+    kalman_batch_update(&batch, meas_x, meas_y, NULL, 0.02f);
+
+    for(i = 0; i < NB_TRACKS; i++) {
+        robot_pos_t dest;
+        kalman_batch_get(&batch, i, &dest);
+        CHECK(dest.x > init_pos[i].x);
+        CHECK(dest.var_x < init_pos[i].var_x);
+    }
+}
+
+// positioning_from_angles_batch leaves NaN in the entries it rejects
+TEST(KalmanBatch, invalidNaNMeasurementsAreIgnored)
+{
+    float meas_x[NB_TRACKS];
+    float meas_y[NB_TRACKS];
+    uint8_t meas_valid[NB_TRACKS];
+    kalman_batch_init(&batch, storage, NB_TRACKS, init_pos);
+
+    int i;
+    for(i = 0; i < NB_TRACKS; i++) {
+        meas_valid[i] = i % 2;
+        meas_x[i] = meas_valid[i] ? init_pos[i].x + 0.1f : NAN;
+        meas_y[i] = meas_valid[i] ? init_pos[i].y + 0.1f : INFINITY;
+    }
+
+    CHECK(kalman_batch_update(&batch, meas_x, meas_y, meas_valid, 0.02f));
+
+    for(i = 0; i < NB_TRACKS; i++) {
+        robot_pos_t dest;
+        kalman_batch_get(&batch, i, &dest);
+        CHECK(std::isfinite(dest.x));
+        CHECK(std::isfinite(dest.y));
+        CHECK(std::isfinite(dest.var_x));
+        if(meas_valid[i]) {
+            CHECK(dest.x > init_pos[i].x);
+        } else {
+            DOUBLES_EQUAL(init_pos[i].x, dest.x, 0.0);
+            DOUBLES_EQUAL(init_pos[i].y, dest.y, 0.0);
+        }
+    }
+}
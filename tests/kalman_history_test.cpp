@@ -0,0 +1,142 @@
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/kalman_history.h"
+#include "../src/beacon_config.h"
+}
+
+#define FLOAT_COMPARE_TOLERANCE (0.0001f)
+
+static position_t meas_1 = {1.0f, 1.0f};
+static position_t meas_2 = {1.1f, 1.05f};
+static position_t meas_3 = {1.2f, 1.1f};
+
+TEST_GROUP(KalmanHistory)
+{
+    kalman_robot_handle_t filter;
+    kalman_robot_handle_t reference;
+    kalman_history_t history;
+    robot_pos_t dest;
+    robot_pos_t ref_dest;
+
+    void setup(void)
+    {
+        robot_pos_t init_pos = {1.0f, 1.0f, 1.0f, 1.0f, 0.0f};
+
+        kalman_init(&filter, &init_pos);
+        kalman_init(&reference, &init_pos);
+        kalman_history_init(&history, &filter, 1000);
+    }
+
+    void teardown(void)
+    {
+
+    }
+
+    void check_matches_reference(void)
+    {
+        DOUBLES_EQUAL(ref_dest.x, dest.x, FLOAT_COMPARE_TOLERANCE);
+        DOUBLES_EQUAL(ref_dest.y, dest.y, FLOAT_COMPARE_TOLERANCE);
+        DOUBLES_EQUAL(ref_dest.var_x, dest.var_x, FLOAT_COMPARE_TOLERANCE);
+        DOUBLES_EQUAL(ref_dest.var_y, dest.var_y, FLOAT_COMPARE_TOLERANCE);
+        DOUBLES_EQUAL(ref_dest.cov_xy, dest.cov_xy, FLOAT_COMPARE_TOLERANCE);
+    }
+};
+
+TEST(KalmanHistory, badInput)
+{
+    CHECK(!kalman_history_init(NULL, &filter, 0));
+    CHECK(!kalman_history_init(&history, NULL, 0));
+    CHECK(!kalman_history_update(NULL, &meas_1, 2000, &dest));
+    CHECK(!kalman_history_update(&history, &meas_1, 2000, NULL));
+}
+
+TEST(KalmanHistory, inOrderMatchesKalmanUpdate)
+{
+    CHECK(kalman_history_update(&history, &meas_1, 21000, &dest));
+    CHECK(kalman_history_update(&history, NULL, 41000, &dest));
+    CHECK(kalman_history_update(&history, &meas_2, 51000, &dest));
+
+    kalman_update(&reference, &meas_1, 0.02f, &ref_dest);
+    kalman_update(&reference, NULL, 0.02f, &ref_dest);
+    kalman_update(&reference, &meas_2, 0.01f, &ref_dest);
+
+    check_matches_reference();
+}
+
+TEST(KalmanHistory, lateMeasurementIsReplayedInOrder)
+{
+    CHECK(kalman_history_update(&history, &meas_1, 21000, &dest));
+    CHECK(kalman_history_update(&history, &meas_3, 61000, &dest));
+    // arrives last but was taken between the others
+    CHECK(kalman_history_update(&history, &meas_2, 41000, &dest));
+
+    kalman_update(&reference, &meas_1, 0.02f, &ref_dest);
+    kalman_update(&reference, &meas_2, 0.02f, &ref_dest);
+    kalman_update(&reference, &meas_3, 0.02f, &ref_dest);
+
+    check_matches_reference();
+}
+
+TEST(KalmanHistory, lateMeasurementKeepsCovarianceOfEachStep)
+{
+    position_covariance_t cov_1 = {0.01f * 0.01f, 0.02f * 0.02f, 0.0f};
+    position_covariance_t cov_3 = {0.5f * 0.5f, 0.5f * 0.5f, 0.1f};
+
+    CHECK(kalman_history_update_with_covariance(
+                &history, &meas_1, &cov_1, 21000, &dest));
+    CHECK(kalman_history_update_with_covariance(
+                &history, &meas_3, &cov_3, 61000, &dest));
+    // replays the steps with their own covariance
+    CHECK(kalman_history_update(&history, &meas_2, 41000, &dest));
+
+    kalman_update_with_covariance(&reference, &meas_1, &cov_1, 0.02f, &ref_dest);
+    kalman_update(&reference, &meas_2, 0.02f, &ref_dest);
+    kalman_update_with_covariance(&reference, &meas_3, &cov_3, 0.02f, &ref_dest);
+
+    check_matches_reference();
+}
+
+TEST(KalmanHistory, timesWrapAround)
+{
+    kalman_history_init(&history, &filter, UINT32_MAX - 9999);
+
+    CHECK(kalman_history_update(&history, &meas_1, 10000, &dest));
+    CHECK(kalman_history_update(&history, &meas_2, UINT32_MAX - 4999, &dest));
+
+    kalman_update(&reference, &meas_2, 0.005f, &ref_dest);
+    kalman_update(&reference, &meas_1, 0.015f, &ref_dest);
+
+    check_matches_reference();
+}
+
+TEST(KalmanHistory, rejectsMeasurementOlderThanHistory)
+{
+    kalman_history_t ref_history;
+    int i;
+
+    kalman_history_init(&ref_history, &reference, 1000);
+
+    CHECK(!kalman_history_update(&history, &meas_1, 500, &dest));
+
+    for(i = 1; i <= KALMAN_HISTORY_SIZE + 1; i++) {
+        position_t * meas = i % 2 ? &meas_2 : &meas_3;
+        CHECK(kalman_history_update(&history, meas, 1000 + i * 20000, &dest));
+        CHECK(kalman_history_update(&ref_history, meas, 1000 + i * 20000,
+                    &ref_dest));
+    }
+
+    // the first steps were forgotten, the rejected fix leaves the filter
+    // as it was
+    CHECK(!kalman_history_update(&history, &meas_1, 1000 + 30000, &dest));
+    CHECK(kalman_history_update(&history, NULL,
+                1000 + (KALMAN_HISTORY_SIZE + 2) * 20000, &dest));
+    CHECK(kalman_history_update(&ref_history, NULL,
+                1000 + (KALMAN_HISTORY_SIZE + 2) * 20000, &ref_dest));
+    check_matches_reference();
+
+    CHECK(kalman_history_update(&history, &meas_1,
+                1000 + (KALMAN_HISTORY_SIZE - 1) * 20000, &dest));
+}
@@ -0,0 +1,104 @@
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/kalman_q.h"
+#include "../src/kalman.h"
+#include "../src/beacon_config.h"
+}
+
+TEST_GROUP(KalmanQ)
+{
+    robot_pos_t init_pos;
+    robot_pos_q_t init_pos_q;
+    kalman_q_robot_handle_t handle;
+
+    void setup(void)
+    {
+        init_pos.x = 1.0f;
+        init_pos.y = 0.5f;
+        init_pos.var_x = 1.0f;
+        init_pos.var_y = 0.5f;
+        init_pos.cov_xy = 0.1f;
+
+        init_pos_q.x = Q8_24_FROM_FLOAT(init_pos.x);
+        init_pos_q.y = Q8_24_FROM_FLOAT(init_pos.y);
+        init_pos_q.var_x = Q8_24_FROM_FLOAT(init_pos.var_x);
+        init_pos_q.var_y = Q8_24_FROM_FLOAT(init_pos.var_y);
+        init_pos_q.cov_xy = Q8_24_FROM_FLOAT(init_pos.cov_xy);
+
+        kalman_q_init(&handle, &init_pos_q);
+    }
+
+    void teardown(void)
+    {
+
+    }
+};
+
+TEST(KalmanQ, badInput)
+{
+    robot_pos_q_t dest;
+
+    CHECK(!kalman_q_init(NULL, &init_pos_q));
+    CHECK(!kalman_q_init(&handle, NULL));
+    CHECK(!kalman_q_update(NULL, NULL, Q8_24_ONE, &dest));
+    CHECK(!kalman_q_update(&handle, NULL, Q8_24_ONE, NULL));
+    CHECK(!kalman_q_update(&handle, NULL, -1, &dest));
+    CHECK(!kalman_q_update_measurement_covariance(NULL, 0, 0, 0));
+}
+
+TEST(KalmanQ, init)
+{
+    robot_pos_q_t dest;
+
+    CHECK(kalman_q_update(&handle, NULL, 0, &dest));
+
+    CHECK_EQUAL(init_pos_q.x, dest.x);
+    CHECK_EQUAL(init_pos_q.y, dest.y);
+    CHECK_EQUAL(init_pos_q.var_x, dest.var_x);
+    CHECK_EQUAL(init_pos_q.var_y, dest.var_y);
+    CHECK_EQUAL(init_pos_q.cov_xy, dest.cov_xy);
+}
+
+TEST(KalmanQ, matchesFloatVersion)
+{
+    kalman_robot_handle_t reference;
+    kalman_init(&reference, &init_pos);
+    kalman_update_measurement_covariance(&reference, 0.01f, 0.02f, 0.005f);
+    kalman_q_update_measurement_covariance(
+            &handle,
+            Q8_24_FROM_FLOAT(0.01f),
+            Q8_24_FROM_FLOAT(0.02f),
+            Q8_24_FROM_FLOAT(0.005f));
+
+    // robot moving along a curve, every third measurement is missing
+    int i;
+    for(i = 0; i < 500; i++) {
+        float t = i * 0.02f;
+        float x = 1.5f + std::sin(t);
+        float y = 1.0f + 0.5f * std::cos(2 * t);
+        position_t meas = {x, y};
+        position_q_t meas_q = {Q8_24_FROM_FLOAT(x), Q8_24_FROM_FLOAT(y)};
+
+        robot_pos_t expected;
+        robot_pos_q_t dest;
+        kalman_update(&reference, (i % 3 == 0) ? NULL : &meas, 0.02f, &expected);
+        kalman_q_update(
+                &handle,
+                (i % 3 == 0) ? NULL : &meas_q,
+                Q8_24_FROM_FLOAT(0.02f),
+                &dest);
+
+        // rounding errors of the velocity add up, 1mm is plenty compared
+        // to the measurement noise
+        DOUBLES_EQUAL(expected.x, Q8_24_TO_FLOAT(dest.x), 1e-3);
+        DOUBLES_EQUAL(expected.y, Q8_24_TO_FLOAT(dest.y), 1e-3);
+        DOUBLES_EQUAL(expected.var_x, Q8_24_TO_FLOAT(dest.var_x),
+                1e-6 + 1e-2 * expected.var_x);
+        DOUBLES_EQUAL(expected.var_y, Q8_24_TO_FLOAT(dest.var_y),
+                1e-6 + 1e-2 * expected.var_y);
+        DOUBLES_EQUAL(expected.cov_xy, Q8_24_TO_FLOAT(dest.cov_xy), 1e-6);
+    }
+}
@@ -1,4 +1,6 @@
 
+#include <cmath>
+
 #include "CppUTest/TestHarness.h"
 
 extern "C" {
@@ -200,26 +202,19 @@ TEST(KalmanInitializationTestGroup, kalman_init)
     DOUBLES_EQUAL(0.0f, handle._state._v_y, FLOAT_COMPARE_TOLERANCE);
 
     // test initialized covariance matrix
-    matrix2d_t to_test = handle._state_covariance._cov_a;
-    DOUBLES_EQUAL(init_pos.var_x, to_test._a, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(init_pos.var_y, to_test._d, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(init_pos.cov_xy, to_test._b, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(init_pos.cov_xy, to_test._c, FLOAT_COMPARE_TOLERANCE);
-    to_test = handle._state_covariance._cov_b;
-    DOUBLES_EQUAL(0.0f, to_test._a, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(0.0f, to_test._b, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(0.0f, to_test._c, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(0.0f, to_test._d, FLOAT_COMPARE_TOLERANCE);
-    to_test = handle._state_covariance._cov_c;
-    DOUBLES_EQUAL(0.0f, to_test._a, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(0.0f, to_test._b, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(0.0f, to_test._c, FLOAT_COMPARE_TOLERANCE);
-    DOUBLES_EQUAL(0.0f, to_test._d, FLOAT_COMPARE_TOLERANCE);
-    to_test = handle._state_covariance._cov_d;
+    sym_matrix2d_t cov_a = handle._state_covariance._cov_a;
+    DOUBLES_EQUAL(init_pos.var_x, cov_a._a, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(init_pos.var_y, cov_a._d, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(init_pos.cov_xy, cov_a._b, FLOAT_COMPARE_TOLERANCE);
+    matrix2d_t to_test = handle._state_covariance._cov_b;
     DOUBLES_EQUAL(0.0f, to_test._a, FLOAT_COMPARE_TOLERANCE);
     DOUBLES_EQUAL(0.0f, to_test._b, FLOAT_COMPARE_TOLERANCE);
     DOUBLES_EQUAL(0.0f, to_test._c, FLOAT_COMPARE_TOLERANCE);
     DOUBLES_EQUAL(0.0f, to_test._d, FLOAT_COMPARE_TOLERANCE);
+    sym_matrix2d_t cov_d = handle._state_covariance._cov_d;
+    DOUBLES_EQUAL(0.0f, cov_d._a, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(0.0f, cov_d._b, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(0.0f, cov_d._d, FLOAT_COMPARE_TOLERANCE);
 
     // test initialized measurement covariance
     to_test = handle._measurement_covariance;
@@ -362,6 +357,158 @@ TEST(KalmanUpdate, noTime2)
     DOUBLES_EQUAL(one_third, dest.cov_xy, FLOAT_COMPARE_TOLERANCE);
 }
 
+// one step of the textbook filter on the full 4x4 covariance, state
+// (x, y, v_x, v_y), F = | I dt*I |, H = | I 0 |
+//                       | 0 I    |
+static void dense_kalman_step(
+        double p[4][4],
+        const double r[2][2],
+        double q_base,
+        double dt)
+{
+    int i, j, k;
+    double f[4][4] = {{1, 0, dt, 0}, {0, 1, 0, dt}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+    double fp[4][4], pred[4][4];
+
+    for(i = 0; i < 4; i++) {
+        for(j = 0; j < 4; j++) {
+            fp[i][j] = 0;
+            for(k = 0; k < 4; k++) {
+                fp[i][j] += f[i][k] * p[k][j];
+            }
+        }
+    }
+    for(i = 0; i < 4; i++) {
+        for(j = 0; j < 4; j++) {
+            pred[i][j] = 0;
+            for(k = 0; k < 4; k++) {
+                pred[i][j] += fp[i][k] * f[j][k];
+            }
+        }
+    }
+    for(i = 0; i < 2; i++) {
+        pred[i][i] += 0.25 * dt * dt * dt * dt * q_base;
+        pred[i][i + 2] += 0.5 * dt * dt * dt * q_base;
+        pred[i + 2][i] += 0.5 * dt * dt * dt * q_base;
+        pred[i + 2][i + 2] += dt * dt * q_base;
+    }
+
+    // K = P*H^T*(H*P*H^T + R)^-1, P = P - K*H*P
+    double s_a = pred[0][0] + r[0][0];
+    double s_b = pred[0][1] + r[0][1];
+    double s_d = pred[1][1] + r[1][1];
+    double det = s_a * s_d - s_b * s_b;
+    double s_inv[2][2] = {{s_d / det, -s_b / det}, {-s_b / det, s_a / det}};
+    double gain[4][2];
+    for(i = 0; i < 4; i++) {
+        for(j = 0; j < 2; j++) {
+            gain[i][j] = pred[i][0] * s_inv[0][j] + pred[i][1] * s_inv[1][j];
+        }
+    }
+    for(i = 0; i < 4; i++) {
+        for(j = 0; j < 4; j++) {
+            p[i][j] = pred[i][j] - gain[i][0] * pred[0][j] - gain[i][1] * pred[1][j];
+        }
+    }
+}
+
+TEST(KalmanUpdate, matchesDenseCovariance)
+{
+    double p[4][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
+    double r[2][2] = {{0.01, 0.005}, {0.005, 0.02}};
+    kalman_update_measurement_covariance(&handle, 0.01f, 0.02f, 0.005f);
+
+    position_t meas = {0.1f, 0.1f};
+    robot_pos_t dest;
+    int i;
+    for(i = 0; i < 20; i++) {
+        kalman_update(&handle, &meas, 0.1f, &dest);
+        dense_kalman_step(p, r, PROC_NOISE_PROP * MAX_ACC, 0.1);
+    }
+
+    const covariance_t * cov = &handle._state_covariance;
+    DOUBLES_EQUAL(p[0][0], cov->_cov_a._a, 1e-5);
+    DOUBLES_EQUAL(p[0][1], cov->_cov_a._b, 1e-5);
+    DOUBLES_EQUAL(p[1][1], cov->_cov_a._d, 1e-5);
+    DOUBLES_EQUAL(p[0][2], cov->_cov_b._a, 1e-5);
+    DOUBLES_EQUAL(p[0][3], cov->_cov_b._b, 1e-5);
+    DOUBLES_EQUAL(p[1][2], cov->_cov_b._c, 1e-5);
+    DOUBLES_EQUAL(p[1][3], cov->_cov_b._d, 1e-5);
+    DOUBLES_EQUAL(p[2][2], cov->_cov_d._a, 1e-5);
+    DOUBLES_EQUAL(p[2][3], cov->_cov_d._b, 1e-5);
+    DOUBLES_EQUAL(p[3][3], cov->_cov_d._d, 1e-5);
+}
+
+TEST(KalmanUpdate, smallCovariances)
+{
+    // the default measurement covariance, an innovation covariance with a
+    // determinant around 1e-5 must still be inverted
+    kalman_update_measurement_covariance(
+            &handle,
+            MEAS_VAR_X,
+            MEAS_VAR_Y,
+            MEAS_COV_XY);
+
+    position_t meas = {init_pos.x + 0.1f, init_pos.y + 0.1f};
+    robot_pos_t dest;
+
+    int i;
+    for(i = 0; i < 100; i++) {
+        kalman_update(&handle, &meas, 0.02f, &dest);
+        // posterior variance can't exceed the measurement variance
+        CHECK(dest.var_x <= MEAS_VAR_X);
+        CHECK(dest.var_y <= MEAS_VAR_Y);
+    }
+
+    DOUBLES_EQUAL(meas.x, dest.x, 0.001);
+    DOUBLES_EQUAL(meas.y, dest.y, 0.001);
+}
+
+TEST(KalmanUpdate, covarianceOfMeasurementMatchesHandleCovariance)
+{
+    kalman_robot_handle_t reference;
+    position_covariance_t cov = {0.2f, 0.3f, 0.1f};
+    position_t meas = {init_pos.x + 0.1f, init_pos.y - 0.2f};
+    robot_pos_t dest, ref_dest;
+
+    kalman_init(&reference, &init_pos);
+    kalman_update_measurement_covariance(&reference, 0.2f, 0.3f, 0.1f);
+
+    CHECK(kalman_update_with_covariance(&handle, &meas, &cov, 0.02f, &dest));
+    kalman_update(&reference, &meas, 0.02f, &ref_dest);
+
+    DOUBLES_EQUAL(ref_dest.x, dest.x, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(ref_dest.y, dest.y, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(ref_dest.var_x, dest.var_x, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(ref_dest.var_y, dest.var_y, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(ref_dest.cov_xy, dest.cov_xy, FLOAT_COMPARE_TOLERANCE);
+
+    // the covariance of the handle is left as it was
+    kalman_update(&handle, &meas, 0.02f, &dest);
+    kalman_update_measurement_covariance(&reference, MEAS_VAR_X, MEAS_VAR_Y,
+            MEAS_COV_XY);
+    kalman_update(&reference, &meas, 0.02f, &ref_dest);
+    DOUBLES_EQUAL(ref_dest.var_x, dest.var_x, FLOAT_COMPARE_TOLERANCE);
+}
+
+TEST(KalmanUpdate, preciseMeasurementWeighsMore)
+{
+    kalman_robot_handle_t other;
+    position_covariance_t precise = {0.001f, 0.001f, 0.0f};
+    position_covariance_t poor = {10.0f, 10.0f, 0.0f};
+    position_t meas = {init_pos.x + 1.0f, init_pos.y + 1.0f};
+    robot_pos_t dest_precise, dest_poor;
+
+    kalman_init(&other, &init_pos);
+    kalman_update_with_covariance(&handle, &meas, &precise, 0.02f,
+            &dest_precise);
+    kalman_update_with_covariance(&other, &meas, &poor, 0.02f, &dest_poor);
+
+    CHECK(dest_precise.x > 0.99f);
+    CHECK(dest_poor.x < 0.1f);
+    CHECK(dest_precise.var_x < dest_poor.var_x);
+}
+
 TEST_GROUP(KalmanSetMaxAcc)
 {
 
@@ -505,3 +652,484 @@ TEST(KalmanSetProcNoiseProp, normalBehaviour)
             new_prop,
             FLOAT_COMPARE_TOLERANCE);
 }
+
+TEST_GROUP(KalmanSequentialUpdate)
+{
+    robot_pos_t init_pos;
+    kalman_robot_handle_t handle;
+
+    void setup(void)
+    {
+        init_pos.x = 0.0f;
+        init_pos.y = 0.0f;
+        init_pos.var_x = 1.0f;
+        init_pos.var_y = 1.0f;
+        init_pos.cov_xy = 0.0f;
+
+        kalman_init(&handle, &init_pos);
+        kalman_set_update_mode(&handle, KALMAN_UPDATE_SEQUENTIAL);
+    }
+
+    void teardown(void)
+    {
+
+    }
+};
+
+TEST(KalmanSequentialUpdate, setModeBadInput)
+{
+    CHECK(!kalman_set_update_mode(NULL, KALMAN_UPDATE_SEQUENTIAL));
+    CHECK(!kalman_set_update_mode(&handle, (kalman_update_mode_t)42));
+    CHECK(handle._update_mode == KALMAN_UPDATE_SEQUENTIAL);
+}
+
+TEST(KalmanSequentialUpdate, defaultIsJoint)
+{
+    kalman_robot_handle_t other;
+    kalman_init(&other, &init_pos);
+    CHECK(other._update_mode == KALMAN_UPDATE_JOINT);
+}
+
+TEST(KalmanSequentialUpdate, identity)
+{
+    kalman_update_measurement_covariance(&handle, 0.0f, 0.0f, 0.0f);
+    position_t meas = {init_pos.x, init_pos.y};
+    robot_pos_t dest;
+
+    CHECK(kalman_update(&handle, &meas, 0.0f, &dest));
+
+    DOUBLES_EQUAL(init_pos.x, dest.x, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(init_pos.y, dest.y, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(0.0f, dest.var_x, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(0.0f, dest.var_y, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(0.0f, dest.cov_xy, FLOAT_COMPARE_TOLERANCE);
+}
+
+TEST(KalmanSequentialUpdate, correlatedNoise)
+{
+    // same as KalmanUpdate.noTime2, the measurement noise is singular
+    kalman_update_measurement_covariance(&handle, 1.0f, 1.0f, 1.0f);
+    position_t meas = {init_pos.x + 0.1f, init_pos.y + 0.1f};
+    robot_pos_t dest;
+
+    kalman_update(&handle, &meas, 0.0f, &dest);
+
+    float one_over_thirty = (1.0f)/(30.0f);
+    DOUBLES_EQUAL(init_pos.x + one_over_thirty, dest.x, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(init_pos.y + one_over_thirty, dest.y, FLOAT_COMPARE_TOLERANCE);
+    float one_third = (1.0f)/(3.0f);
+    DOUBLES_EQUAL(one_third, dest.var_x, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(one_third, dest.var_y, FLOAT_COMPARE_TOLERANCE);
+    DOUBLES_EQUAL(one_third, dest.cov_xy, FLOAT_COMPARE_TOLERANCE);
+}
+
+TEST(KalmanSequentialUpdate, matchesJointUpdate)
+{
+    kalman_robot_handle_t joint;
+    kalman_init(&joint, &init_pos);
+
+    kalman_update_measurement_covariance(&handle, 0.01f, 0.02f, 0.005f);
+    kalman_update_measurement_covariance(&joint, 0.01f, 0.02f, 0.005f);
+
+    robot_pos_t dest_seq;
+    robot_pos_t dest_joint;
+
+    // robot moving along a curve, every third measurement is missing
+    int i;
+    for(i = 0; i < 500; i++) {
+        float t = i * 0.02f;
+        position_t meas = {1.5f + std::sin(t), 1.0f + 0.5f * std::cos(2 * t)};
+        const position_t * m = (i % 3 == 0) ? NULL : &meas;
+
+        kalman_update(&handle, m, 0.02f, &dest_seq);
+        kalman_update(&joint, m, 0.02f, &dest_joint);
+
+        // not bit-for-bit since the operations are done in another order,
+        // but within float rounding
+        DOUBLES_EQUAL(dest_joint.x, dest_seq.x, 1e-5);
+        DOUBLES_EQUAL(dest_joint.y, dest_seq.y, 1e-5);
+        DOUBLES_EQUAL(dest_joint.var_x, dest_seq.var_x, 1e-6);
+        DOUBLES_EQUAL(dest_joint.var_y, dest_seq.var_y, 1e-6);
+        DOUBLES_EQUAL(dest_joint.cov_xy, dest_seq.cov_xy, 1e-6);
+    }
+
+    DOUBLES_EQUAL(joint._state._v_x, handle._state._v_x, 1e-4);
+    DOUBLES_EQUAL(joint._state._v_y, handle._state._v_y, 1e-4);
+}
+
+TEST_GROUP(KalmanJosephForm)
+{
+    robot_pos_t init_pos;
+    kalman_robot_handle_t handle;
+    kalman_robot_handle_t standard;
+
+    void setup(void)
+    {
+        init_pos.x = 0.0f;
+        init_pos.y = 0.0f;
+        init_pos.var_x = 1.0f;
+        init_pos.var_y = 0.5f;
+        init_pos.cov_xy = 0.1f;
+
+        kalman_init(&handle, &init_pos);
+        kalman_init(&standard, &init_pos);
+        kalman_set_covariance_update(&handle, KALMAN_COVARIANCE_JOSEPH);
+
+        kalman_update_measurement_covariance(&handle, 0.01f, 0.02f, 0.005f);
+        kalman_update_measurement_covariance(&standard, 0.01f, 0.02f, 0.005f);
+    }
+
+    void teardown(void)
+    {
+
+    }
+
+    // with the optimal gain both forms are the same in exact arithmetic
+    void check_matches_standard(void)
+    {
+        robot_pos_t dest;
+        robot_pos_t expected;
+
+        // robot moving along a curve with jittering delta_t, every third
+        // measurement is missing
+        int i;
+        for(i = 0; i < 500; i++) {
+            float t = i * 0.02f;
+            float delta_t = 0.02f + 0.01f * std::sin(7 * t);
+            position_t meas = {1.5f + std::sin(t), 1.0f + 0.5f * std::cos(2 * t)};
+            const position_t * m = (i % 3 == 0) ? NULL : &meas;
+
+            kalman_update(&handle, m, delta_t, &dest);
+            kalman_update(&standard, m, delta_t, &expected);
+
+            DOUBLES_EQUAL(expected.x, dest.x, 1e-5);
+            DOUBLES_EQUAL(expected.y, dest.y, 1e-5);
+            DOUBLES_EQUAL(expected.var_x, dest.var_x, 1e-6);
+            DOUBLES_EQUAL(expected.var_y, dest.var_y, 1e-6);
+            DOUBLES_EQUAL(expected.cov_xy, dest.cov_xy, 1e-6);
+        }
+    }
+};
+
+TEST(KalmanJosephForm, setBadInput)
+{
+    CHECK(!kalman_set_covariance_update(NULL, KALMAN_COVARIANCE_JOSEPH));
+    CHECK(!kalman_set_covariance_update(&handle, (kalman_covariance_update_t)42));
+    CHECK(handle._covariance_update == KALMAN_COVARIANCE_JOSEPH);
+}
+
+TEST(KalmanJosephForm, defaultIsStandard)
+{
+    CHECK(standard._covariance_update == KALMAN_COVARIANCE_STANDARD);
+}
+
+TEST(KalmanJosephForm, matchesStandardJointUpdate)
+{
+    check_matches_standard();
+}
+
+TEST(KalmanJosephForm, matchesStandardSequentialUpdate)
+{
+    kalman_set_update_mode(&handle, KALMAN_UPDATE_SEQUENTIAL);
+    kalman_set_update_mode(&standard, KALMAN_UPDATE_SEQUENTIAL);
+    check_matches_standard();
+}
+
+TEST(KalmanJosephForm, crossCovarianceMatchesStandard)
+{
+    position_t meas = {0.1f, 0.1f};
+    robot_pos_t dest;
+
+    int i;
+    for(i = 0; i < 20; i++) {
+        kalman_update(&handle, &meas, 0.1f, &dest);
+        kalman_update(&standard, &meas, 0.1f, &dest);
+    }
+
+    const covariance_t * cov = &handle._state_covariance;
+    const covariance_t * expected = &standard._state_covariance;
+    DOUBLES_EQUAL(expected->_cov_b._a, cov->_cov_b._a, 1e-6);
+    DOUBLES_EQUAL(expected->_cov_b._b, cov->_cov_b._b, 1e-6);
+    DOUBLES_EQUAL(expected->_cov_b._c, cov->_cov_b._c, 1e-6);
+    DOUBLES_EQUAL(expected->_cov_b._d, cov->_cov_b._d, 1e-6);
+    DOUBLES_EQUAL(expected->_cov_d._a, cov->_cov_d._a, 1e-6);
+    DOUBLES_EQUAL(expected->_cov_d._b, cov->_cov_d._b, 1e-6);
+    DOUBLES_EQUAL(expected->_cov_d._d, cov->_cov_d._d, 1e-6);
+}
+
+TEST_GROUP(KalmanSteadyState)
+{
+    robot_pos_t init_pos;
+    kalman_robot_handle_t handle;
+    float delta_t;
+
+    void setup(void)
+    {
+        init_pos.x = 0.0f;
+        init_pos.y = 0.0f;
+        init_pos.var_x = 1.0f;
+        init_pos.var_y = 1.0f;
+        init_pos.cov_xy = 0.0f;
+
+        delta_t = 1.0f / KALMAN_TRANS_FREQ;
+
+        kalman_init(&handle, &init_pos);
+    }
+
+    void teardown(void)
+    {
+
+    }
+};
+
+TEST(KalmanSteadyState, enableBadInput)
+{
+    CHECK(!kalman_enable_steady_state(NULL, delta_t));
+    CHECK(!kalman_enable_steady_state(&handle, 0.0f));
+    CHECK(!kalman_disable_steady_state(NULL));
+    CHECK(!handle._steady_state_enabled);
+}
+
+TEST(KalmanSteadyState, enableSolvesForGain)
+{
+    CHECK(kalman_enable_steady_state(&handle, delta_t));
+    CHECK(handle._steady_state_enabled);
+    CHECK(handle._steady_state_locked);
+
+    // the covariance is at its converged value and doesn't change anymore
+    covariance_t cov = handle._state_covariance;
+    position_t meas = {0.1f, 0.1f};
+    robot_pos_t dest;
+    kalman_update(&handle, &meas, delta_t, &dest);
+
+    DOUBLES_EQUAL(cov._cov_a._a, dest.var_x, 0.0f);
+    DOUBLES_EQUAL(cov._cov_a._d, dest.var_y, 0.0f);
+    CHECK(dest.x > 0.0f);
+    CHECK(dest.y > 0.0f);
+}
+
+TEST(KalmanSteadyState, matchesFullComputation)
+{
+    kalman_robot_handle_t full;
+    kalman_init(&full, &init_pos);
+    kalman_enable_steady_state(&handle, delta_t);
+
+    robot_pos_t dest_steady;
+    robot_pos_t dest_full;
+
+    int i;
+    for(i = 0; i < 1000; i++) {
+        float t = i * delta_t;
+        position_t meas = {1.5f + std::sin(t), 1.0f + 0.5f * std::cos(2 * t)};
+
+        kalman_update(&handle, &meas, delta_t, &dest_steady);
+        kalman_update(&full, &meas, delta_t, &dest_full);
+    }
+
+    // the gain is only converged up to KALMAN_STEADY_STATE_GAIN_EPS
+    CHECK(handle._steady_state_locked);
+    DOUBLES_EQUAL(dest_full.x, dest_steady.x, 1e-3);
+    DOUBLES_EQUAL(dest_full.y, dest_steady.y, 1e-3);
+    DOUBLES_EQUAL(dest_full.var_x, dest_steady.var_x, 1e-6);
+    DOUBLES_EQUAL(dest_full.var_y, dest_steady.var_y, 1e-6);
+    DOUBLES_EQUAL(dest_full.cov_xy, dest_steady.cov_xy, 1e-6);
+}
+
+TEST(KalmanSteadyState, fallbackOnSkippedMeasurement)
+{
+    kalman_enable_steady_state(&handle, delta_t);
+    position_t meas = {0.0f, 0.0f};
+    robot_pos_t dest;
+
+    kalman_update(&handle, NULL, delta_t, &dest);
+    CHECK(!handle._steady_state_locked);
+
+    // the covariance grows like it would without steady-state operation
+    float var_after_skip = dest.var_x;
+    kalman_update(&handle, NULL, delta_t, &dest);
+    CHECK(dest.var_x > var_after_skip);
+
+    // and the gain is found again once measurements are back
+    int i;
+    for(i = 0; i < 1000 && !handle._steady_state_locked; i++) {
+        kalman_update(&handle, &meas, delta_t, &dest);
+    }
+    CHECK(handle._steady_state_locked);
+}
+
+TEST(KalmanSteadyState, fallbackOnDeltaTDrift)
+{
+    kalman_enable_steady_state(&handle, delta_t);
+    position_t meas = {0.0f, 0.0f};
+    robot_pos_t dest;
+
+    kalman_update(&handle, &meas, 1.01f * delta_t, &dest);
+    CHECK(handle._steady_state_locked);
+
+    kalman_update(&handle, &meas, 1.5f * delta_t, &dest);
+    CHECK(!handle._steady_state_locked);
+}
+
+TEST(KalmanSteadyState, fallbackOnParameterChange)
+{
+    kalman_enable_steady_state(&handle, delta_t);
+    kalman_update_measurement_covariance(&handle, 0.1f, 0.1f, 0.0f);
+    CHECK(!handle._steady_state_locked);
+
+    kalman_enable_steady_state(&handle, delta_t);
+    kalman_set_max_acc(&handle, 2.0f);
+    CHECK(!handle._steady_state_locked);
+}
+
+TEST(KalmanSteadyState, fallbackOnCovarianceOfMeasurement)
+{
+    kalman_enable_steady_state(&handle, delta_t);
+    covariance_t cov = handle._state_covariance;
+    position_covariance_t precise = {1e-6f, 1e-6f, 0.0f};
+    position_t meas = {0.1f, 0.1f};
+    robot_pos_t dest;
+
+    kalman_update_with_covariance(&handle, &meas, &precise, delta_t, &dest);
+    CHECK(!handle._steady_state_locked);
+    CHECK(dest.var_x < cov._cov_a._a);
+}
+
+TEST(KalmanSteadyState, disable)
+{
+    kalman_enable_steady_state(&handle, delta_t);
+    CHECK(kalman_disable_steady_state(&handle));
+    CHECK(!handle._steady_state_enabled);
+    CHECK(!handle._steady_state_locked);
+
+    position_t meas = {0.0f, 0.0f};
+    robot_pos_t dest;
+    int i;
+    for(i = 0; i < 100; i++) {
+        kalman_update(&handle, &meas, delta_t, &dest);
+    }
+    CHECK(!handle._steady_state_locked);
+}
+
+TEST_GROUP(KalmanOdometry)
+{
+    robot_pos_t init_pos;
+    kalman_robot_handle_t handle;
+    robot_odometry_t odometry;
+
+    void setup(void)
+    {
+        init_pos.x = 1.0f;
+        init_pos.y = 1.0f;
+        init_pos.var_x = 0.01f;
+        init_pos.var_y = 0.01f;
+        init_pos.cov_xy = 0.0f;
+
+        odometry.v_x = 0.5f;
+        odometry.v_y = -0.25f;
+        odometry.var = 0.01f;
+
+        kalman_init(&handle, &init_pos);
+    }
+
+    void teardown(void)
+    {
+
+    }
+};
+
+TEST(KalmanOdometry, setBadInput)
+{
+    CHECK(!kalman_set_odometry(NULL, &odometry));
+    odometry.var = -1.0f;
+    CHECK(!kalman_set_odometry(&handle, &odometry));
+    CHECK(!handle._odometry_valid);
+}
+
+TEST(KalmanOdometry, predictsWithOdometryVelocity)
+{
+    robot_pos_t dest;
+
+    CHECK(kalman_set_odometry(&handle, &odometry));
+    kalman_update(&handle, NULL, 0.1f, &dest);
+
+    DOUBLES_EQUAL(1.05f, dest.x, 1e-6);
+    DOUBLES_EQUAL(0.975f, dest.y, 1e-6);
+    DOUBLES_EQUAL(0.5f, handle._state._v_x, 0.0f);
+    DOUBLES_EQUAL(-0.25f, handle._state._v_y, 0.0f);
+
+    // only the odometry noise is added, dt*dt*var
+    DOUBLES_EQUAL(0.01f + 0.01f * 0.01f, dest.var_x, 1e-7);
+    DOUBLES_EQUAL(0.01f + 0.01f * 0.01f, dest.var_y, 1e-7);
+    DOUBLES_EQUAL(0.0f, dest.cov_xy, 1e-9);
+}
+
+TEST(KalmanOdometry, outageGrowsLinearly)
+{
+    kalman_robot_handle_t dead_reckoning;
+    robot_pos_t dest;
+    robot_pos_t dest_odometry;
+    int i;
+
+    kalman_init(&dead_reckoning, &init_pos);
+    kalman_set_odometry(&dead_reckoning, &odometry);
+
+    // 5 [s] without fix
+    for(i = 0; i < 50; i++) {
+        kalman_update(&handle, NULL, 0.1f, &dest);
+        kalman_update(&dead_reckoning, NULL, 0.1f, &dest_odometry);
+    }
+
+    // each step adds dt*dt*var, the constant velocity model grows with t^3
+    DOUBLES_EQUAL(0.01f + 50 * 0.01f * 0.01f, dest_odometry.var_x, 1e-6);
+    CHECK(dest.var_x > 10 * dest_odometry.var_x);
+}
+
+TEST(KalmanOdometry, fixCorrectsOdometryError)
+{
+    position_t meas = {1.2f, 1.0f};
+    robot_pos_t dest;
+
+    kalman_set_odometry(&handle, &odometry);
+    kalman_update(&handle, &meas, 0.1f, &dest);
+
+    // the predicted position carries the odometry error, B = dt*var
+    CHECK(dest.x > 1.05f);
+    CHECK(handle._state._v_x > 0.5f);
+
+    // which the next prediction forgets again
+    kalman_update(&handle, NULL, 0.1f, &dest);
+    DOUBLES_EQUAL(0.5f, handle._state._v_x, 0.0f);
+}
+
+TEST(KalmanOdometry, clearGoesBackToConstantVelocity)
+{
+    robot_pos_t dest;
+
+    kalman_set_odometry(&handle, &odometry);
+    kalman_update(&handle, NULL, 0.1f, &dest);
+    CHECK(kalman_set_odometry(&handle, NULL));
+    CHECK(!handle._odometry_valid);
+
+    // the last odometry velocity is kept by the constant velocity model
+    kalman_update(&handle, NULL, 0.1f, &dest);
+    DOUBLES_EQUAL(1.1f, dest.x, 1e-6);
+}
+
+TEST(KalmanOdometry, steadyStateFallbackOnModelChange)
+{
+    float delta_t = 1.0f / KALMAN_TRANS_FREQ;
+
+    kalman_enable_steady_state(&handle, delta_t);
+    kalman_set_odometry(&handle, &odometry);
+    CHECK(!handle._steady_state_locked);
+
+    // a new velocity keeps the gain
+    kalman_enable_steady_state(&handle, delta_t);
+    CHECK(handle._steady_state_locked);
+    odometry.v_x = 1.0f;
+    kalman_set_odometry(&handle, &odometry);
+    CHECK(handle._steady_state_locked);
+
+    kalman_set_odometry(&handle, NULL);
+    CHECK(!handle._steady_state_locked);
+}
@@ -0,0 +1,143 @@
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/positioning_lut.h"
+}
+
+#define RESOLUTION (48)
+
+static const position_t p_a = {3.0f, 1.0f};
+static const position_t p_b = {0.0f, 2.0f};
+static const position_t p_c = {0.0f, 0.0f};
+static const position_t area_min = {0.0f, 0.0f};
+static const position_t area_max = {3.0f, 2.0f};
+
+static positioning_lut_entry_t entries[POSITIONING_LUT_SIZE(RESOLUTION)];
+static positioning_lut_trig_t trig[POSITIONING_LUT_TRIG_SIZE(RESOLUTION)];
+static reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+static positioning_lut_t lut;
+
+// directed angle at 'point' from 'first' to 'second', in [0, 2 Pi)
+static float directed_angle(
+        const position_t * point,
+        const position_t * first,
+        const position_t * second)
+{
+    float angle = atan2f(second->y - point->y, second->x - point->x)
+        - atan2f(first->y - point->y, first->x - point->x);
+
+    return angle < 0.0f ? angle + 2.0f * (float)M_PI : angle;
+}
+
+TEST_GROUP(PositioningLutTestGroup)
+{
+    void setup(void)
+    {
+        positioning_reference_triangle_from_points(&p_a, &p_b, &p_c, &t);
+        CHECK_EQUAL(1, positioning_lut_init(&lut, &t, &area_min, &area_max,
+                    entries, trig, RESOLUTION));
+    }
+
+    void teardown(void)
+    {
+    }
+};
+
+TEST(PositioningLutTestGroup, NullArguments)
+{
+    positioning_lut_t other;
+    positioning_lut_trig_t other_trig[POSITIONING_LUT_TRIG_SIZE(RESOLUTION)];
+    position_t pos = {0.0f, 0.0f};
+
+    CHECK_EQUAL(0, positioning_lut_init(&other, NULL, &area_min, &area_max,
+                entries, other_trig, RESOLUTION));
+    CHECK_EQUAL(0, positioning_lut_init(&other, &t, &area_min, &area_max,
+                NULL, other_trig, RESOLUTION));
+    CHECK_EQUAL(0, positioning_lut_init(&other, &t, &area_max, &area_min,
+                entries, other_trig, RESOLUTION));
+    CHECK_EQUAL(0, positioning_lut_attach(&other, &t, NULL, entries,
+                other_trig, RESOLUTION));
+    CHECK_EQUAL(0, positioning_lut_attach(&other, &t,
+                positioning_lut_get_range(&lut), entries, NULL, RESOLUTION));
+    CHECK_EQUAL(0, positioning_lut_attach(&other, &t,
+                positioning_lut_get_range(&lut), entries, other_trig, 0));
+    CHECK_EQUAL(0, positioning_lut_from_angles(NULL, 2.0f, 2.0f,
+                2.0f * (float)M_PI - 4.0f, &pos));
+    CHECK_EQUAL(0, positioning_lut_from_angles(&lut, 2.0f, 2.0f,
+                2.0f * (float)M_PI - 4.0f, NULL));
+}
+
+TEST(PositioningLutTestGroup, AnglesNotSummingTo2PiAreNotTrusted)
+{
+    position_t pos = {42.0f, 42.0f};
+
+    CHECK_EQUAL(0, positioning_lut_from_angles(&lut, 2.0f, 2.0f, 1.0f, &pos));
+    DOUBLES_EQUAL(42.0f, pos.x, 0.0f);
+    DOUBLES_EQUAL(42.0f, pos.y, 0.0f);
+}
+
+TEST(PositioningLutTestGroup, AnglesOutsideRangeFallBackToClosedForm)
+{
+    const positioning_lut_range_t * range = positioning_lut_get_range(&lut);
+    float alpha = range->alpha_min - 0.01f;
+    float beta = 0.5f * (range->beta_min + range->beta_max);
+    float gamma = 2.0f * (float)M_PI - alpha - beta;
+    position_t pos = {0.0f, 0.0f};
+    position_t closed_form_pos = {0.0f, 0.0f};
+
+    CHECK_EQUAL(1, positioning_from_angles(alpha, beta, gamma, &t,
+                &closed_form_pos));
+    CHECK_EQUAL(1, positioning_lut_from_angles(&lut, alpha, beta, gamma,
+                &pos));
+    DOUBLES_EQUAL(closed_form_pos.x, pos.x, 0.0f);
+    DOUBLES_EQUAL(closed_form_pos.y, pos.y, 0.0f);
+}
+
+// every point of a 10 [cm] grid over the table the closed form trusts,
+// those near the circle of the beacons through the fallback
+TEST(PositioningLutTestGroup, MatchesPositionOnTable)
+{
+    int i, j;
+
+    for (i = 1; i < 30; i++) {
+        for (j = 1; j < 20; j++) {
+            position_t point = {0.1f * i, 0.1f * j};
+            position_t pos = {0.0f, 0.0f};
+            float alpha = directed_angle(&point, &p_b, &p_c);
+            float beta = directed_angle(&point, &p_c, &p_a);
+            float gamma = directed_angle(&point, &p_a, &p_b);
+
+            if (!positioning_from_angles(alpha, beta, gamma, &t, &pos)) {
+                continue;
+            }
+            CHECK_EQUAL(1, positioning_lut_from_angles(&lut, alpha, beta,
+                        gamma, &pos));
+            DOUBLES_EQUAL(point.x, pos.x, 0.001f);
+            DOUBLES_EQUAL(point.y, pos.y, 0.001f);
+        }
+    }
+}
+
+TEST(PositioningLutTestGroup, AttachedTableGivesSamePositions)
+{
+    positioning_lut_t attached;
+    positioning_lut_trig_t attached_trig[POSITIONING_LUT_TRIG_SIZE(RESOLUTION)];
+    position_t point = {1.2f, 0.7f};
+    position_t pos = {0.0f, 0.0f};
+    position_t attached_pos = {0.0f, 0.0f};
+    float alpha = directed_angle(&point, &p_b, &p_c);
+    float beta = directed_angle(&point, &p_c, &p_a);
+    float gamma = directed_angle(&point, &p_a, &p_b);
+
+    CHECK_EQUAL(1, positioning_lut_attach(&attached, &t,
+                positioning_lut_get_range(&lut), entries, attached_trig,
+                RESOLUTION));
+    CHECK_EQUAL(1, positioning_lut_from_angles(&lut, alpha, beta, gamma,
+                &pos));
+    CHECK_EQUAL(1, positioning_lut_from_angles(&attached, alpha, beta,
+                gamma, &attached_pos));
+    DOUBLES_EQUAL(pos.x, attached_pos.x, 0.0f);
+    DOUBLES_EQUAL(pos.y, attached_pos.y, 0.0f);
+}
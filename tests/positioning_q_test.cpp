@@ -0,0 +1,149 @@
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/positioning_q.h"
+#include "../src/positioning.h"
+}
+
+#define POINT_A_X (3.0f)
+#define POINT_A_Y (1.0f)
+
+#define POINT_B_X (0.0f)
+#define POINT_B_Y (2.0f)
+
+#define POINT_C_X (0.0f)
+#define POINT_C_Y (0.0f)
+
+static position_t p_a = {POINT_A_X, POINT_A_Y};
+static position_t p_b = {POINT_B_X, POINT_B_Y};
+static position_t p_c = {POINT_C_X, POINT_C_Y};
+static reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+
+// directed angle at (x, y) from p->first to p->second, in [0, 2 Pi)
+static double directed_angle(
+        double x,
+        double y,
+        const position_t * first,
+        const position_t * second)
+{
+    double angle = std::atan2(second->y - y, second->x - x)
+        - std::atan2(first->y - y, first->x - x);
+
+    return angle < 0 ? angle + 2 * M_PI : angle;
+}
+
+static angle_q_t angle_q(double angle)
+{
+    return (angle_q_t)(uint64_t)(angle / (2 * M_PI) * 4294967296.0);
+}
+
+TEST_GROUP(PositioningQ)
+{
+    position_q_t q_a;
+    position_q_t q_b;
+    position_q_t q_c;
+    reference_triangle_q_t t_q;
+
+    void setup(void)
+    {
+        q_a.x = Q8_24_FROM_FLOAT(POINT_A_X);
+        q_a.y = Q8_24_FROM_FLOAT(POINT_A_Y);
+        q_b.x = Q8_24_FROM_FLOAT(POINT_B_X);
+        q_b.y = Q8_24_FROM_FLOAT(POINT_B_Y);
+        q_c.x = Q8_24_FROM_FLOAT(POINT_C_X);
+        q_c.y = Q8_24_FROM_FLOAT(POINT_C_Y);
+
+        positioning_reference_triangle_from_points(&p_a, &p_b, &p_c, &t);
+        positioning_q_reference_triangle_from_points(&q_a, &q_b, &q_c, &t_q);
+    }
+
+    void teardown(void)
+    {
+
+    }
+};
+
+TEST(PositioningQ, triangleBadInput)
+{
+    reference_triangle_q_t out;
+
+    CHECK(!positioning_q_reference_triangle_from_points(NULL, &q_b, &q_c, &out));
+    CHECK(!positioning_q_reference_triangle_from_points(&q_a, NULL, &q_c, &out));
+    CHECK(!positioning_q_reference_triangle_from_points(&q_a, &q_b, NULL, &out));
+    CHECK(!positioning_q_reference_triangle_from_points(&q_a, &q_b, &q_c, NULL));
+
+    // wrong orientation
+    CHECK(!positioning_q_reference_triangle_from_points(&q_a, &q_c, &q_b, &out));
+}
+
+TEST(PositioningQ, triangleMatchesFloat)
+{
+    DOUBLES_EQUAL(t.cotangent_at_a,
+            (double)t_q.cos_at_a / t_q.sin_at_a, 1e-6);
+    DOUBLES_EQUAL(t.cotangent_at_b,
+            (double)t_q.cos_at_b / t_q.sin_at_b, 1e-6);
+    DOUBLES_EQUAL(t.cotangent_at_c,
+            (double)t_q.cos_at_c / t_q.sin_at_c, 1e-6);
+}
+
+TEST(PositioningQ, anglesDontSumToWholeTurn)
+{
+    position_q_t result;
+
+    CHECK(!positioning_q_from_angles(
+                angle_q(1.0), angle_q(1.0), angle_q(1.0), &t_q, &result));
+    CHECK(!positioning_q_from_angles(
+                angle_q(2.0), angle_q(2.0), angle_q(2.0), NULL, &result));
+}
+
+TEST(PositioningQ, matchesFloatVersion)
+{
+    double x, y;
+    for(x = 0.2; x < 3.0; x += 0.1) {
+        for(y = 0.1; y < 2.0; y += 0.1) {
+            double alpha = directed_angle(x, y, &p_b, &p_c);
+            double beta = directed_angle(x, y, &p_c, &p_a);
+            double gamma = directed_angle(x, y, &p_a, &p_b);
+
+            position_t expected = {0, 0};
+            position_q_t result;
+            uint8_t valid = positioning_from_angles(
+                    alpha, beta, gamma, &t, &expected);
+            uint8_t valid_q = positioning_q_from_angles(
+                    angle_q(alpha), angle_q(beta), angle_q(gamma), &t_q, &result);
+
+            if(!valid) {
+                continue;
+            }
+
+            // the float version is not exact either
+            CHECK(valid_q);
+            DOUBLES_EQUAL(x, Q8_24_TO_FLOAT(result.x), 1e-3);
+            DOUBLES_EQUAL(y, Q8_24_TO_FLOAT(result.y), 1e-3);
+        }
+    }
+}
+
+TEST(PositioningQ, circleOfDeath)
+{
+    // circumcircle of the reference triangle
+    double x = 4.0 / 3.0 + 5.0 / 3.0 * std::cos(M_PI / 6);
+    double y = 1.0 + 5.0 / 3.0 * std::sin(M_PI / 6);
+    position_q_t result;
+
+    CHECK(!positioning_q_from_angles(
+                angle_q(directed_angle(x, y, &p_b, &p_c)),
+                angle_q(directed_angle(x, y, &p_c, &p_a)),
+                angle_q(directed_angle(x, y, &p_a, &p_b)),
+                &t_q,
+                &result));
+}
+
+TEST(PositioningQ, angleFromTicks)
+{
+    CHECK_EQUAL(0x40000000, positioning_q_angle_from_ticks(25, 100));
+    CHECK_EQUAL(0x80000000, positioning_q_angle_from_ticks(50000, 100000));
+    CHECK_EQUAL(0, positioning_q_angle_from_ticks(1, 0));
+}
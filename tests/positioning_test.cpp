@@ -1,4 +1,5 @@
 #include <cmath>
+#include <cstring>
 #include <assert.h>
 
 #include <iostream>
@@ -434,3 +435,243 @@ TEST(PositioningTestGroup, NormalBehaviour)
     CHECK(valid);
     CHECK_EQUAL(Vec2D(&some_point), Vec2D(&result));
 }
+
+static const position_t batch_p_a = {POINT_A_X, POINT_A_Y};
+static const position_t batch_p_b = {POINT_B_X, POINT_B_Y};
+static const position_t batch_p_c = {POINT_C_X, POINT_C_Y};
+
+TEST_GROUP(PositioningBatchTestGroup)
+{
+    void setup(void)
+    {
+    }
+
+    void teardown(void)
+    {
+    }
+};
+
+TEST(PositioningBatchTestGroup, NullArguments)
+{
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    positioning_reference_triangle_from_points(
+            &batch_p_a, &batch_p_b, &batch_p_c, &t);
+
+    float angle = 0.0f;
+    float x, y;
+    uint32_t valid;
+
+    CHECK_EQUAL(0, positioning_from_angles_batch(
+                NULL, &angle, &angle, 1, &t, &x, &y, &valid));
+    CHECK_EQUAL(0, positioning_from_angles_batch(
+                &angle, &angle, &angle, 1, NULL, &x, &y, &valid));
+    CHECK_EQUAL(0, positioning_from_angles_batch(
+                &angle, &angle, &angle, 1, &t, &x, &y, NULL));
+}
+
+// every point of a 5 [cm] grid over the table, not a multiple of 32
+TEST(PositioningBatchTestGroup, MatchesScalarVersion)
+{
+    static const int SIZE_X = 59;
+    static const int SIZE_Y = 39;
+    static const int COUNT = SIZE_X * SIZE_Y;
+    static float alpha[COUNT], beta[COUNT], gamma[COUNT];
+    static float x[COUNT], y[COUNT];
+    static uint32_t valid[(COUNT + 31) / 32];
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    uint32_t nb_valid = 0;
+    int nb_mismatches = 0;
+    int i, j;
+
+    positioning_reference_triangle_from_points(
+            &batch_p_a, &batch_p_b, &batch_p_c, &t);
+
+    for (i = 0; i < SIZE_X; i++) {
+        for (j = 0; j < SIZE_Y; j++) {
+            position_t point = {0.05f * (i + 1), 0.05f * (j + 1)};
+            Angles angles = Vec2D(&point).angles_relative_to_triangle(&t);
+            alpha[i * SIZE_Y + j] = angles.alpha;
+            beta[i * SIZE_Y + j] = angles.beta;
+            gamma[i * SIZE_Y + j] = angles.gamma;
+        }
+    }
+    memset(valid, 0xff, sizeof(valid));
+
+    uint32_t nb_batch_valid = positioning_from_angles_batch(
+            alpha, beta, gamma, COUNT, &t, x, y, valid);
+
+    for (i = 0; i < COUNT; i++) {
+        position_t result = {0, 0};
+        bool scalar_valid = positioning_from_angles(
+                alpha[i], beta[i], gamma[i], &t, &result);
+        bool batch_valid = (valid[i / 32] >> (i % 32)) & 1;
+
+        if (scalar_valid != batch_valid) {
+            nb_mismatches++;
+            continue;
+        }
+        if (scalar_valid) {
+            nb_valid++;
+            DOUBLES_EQUAL(result.x, x[i], POSITIONING_BATCH_TOLERANCE);
+            DOUBLES_EQUAL(result.y, y[i], POSITIONING_BATCH_TOLERANCE);
+        }
+    }
+
+    CHECK(nb_valid > COUNT / 2);
+    CHECK(nb_mismatches <= COUNT / 500);
+    CHECK_EQUAL(0, valid[COUNT / 32] >> (COUNT % 32));
+
+    uint32_t nb_bits = 0;
+    for (i = 0; i < COUNT; i++) {
+        nb_bits += (valid[i / 32] >> (i % 32)) & 1;
+    }
+    CHECK_EQUAL(nb_bits, nb_batch_valid);
+}
+
+// angles seen from 'point' with the bearing of beacon 'beacon' (0 to 2 for
+// a, b, c) turned by 'delta'
+static Angles angles_with_bearing_error(
+        const position_t * point,
+        int beacon,
+        double delta)
+{
+    const position_t * beacons[3] = {&batch_p_a, &batch_p_b, &batch_p_c};
+    double bearing[3];
+    Angles result;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        bearing[i] = std::atan2(beacons[i]->y - point->y,
+                beacons[i]->x - point->x) + (i == beacon ? delta : 0.0);
+    }
+
+    result.alpha = std::fmod(bearing[2] - bearing[1] + 4 * M_PI, 2 * M_PI);
+    result.beta = std::fmod(bearing[0] - bearing[2] + 4 * M_PI, 2 * M_PI);
+    result.gamma = std::fmod(bearing[1] - bearing[0] + 4 * M_PI, 2 * M_PI);
+
+    return result;
+}
+
+TEST_GROUP(PositioningCovarianceTestGroup)
+{
+    void setup(void)
+    {
+    }
+
+    void teardown(void)
+    {
+    }
+};
+
+TEST(PositioningCovarianceTestGroup, NullArguments)
+{
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    positioning_reference_triangle_from_points(
+            &batch_p_a, &batch_p_b, &batch_p_c, &t);
+
+    position_t result = {0, 0};
+    position_covariance_t cov;
+
+    CHECK_EQUAL(0, positioning_from_angles_with_covariance(
+                2.0f, 2.0f, 2 * M_PI - 4.0f, 1e-6f, NULL, &result, &cov));
+    CHECK_EQUAL(0, positioning_from_angles_with_covariance(
+                2.0f, 2.0f, 2 * M_PI - 4.0f, 1e-6f, &t, NULL, &cov));
+    CHECK_EQUAL(0, positioning_from_angles_with_covariance(
+                2.0f, 2.0f, 2 * M_PI - 4.0f, 1e-6f, &t, &result, NULL));
+    CHECK_EQUAL(0, positioning_from_angles_with_covariance(
+                2.0f, 2.0f, 2 * M_PI - 4.0f, -1e-6f, &t, &result, &cov));
+    CHECK_EQUAL(0, positioning_from_angles_with_covariance(
+                2.0f, 2.0f, 1.0f, 1e-6f, &t, &result, &cov));
+}
+
+TEST(PositioningCovarianceTestGroup, MatchesPositioningFromAngles)
+{
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    positioning_reference_triangle_from_points(
+            &batch_p_a, &batch_p_b, &batch_p_c, &t);
+
+    position_t point = {1.2f, 0.7f};
+    Angles angles = Vec2D(&point).angles_relative_to_triangle(&t);
+    position_t expected = {0, 0};
+    position_t result = {0, 0};
+    position_covariance_t cov;
+
+    CHECK(positioning_from_angles(angles.alpha, angles.beta, angles.gamma,
+                &t, &expected));
+    CHECK_EQUAL(1, positioning_from_angles_with_covariance(angles.alpha,
+                angles.beta, angles.gamma, 1e-6f, &t, &result, &cov));
+    DOUBLES_EQUAL(expected.x, result.x, 1e-5);
+    DOUBLES_EQUAL(expected.y, result.y, 1e-5);
+}
+
+// the covariance is the sum over the beacons of the outer product of the
+// derivative of the position by the bearing, checked against central
+// differences
+TEST(PositioningCovarianceTestGroup, MatchesFiniteDifferences)
+{
+    static const double H = 1e-3;
+    static const float VAR = 1e-6f;
+    const position_t points[3] = {{0.5f, 0.4f}, {1.5f, 1.0f}, {2.2f, 1.7f}};
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    int i, k;
+
+    positioning_reference_triangle_from_points(
+            &batch_p_a, &batch_p_b, &batch_p_c, &t);
+
+    for (i = 0; i < 3; i++) {
+        double var_x = 0.0, var_y = 0.0, cov_xy = 0.0;
+
+        for (k = 0; k < 3; k++) {
+            Angles plus = angles_with_bearing_error(&points[i], k, H);
+            Angles minus = angles_with_bearing_error(&points[i], k, -H);
+            position_t p_plus = {0, 0};
+            position_t p_minus = {0, 0};
+
+            positioning_from_angles(plus.alpha, plus.beta, plus.gamma, &t,
+                    &p_plus);
+            positioning_from_angles(minus.alpha, minus.beta, minus.gamma, &t,
+                    &p_minus);
+            double j_x = (p_plus.x - p_minus.x) / (2 * H);
+            double j_y = (p_plus.y - p_minus.y) / (2 * H);
+            var_x += VAR * j_x * j_x;
+            var_y += VAR * j_y * j_y;
+            cov_xy += VAR * j_x * j_y;
+        }
+
+        Angles angles = angles_with_bearing_error(&points[i], 0, 0.0);
+        position_t result = {0, 0};
+        position_covariance_t cov;
+        CHECK_EQUAL(1, positioning_from_angles_with_covariance(angles.alpha,
+                    angles.beta, angles.gamma, VAR, &t, &result, &cov));
+
+        DOUBLES_EQUAL(var_x, cov.var_x, 0.02 * var_x + 1e-9);
+        DOUBLES_EQUAL(var_y, cov.var_y, 0.02 * var_y + 1e-9);
+        DOUBLES_EQUAL(cov_xy, cov.cov_xy, 0.02 * std::sqrt(var_x * var_y));
+    }
+}
+
+// (2.75, 0.1) is 1 [cm] away from the circumcircle of the beacons (center
+// (4/3, 1), radius 5/3)
+TEST(PositioningCovarianceTestGroup, GrowsNearCircumcircle)
+{
+    reference_triangle_t t = {NULL, NULL, NULL, 0, 0, 0};
+    positioning_reference_triangle_from_points(
+            &batch_p_a, &batch_p_b, &batch_p_c, &t);
+
+    position_t center = {1.0f, 1.0f};
+    position_t near_circle = {2.75f, 0.1f};
+    position_t result = {0, 0};
+    position_covariance_t cov_center, cov_circle;
+
+    Angles angles = Vec2D(&center).angles_relative_to_triangle(&t);
+    CHECK_EQUAL(1, positioning_from_angles_with_covariance(angles.alpha,
+                angles.beta, angles.gamma, 1e-6f, &t, &result, &cov_center));
+    angles = Vec2D(&near_circle).angles_relative_to_triangle(&t);
+    CHECK_EQUAL(1, positioning_from_angles_with_covariance(angles.alpha,
+                angles.beta, angles.gamma, 1e-6f, &t, &result, &cov_circle));
+
+    CHECK(cov_center.var_x > 0.0f);
+    CHECK(cov_center.var_y > 0.0f);
+    CHECK(cov_circle.var_x + cov_circle.var_y >
+            100.0f * (cov_center.var_x + cov_center.var_y));
+}
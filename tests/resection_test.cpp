@@ -0,0 +1,172 @@
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/resection.h"
+}
+
+// the beacons of beacon_config.h, then the corners of the other side
+static const position_t beacons[5] = {
+    {3.0f, 1.0f}, {0.0f, 2.0f}, {0.0f, 0.0f}, {3.0f, 2.0f}, {3.0f, 0.0f}};
+
+static resection_t three = {NULL, 0, 0, {NULL, NULL, NULL, 0, 0, 0}};
+static resection_t five = {NULL, 0, 0, {NULL, NULL, NULL, 0, 0, 0}};
+
+// bearings of the beacons seen from 'point', from an origin 'offset' [rad]
+// off the x axis
+static void bearings_from(
+        const position_t * point,
+        float offset,
+        float * bearings)
+{
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        bearings[i] = std::atan2(beacons[i].y - point->y,
+                beacons[i].x - point->x) - offset;
+    }
+}
+
+TEST_GROUP(ResectionTestGroup)
+{
+    void setup(void)
+    {
+        CHECK_EQUAL(1, resection_init(&three, beacons, 3));
+        CHECK_EQUAL(1, resection_init(&five, beacons, 5));
+    }
+
+    void teardown(void)
+    {
+    }
+};
+
+TEST(ResectionTestGroup, BadArguments)
+{
+    float bearings[5] = {0, 0, 0, 0, 0};
+    position_t pos = {0.0f, 0.0f};
+    position_covariance_t cov;
+
+    CHECK_EQUAL(0, resection_init(NULL, beacons, 3));
+    CHECK_EQUAL(0, resection_init(&three, NULL, 3));
+    CHECK_EQUAL(0, resection_init(&three, beacons, 2));
+    CHECK_EQUAL(0, resection_init(&three, beacons, RESECTION_MAX_BEACONS + 1));
+    CHECK_EQUAL(0, resection_from_bearings(
+                NULL, bearings, 0x1f, 1e-6f, NULL, &pos, &cov));
+    CHECK_EQUAL(0, resection_from_bearings(
+                &five, NULL, 0x1f, 1e-6f, NULL, &pos, &cov));
+    CHECK_EQUAL(0, resection_from_bearings(
+                &five, bearings, 0x1f, 1e-6f, NULL, NULL, &cov));
+    CHECK_EQUAL(0, resection_from_bearings(
+                &five, bearings, 0x1f, 1e-6f, NULL, &pos, NULL));
+    CHECK_EQUAL(0, resection_from_bearings(
+                &five, bearings, 0x1f, -1e-6f, NULL, &pos, &cov));
+}
+
+TEST(ResectionTestGroup, NeedsThreeVisibleBeacons)
+{
+    position_t point = {1.0f, 1.0f};
+    position_t pos = {0.0f, 0.0f};
+    position_covariance_t cov;
+    float bearings[5];
+
+    bearings_from(&point, 0.3f, bearings);
+
+    CHECK_EQUAL(0, resection_from_bearings(
+                &five, bearings, 0x09, 1e-6f, NULL, &pos, &cov));
+    CHECK_EQUAL(1, resection_from_bearings(
+                &five, bearings, 0x0b, 1e-6f, NULL, &pos, &cov));
+}
+
+TEST(ResectionTestGroup, ThreeBeaconsIsTheClosedForm)
+{
+    position_t point = {1.2f, 0.7f};
+    position_t pos = {0.0f, 0.0f};
+    position_t expected = {0.0f, 0.0f};
+    position_covariance_t cov, expected_cov;
+    float bearings[5];
+
+    bearings_from(&point, 2.0f, bearings);
+
+    CHECK_EQUAL(1, resection_from_bearings(
+                &three, bearings, 0x07, 1e-6f, NULL, &pos, &cov));
+    CHECK_EQUAL(1, positioning_from_angles_with_covariance(
+                std::fmod(bearings[2] - bearings[1] + 4 * M_PI, 2 * M_PI),
+                std::fmod(bearings[0] - bearings[2] + 4 * M_PI, 2 * M_PI),
+                std::fmod(bearings[1] - bearings[0] + 4 * M_PI, 2 * M_PI),
+                1e-6f, &three._triangle, &expected, &expected_cov));
+
+    DOUBLES_EQUAL(expected.x, pos.x, 1e-5);
+    DOUBLES_EQUAL(expected.y, pos.y, 1e-5);
+    DOUBLES_EQUAL(expected_cov.var_x, cov.var_x, 1e-9);
+    DOUBLES_EQUAL(expected_cov.var_y, cov.var_y, 1e-9);
+}
+
+// every point of a 20 [cm] grid over the table, from the center of the
+// beacons
+TEST(ResectionTestGroup, FiveBeaconsOnTable)
+{
+    int i, j;
+
+    for (i = 1; i < 15; i++) {
+        for (j = 1; j < 10; j++) {
+            position_t point = {0.2f * i, 0.2f * j};
+            position_t pos = {0.0f, 0.0f};
+            position_covariance_t cov;
+            float bearings[5];
+
+            bearings_from(&point, -1.0f, bearings);
+
+            CHECK_EQUAL(1, resection_from_bearings(
+                        &five, bearings, 0x1f, 1e-6f, NULL, &pos, &cov));
+            DOUBLES_EQUAL(point.x, pos.x, 1e-4);
+            DOUBLES_EQUAL(point.y, pos.y, 1e-4);
+        }
+    }
+}
+
+// (2.75, 0.1) is 1 [cm] away from the circumcircle of the three first
+// beacons, the other two tell the position
+TEST(ResectionTestGroup, NoDeadZoneWithMoreBeacons)
+{
+    position_t point = {2.75f, 0.1f};
+    position_t pos = {0.0f, 0.0f};
+    position_covariance_t cov_three, cov_five;
+    float bearings[5];
+
+    bearings_from(&point, 0.0f, bearings);
+
+    CHECK_EQUAL(1, resection_from_bearings(
+                &three, bearings, 0x07, 1e-6f, NULL, &pos, &cov_three));
+    CHECK_EQUAL(1, resection_from_bearings(
+                &five, bearings, 0x1f, 1e-6f, NULL, &pos, &cov_five));
+
+    DOUBLES_EQUAL(point.x, pos.x, 1e-4);
+    DOUBLES_EQUAL(point.y, pos.y, 1e-4);
+    CHECK(cov_five.var_x + cov_five.var_y <
+            0.01f * (cov_three.var_x + cov_three.var_y));
+}
+
+TEST(ResectionTestGroup, HiddenBeaconIsIgnored)
+{
+    position_t point = {1.8f, 1.4f};
+    position_t guess = {1.5f, 1.0f};
+    position_t pos = {0.0f, 0.0f};
+    position_covariance_t cov_all, cov_hidden;
+    float bearings[5];
+
+    bearings_from(&point, 1.0f, bearings);
+    // beacon 3 is behind the other robot, its bearing is garbage
+    bearings[3] = 0.0f;
+
+    CHECK_EQUAL(1, resection_from_bearings(
+                &five, bearings, 0x17, 1e-6f, &guess, &pos, &cov_hidden));
+    DOUBLES_EQUAL(point.x, pos.x, 1e-4);
+    DOUBLES_EQUAL(point.y, pos.y, 1e-4);
+
+    bearings_from(&point, 1.0f, bearings);
+    CHECK_EQUAL(1, resection_from_bearings(
+                &five, bearings, 0x1f, 1e-6f, &guess, &pos, &cov_all));
+    CHECK(cov_all.var_x + cov_all.var_y <
+            cov_hidden.var_x + cov_hidden.var_y);
+}
@@ -0,0 +1,133 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/telemetry.h"
+#include <string.h>
+}
+
+TEST_GROUP(TelemetryTestGroup)
+{
+};
+
+TEST(TelemetryTestGroup, Crc16CheckValue)
+{
+    const uint8_t data[] = "123456789";
+
+    CHECK_EQUAL(0x29b1, telemetry_crc16(data, 9));
+}
+
+TEST(TelemetryTestGroup, CobsEncodesZeros)
+{
+    const uint8_t data[] = {0x11, 0x22, 0x00, 0x33};
+    const uint8_t expected[] = {0x03, 0x11, 0x22, 0x02, 0x33};
+    uint8_t encoded[8];
+
+    CHECK_EQUAL(sizeof(expected), telemetry_cobs_encode(data, sizeof(data), encoded));
+    MEMCMP_EQUAL(expected, encoded, sizeof(expected));
+}
+
+TEST(TelemetryTestGroup, CobsEncodesSingleZero)
+{
+    const uint8_t data[] = {0x00};
+    const uint8_t expected[] = {0x01, 0x01};
+    uint8_t encoded[4];
+
+    CHECK_EQUAL(sizeof(expected), telemetry_cobs_encode(data, sizeof(data), encoded));
+    MEMCMP_EQUAL(expected, encoded, sizeof(expected));
+}
+
+TEST(TelemetryTestGroup, CobsSplitsLongBlocks)
+{
+    uint8_t data[300];
+    uint8_t encoded[310];
+    uint8_t decoded[310];
+    size_t i;
+
+    for(i = 0; i < sizeof(data); i++){
+        data[i] = (uint8_t)(i % 255 + 1);
+    }
+
+    size_t length = telemetry_cobs_encode(data, sizeof(data), encoded);
+
+    CHECK_EQUAL(sizeof(data) + 2, length);
+    CHECK_EQUAL(0xff, encoded[0]);
+    CHECK(memchr(encoded, 0, length) == NULL);
+
+    CHECK_EQUAL(sizeof(data), telemetry_cobs_decode(encoded, length, decoded));
+    MEMCMP_EQUAL(data, decoded, sizeof(data));
+}
+
+TEST(TelemetryTestGroup, CobsDecodeRejectsTruncatedBlock)
+{
+    const uint8_t encoded[] = {0x05, 0x11, 0x22};
+    uint8_t decoded[8];
+
+    CHECK_EQUAL(0, telemetry_cobs_decode(encoded, sizeof(encoded), decoded));
+}
+
+TEST(TelemetryTestGroup, RobotStateFrame)
+{
+    telemetry_robot_state_t state = {
+        1, TELEMETRY_FLAG_FIX, 0x12345678,
+        1.5f, 0.25f, 0.001f, 0.002f, 0.0f};
+    uint8_t frame[TELEMETRY_FRAME_MAX_SIZE];
+    uint8_t payload[TELEMETRY_FRAME_MAX_SIZE];
+    float value;
+
+    size_t length = telemetry_encode_robot_state(&state, frame);
+
+    CHECK(length <= TELEMETRY_FRAME_MAX_SIZE);
+    CHECK_EQUAL(0, frame[length - 1]);
+    CHECK(memchr(frame, 0, length - 1) == NULL);
+
+    size_t payload_length = telemetry_cobs_decode(frame, length - 1, payload);
+    CHECK_EQUAL(TELEMETRY_ROBOT_STATE_SIZE + 2, payload_length);
+
+    uint16_t crc = telemetry_crc16(payload, TELEMETRY_ROBOT_STATE_SIZE);
+    CHECK_EQUAL(crc & 0xff, payload[TELEMETRY_ROBOT_STATE_SIZE]);
+    CHECK_EQUAL(crc >> 8, payload[TELEMETRY_ROBOT_STATE_SIZE + 1]);
+
+    CHECK_EQUAL(TELEMETRY_ROBOT_STATE, payload[0]);
+    CHECK_EQUAL(1, payload[1]);
+    CHECK_EQUAL(TELEMETRY_FLAG_FIX, payload[2]);
+    CHECK_EQUAL(0x78, payload[3]);
+    CHECK_EQUAL(0x12, payload[6]);
+
+    memcpy(&value, &payload[7], sizeof(value));
+    CHECK_EQUAL(1.5f, value);
+    memcpy(&value, &payload[11], sizeof(value));
+    CHECK_EQUAL(0.25f, value);
+    memcpy(&value, &payload[23], sizeof(value));
+    CHECK_EQUAL(0.0f, value);
+}
+
+TEST(TelemetryTestGroup, EdgeTraceFrame)
+{
+    uint8_t records[TELEMETRY_EDGE_TRACE_MAX_SIZE + 1];
+    uint8_t frame[TELEMETRY_FRAME_MAX_SIZE];
+    uint8_t payload[TELEMETRY_FRAME_MAX_SIZE];
+
+    memset(records, 0, sizeof(records));
+    records[0] = 0x10;
+    records[TELEMETRY_EDGE_TRACE_MAX_SIZE - 1] = 0x42;
+
+    size_t length = telemetry_encode_edge_trace(
+            records, TELEMETRY_EDGE_TRACE_MAX_SIZE, frame);
+
+    CHECK(length <= TELEMETRY_FRAME_MAX_SIZE);
+    CHECK_EQUAL(0, frame[length - 1]);
+    CHECK(memchr(frame, 0, length - 1) == NULL);
+
+    size_t payload_length = telemetry_cobs_decode(frame, length - 1, payload);
+    CHECK_EQUAL(1 + TELEMETRY_EDGE_TRACE_MAX_SIZE + 2, payload_length);
+    CHECK_EQUAL(TELEMETRY_EDGE_TRACE, payload[0]);
+    CHECK_EQUAL(0x10, payload[1]);
+    CHECK_EQUAL(0x42, payload[TELEMETRY_EDGE_TRACE_MAX_SIZE]);
+
+    uint16_t crc = telemetry_crc16(payload, payload_length - 2);
+    CHECK_EQUAL(crc & 0xff, payload[payload_length - 2]);
+    CHECK_EQUAL(crc >> 8, payload[payload_length - 1]);
+
+    CHECK_EQUAL(0, telemetry_encode_edge_trace(
+                records, TELEMETRY_EDGE_TRACE_MAX_SIZE + 1, frame));
+}
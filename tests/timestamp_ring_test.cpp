@@ -0,0 +1,92 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/timestamp_ring.h"
+}
+
+
+TEST_GROUP(TimestampRingTestGroup)
+{
+    timestamp_ring_t ring;
+
+    void setup(void)
+    {
+        timestamp_ring_init(&ring);
+    }
+};
+
+TEST(TimestampRingTestGroup, IsEmptyAfterInit)
+{
+    timestamp_event_t event;
+
+    CHECK_FALSE(timestamp_ring_pop(&ring, &event));
+    CHECK_EQUAL(0, timestamp_ring_dropped(&ring));
+}
+
+TEST(TimestampRingTestGroup, PopsInPushOrder)
+{
+    timestamp_event_t event;
+
+    CHECK_TRUE(timestamp_ring_push(&ring, 1, 100));
+    CHECK_TRUE(timestamp_ring_push(&ring, 2, 200));
+
+    CHECK_TRUE(timestamp_ring_pop(&ring, &event));
+    CHECK_EQUAL(1, event.beacon);
+    CHECK_EQUAL(100, event.time);
+
+    CHECK_TRUE(timestamp_ring_pop(&ring, &event));
+    CHECK_EQUAL(2, event.beacon);
+    CHECK_EQUAL(200, event.time);
+
+    CHECK_FALSE(timestamp_ring_pop(&ring, &event));
+}
+
+TEST(TimestampRingTestGroup, DropsWhenFull)
+{
+    timestamp_event_t event;
+    uint32_t i;
+
+    for(i = 0; i < TIMESTAMP_RING_SIZE; i++){
+        CHECK_TRUE(timestamp_ring_push(&ring, 0, i));
+    }
+    CHECK_FALSE(timestamp_ring_push(&ring, 0, i));
+    CHECK_EQUAL(1, timestamp_ring_dropped(&ring));
+
+    // the oldest events are kept
+    CHECK_TRUE(timestamp_ring_pop(&ring, &event));
+    CHECK_EQUAL(0, event.time);
+    CHECK_TRUE(timestamp_ring_push(&ring, 0, i));
+}
+
+TEST(TimestampRingTestGroup, WrapsAround)
+{
+    timestamp_event_t event;
+    uint32_t i;
+
+    for(i = 0; i < 3 * TIMESTAMP_RING_SIZE; i++){
+        CHECK_TRUE(timestamp_ring_push(&ring, i % 3, i));
+        CHECK_TRUE(timestamp_ring_pop(&ring, &event));
+        CHECK_EQUAL(i % 3, event.beacon);
+        CHECK_EQUAL(i, event.time);
+    }
+}
+
+TEST(TimestampRingTestGroup, CountersWrapAround)
+{
+    timestamp_event_t event;
+
+    // counters about to overflow
+    ring._head = ring._tail = UINT32_MAX - 1;
+
+    CHECK_TRUE(timestamp_ring_push(&ring, 0, 1));
+    CHECK_TRUE(timestamp_ring_push(&ring, 0, 2));
+    CHECK_TRUE(timestamp_ring_push(&ring, 0, 3));
+
+    CHECK_TRUE(timestamp_ring_pop(&ring, &event));
+    CHECK_EQUAL(1, event.time);
+    CHECK_TRUE(timestamp_ring_pop(&ring, &event));
+    CHECK_EQUAL(2, event.time);
+    CHECK_TRUE(timestamp_ring_pop(&ring, &event));
+    CHECK_EQUAL(3, event.time);
+    CHECK_FALSE(timestamp_ring_pop(&ring, &event));
+}
@@ -0,0 +1,101 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../src/triple_buffer.h"
+}
+
+typedef struct {
+    float x;
+    float y;
+} value_t;
+
+
+TEST_GROUP(TripleBufferTestGroup)
+{
+    triple_buffer_t buffer;
+    value_t storage[3];
+
+    void setup(void)
+    {
+        memset(storage, 0xff, sizeof(storage));
+        triple_buffer_init(&buffer, storage, sizeof(value_t));
+    }
+
+    void publish(float x, float y)
+    {
+        value_t *value = (value_t *)triple_buffer_write_buffer(&buffer);
+        value->x = x;
+        value->y = y;
+        triple_buffer_publish(&buffer);
+    }
+
+    const value_t *read(void)
+    {
+        return (const value_t *)triple_buffer_read(&buffer);
+    }
+};
+
+TEST(TripleBufferTestGroup, ReadsZerosBeforeFirstPublication)
+{
+    CHECK_FALSE(triple_buffer_update(&buffer));
+    CHECK_EQUAL(0.0f, read()->x);
+    CHECK_EQUAL(0.0f, read()->y);
+}
+
+TEST(TripleBufferTestGroup, ReadsPublishedValue)
+{
+    publish(1.0f, 2.0f);
+
+    CHECK_TRUE(triple_buffer_update(&buffer));
+    CHECK_EQUAL(1.0f, read()->x);
+    CHECK_EQUAL(2.0f, read()->y);
+}
+
+TEST(TripleBufferTestGroup, ValueIsOnlyFreshOnce)
+{
+    publish(1.0f, 2.0f);
+
+    CHECK_TRUE(triple_buffer_update(&buffer));
+    CHECK_FALSE(triple_buffer_update(&buffer));
+    CHECK_EQUAL(1.0f, read()->x);
+}
+
+TEST(TripleBufferTestGroup, ReadsLatestOfSeveralPublications)
+{
+    publish(1.0f, 2.0f);
+    publish(3.0f, 4.0f);
+    publish(5.0f, 6.0f);
+
+    CHECK_TRUE(triple_buffer_update(&buffer));
+    CHECK_EQUAL(5.0f, read()->x);
+    CHECK_EQUAL(6.0f, read()->y);
+}
+
+TEST(TripleBufferTestGroup, WriterNeverTouchesReadValue)
+{
+    publish(1.0f, 2.0f);
+    triple_buffer_update(&buffer);
+    const value_t *value = read();
+
+    int i;
+    for(i = 0; i < 5; i++){
+        POINTERS_EQUAL(value, read());
+        CHECK(triple_buffer_write_buffer(&buffer) != value);
+        publish(10.0f + i, 20.0f + i);
+    }
+
+    CHECK_EQUAL(1.0f, value->x);
+    CHECK_EQUAL(2.0f, value->y);
+
+    CHECK_TRUE(triple_buffer_update(&buffer));
+    CHECK_EQUAL(14.0f, read()->x);
+}
+
+TEST(TripleBufferTestGroup, WriteBufferIsStableUntilPublished)
+{
+    void *write_buffer = triple_buffer_write_buffer(&buffer);
+
+    triple_buffer_update(&buffer);
+
+    POINTERS_EQUAL(write_buffer, triple_buffer_write_buffer(&buffer));
+}
@@ -4,6 +4,7 @@ import pygame
 import sys
 import math
 import serial
+import struct
 
 import beaconwrapper as bw
 
@@ -26,10 +27,85 @@ PURPLE = (255, 0, 255)
 
 SER = serial.Serial('/dev/ttyACM0', 19200)
 
+ROBOT_COLORS = [RED, BLUE]
+
+# telemetry frames, see src/telemetry.h
+TELEMETRY_ROBOT_STATE = 1
+TELEMETRY_FLAG_FIX = 1 << 0
+TELEMETRY_FLAG_LOST = 1 << 1
+TELEMETRY_FLAG_TX_DROPPED = 1 << 2
+ROBOT_STATE = struct.Struct('<BBBIfffff')
+TELEMETRY_EDGE_TRACE = 2
+EDGE_TRACE_MAGIC = b'BTR1'
+
+def crc16(data):
+    "CRC-16/CCITT-FALSE"
+    crc = 0xffff
+    for byte in bytearray(data):
+        crc ^= byte << 8
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xffff
+            else:
+                crc = (crc << 1) & 0xffff
+    return crc
+
+def cobs_decode(data):
+    "decode a COBS block without its delimiter, None if it is invalid"
+    data = bytearray(data)
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xff and i < len(data):
+            out.append(0)
+    return out
+
+def read_frame():
+    "next valid telemetry payload, frames with a bad CRC are skipped"
+    while True:
+        frame = bytearray()
+        byte = SER.read(1)
+        while byte != b'\x00':
+            frame += byte
+            byte = SER.read(1)
+        payload = cobs_decode(frame)
+        if payload is None or len(payload) < 3:
+            continue
+        crc = payload[-2] | (payload[-1] << 8)
+        if crc16(payload[:-2]) == crc:
+            return payload[:-2]
+
 def get_state():
-    line = SER.readline()
-    state_arr = [float(i) for i in line.split(' ')]
-    return (state_arr[0], state_arr[1], state_arr[2], state_arr[3], state_arr[4])
+    "next robot state frame: robot, flags, time [us], (x, y, var_x, var_y, cov_xy)"
+    while True:
+        payload = read_frame()
+        if payload[0] == TELEMETRY_ROBOT_STATE and len(payload) == ROBOT_STATE.size:
+            (_, robot, flags, time, pos_x, pos_y, var_x, var_y, cov_xy) = \
+                ROBOT_STATE.unpack(bytes(payload))
+            return (robot, flags, time, (pos_x, pos_y, var_x, var_y, cov_xy))
+
+def record_trace(path):
+    "writes the edge trace of the board to path until Ctrl-C, see src/edge_trace.h"
+    SER.write(b'trace 1\n')
+    nb_bytes = 0
+    with open(path, 'wb') as trace:
+        trace.write(EDGE_TRACE_MAGIC)
+        try:
+            while True:
+                payload = read_frame()
+                if payload[0] == TELEMETRY_EDGE_TRACE:
+                    trace.write(bytes(payload[1:]))
+                    nb_bytes += len(payload) - 1
+        except KeyboardInterrupt:
+            pass
+    SER.write(b'trace 0\n')
+    print("%d bytes of records written to %s" % (nb_bytes, path))
 
 def draw_state(state, color):
     "draw a position and the covariance around it"
@@ -73,6 +149,7 @@ def main():
     "main..."
 
     paused = False
+    states = {}
 
     while True:
         for event in pygame.event.get():
@@ -86,12 +163,17 @@ def main():
         if not paused:
             SCREEN.fill(BLACK)
 
-            state = get_state()
+            (robot, flags, _, state) = get_state()
+            states[robot] = state
 
-            draw_state(state, RED)
+            for robot, state in states.items():
+                draw_state(state, ROBOT_COLORS[robot % len(ROBOT_COLORS)])
 
             pygame.display.update()
 
 if __name__ == "__main__":
-    main()
+    if len(sys.argv) == 3 and sys.argv[1] == '--trace':
+        record_trace(sys.argv[2])
+    else:
+        main()
 